@@ -24,6 +24,7 @@
 /* Include standard header file.                                            */
 /* ************************************************************************ */
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,8 +32,17 @@
 #include <inttypes.h>
 #include <math.h>
 #include <malloc.h>
+#include <pthread.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
 
 /* ************* */
 /* Some defines. */
@@ -45,19 +55,84 @@
 #define MAX_INTERLINES    10240
 #define MAX_ITERATION     200000
 #define MAX_THREADS       1024
+#define MAX_TILE_DEPTH    64
+#define MAX_TILE_WIDTH    (MAX_INTERLINES * 8 + 8)
+#define TILE_ROWS         8
+#define TILE_CACHE        (1 << 20)
+#define CACHE_LINE        64
+#define OOC_CHUNK         (1 << 22)
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI       2
+#define METH_RED_BLACK    3
+#define METH_SOR          4
+#define METH_MULTIGRID    5
+#define METH_CG           6
 #define FUNC_F0           1
 #define FUNC_FPISIN       2
 #define TERM_PREC         1
 #define TERM_ITER         2
+#define SOR_OPTIMAL       1
+#define SOR_ADAPTIVE      2
+#define SOR_FIXED         3
+#define SOR_ADAPT_STEPS   32
+#define MG_V_CYCLE        1
+#define MG_W_CYCLE        2
+#define MG_FULL           3
+#define MG_MAX_LEVELS     32
+#define MG_PRE_SMOOTH     2
+#define MG_POST_SMOOTH    2
+#define MG_JACOBI_DAMPING 0.8
+#define MG_COARSE_REDUCTION 1e-3
+#define MG_STALL_CYCLES   10
+#define PRECOND_JACOBI    1
+#define PRECOND_SSOR      2
+#define PRECOND_MULTIGRID 3
+#define RHS_NONE          0
+#define RHS_RECURRENCE    1
+#define RHS_VECTORS       2
+#define RHS_PLANE         3
+#define RHS_BUDGET        2048 /* KiB, holds the vectors up to MAX_INTERLINES */
+#define MAX_RHS_BUDGET    (UINT64_C(1) << 30)
+#define SIMD_SCALAR       0
+#define SIMD_SSE2         1
+#define SIMD_AVX2         2
+#define SIMD_AVX512       3
+#define MIXED_REDUCTION   1e-4
+#define CHECK_EVERY       0
+#define CHECK_ADAPTIVE    1
+#define CHECK_MAX_DISTANCE 64
+#define CHECK_SAFETY      0.5
+#define STALL_ITERATIONS  1000
+#define MAX_CHECKPOINT    86400
+#define CHECKPOINT_FILE   "partdiff.checkpoint"
+#define CHECKPOINT_MAGIC  "partdiff"
+
+/* matrix entries, -D FLOAT halves the memory traffic; sums stay double */
+#ifdef FLOAT
+typedef float real;
+#define MIN_PRECISION     1e-6
+#else
+typedef double real;
+#define MIN_PRECISION     1e-20
+#endif
 
 struct calculation_arguments
 {
 	uint64_t N;            /* number of spaces between lines (lines=N+1) */
+	uint64_t ld;           /* leading dimension, reals per padded matrix row */
 	uint64_t num_matrices; /* number of matrices */
 	double   h;            /* length of a space between two lines */
-	double*  M;            /* two matrices with real values */
+	real*    M;            /* two matrices with real values */
+	int      ooc_fd;       /* file behind M out of core, -1 in memory */
+	uint64_t ooc_size;     /* length of the file in bytes */
+	uint64_t ooc_chunk;    /* rows read ahead or released at once */
+	uint64_t rhs_mode;     /* how the right-hand side is provided */
+	double   rhs_sin;      /* sin(pi * h), start of the recurrence */
+	double   rhs_cos;      /* 2 * cos(pi * h), factor of the recurrence */
+	double*  rhs_row;      /* row factors 2 * pi^2 * h^2 * sin(pi * h * i) / 4 */
+	double*  rhs_col;      /* column factors sin(pi * h * j) */
+	double*  rhs_plane;    /* complete right-hand side */
+	double*  rhs_buffer;   /* two rows of the right-hand side */
 };
 
 struct calculation_results
@@ -65,6 +140,16 @@ struct calculation_results
 	uint64_t m;
 	uint64_t stat_iteration; /* number of current iteration */
 	double   stat_precision; /* actual precision of all slaves in iteration */
+	double   stat_omega;     /* relaxation factor of the last iteration (SOR) */
+	uint64_t stat_levels;    /* number of levels (multigrid) */
+	double   stat_residual;  /* euclidean norm of the residual (CG) */
+	uint64_t stat_corrections; /* number of defect corrections (mixed precision) */
+	uint64_t stat_finish;      /* double Gauß-Seidel iterations after them (mixed precision) */
+	uint64_t stat_checks;    /* number of convergence checks */
+	uint64_t stat_stalled;   /* iterations without a smaller residuum, if that stopped the run */
+	uint64_t stat_kernel;    /* whether the Jacobi kernel of options->simd did the sweeps */
+	uint64_t stat_warm_levels;     /* number of coarser grids solved first */
+	uint64_t stat_warm_iterations; /* number of iterations on them */
 };
 
 struct options
@@ -76,8 +161,77 @@ struct options
 	uint64_t termination;    /* termination condition */
 	uint64_t term_iteration; /* terminate if iteration number reached */
 	double   term_precision; /* terminate if precision reached */
+	uint64_t tile_depth;     /* number of sweeps per wavefront pass */
+	uint64_t tile_width;     /* columns per tile of a sweep, 0: from the cache */
+	uint64_t sor_mode;       /* how the SOR relaxation factor is chosen */
+	double   sor_omega;      /* fixed SOR relaxation factor */
+	uint64_t mg_cycle;       /* multigrid cycle type */
+	uint64_t mg_smoother;    /* multigrid smoother (Gauss Seidel or Jacobi) */
+	uint64_t cg_precond;     /* CG preconditioner */
+	uint64_t rhs_budget;     /* memory for the right-hand side in KiB */
+	uint64_t simd;           /* instruction set of the Jacobi kernel */
+	uint64_t mixed;          /* fp32 sweeps per defect correction, 0: off */
+	uint64_t check;          /* when the convergence is checked */
+	uint64_t ooc;            /* matrices in a file instead of memory */
+	uint64_t checkpoint;     /* seconds between checkpoints, 0: off */
+	uint64_t restart;        /* continue from the last checkpoint */
+	uint64_t warm_start;     /* start from the solution with half the interlines */
+};
+
+struct mg_level
+{
+	uint64_t N;  /* number of spaces between lines on this level */
+	uint64_t ld; /* leading dimension, reals per padded row */
+	double   h;  /* length of a space between two lines */
+	real*    u;  /* solution (finest level) or correction */
+	real*    f;  /* right-hand side */
+	real*    r;  /* residual, also used as scratch by the Jacobi smoother */
+};
+
+struct convergence_check
+{
+	uint64_t adaptive; /* check only as often as the contraction requires */
+	double   rho;      /* spectral radius estimate of the method */
+	double   residuum; /* maximum residuum at the last check, 0 before */
+	uint64_t distance; /* iterations between the last and the next check */
+	uint64_t checks;   /* number of checks so far */
+	double   best;     /* smallest residuum of all checks */
+	uint64_t stalled;  /* iterations since the residuum last reached a new minimum */
+};
+
+struct checkpoint_header
+{
+	char     magic[8];       /* CHECKPOINT_MAGIC */
+	uint64_t real_size;      /* bytes per matrix entry */
+	uint64_t method;         /* parameters a restart has to match */
+	uint64_t interlines;
+	uint64_t inf_func;
+	uint64_t termination;
+	uint64_t stat_iteration; /* iterations done so far */
+	double   stat_precision; /* precision of the last checked iteration */
+	double   stat_omega;     /* relaxation factor (SOR) */
+	uint64_t m;              /* matrix with the newest values */
+	uint64_t left;           /* iterations until the next convergence check */
+	struct convergence_check check; /* state of the convergence checks */
 };
 
+struct checkpoint
+{
+	uint64_t       interval;  /* seconds between checkpoints, 0: off */
+	char const*    path;      /* checkpoint file */
+	char*          temp;      /* file a checkpoint is written to first */
+	struct timeval last;      /* time of the last checkpoint */
+	uint64_t       restarted; /* iterations done before a restart */
+	real*          buffer;    /* snapshot of the matrix, rows without padding */
+	size_t         size;      /* bytes in the snapshot */
+	pthread_t      thread;    /* background writer */
+	int            running;   /* the writer has been started and not joined */
+	int            done;      /* the writer has finished */
+	struct checkpoint_header header; /* state written with the snapshot */
+};
+
+typedef double (*jacobi_kernel)(real const*, real*, double const*, double const*, int, int, int, int);
+
 /* ************************************************************************ */
 /* Global variables                                                         */
 /* ************************************************************************ */
@@ -86,15 +240,24 @@ struct options
 struct timeval start_time; /* time when program started */
 struct timeval comp_time;  /* time when calculation completed */
 
+/* periodic checkpoints of the calculation */
+struct checkpoint checkpoint;
+
 static void
 usage(char* name)
 {
-	printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter]\n", name);
+	printf("Usage: %s [--restart] [num] [method] [lines] [func] [term] [prec/iter]\n", name);
 	printf("\n");
+	printf("  - --restart: continue from the last checkpoint, which has to be written\n");
+	printf("               with the same method, lines, func and term\n");
 	printf("  - num:       number of threads (1 .. %d)\n", MAX_THREADS);
-	printf("  - method:    calculation method (1 .. 2)\n");
+	printf("  - method:    calculation method (1 .. 6)\n");
 	printf("                 %1d: Gauß-Seidel\n", METH_GAUSS_SEIDEL);
 	printf("                 %1d: Jacobi\n", METH_JACOBI);
+	printf("                 %1d: Red-Black Gauß-Seidel\n", METH_RED_BLACK);
+	printf("                 %1d: SOR\n", METH_SOR);
+	printf("                 %1d: Multigrid\n", METH_MULTIGRID);
+	printf("                 %1d: Preconditioned CG\n", METH_CG);
 	printf("  - lines:     number of interlines (0 .. %d)\n", MAX_INTERLINES);
 	printf("                 matrixsize = (interlines * 8) + 9\n");
 	printf("  - func:      interference function (1 .. 2)\n");
@@ -104,17 +267,128 @@ usage(char* name)
 	printf("                 %1d: sufficient precision\n", TERM_PREC);
 	printf("                 %1d: number of iterations\n", TERM_ITER);
 	printf("  - prec/iter: depending on term:\n");
-	printf("                 precision:  1e-4 .. 1e-20\n");
+	printf("                 precision:  1e-4 .. %g\n", MIN_PRECISION);
 	printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
 	printf("\n");
+	printf("Environment:\n");
+	printf("  - PARTDIFF_TILE_DEPTH: sweeps per wavefront pass (1 .. %d, default 1)\n", MAX_TILE_DEPTH);
+	printf("                 with precision termination the check happens once per pass\n");
+	printf("                 only used by Gauß-Seidel and Jacobi\n");
+	printf("  - PARTDIFF_TILE_WIDTH: columns per tile of a sweep (0 .. %d, default 0)\n", MAX_TILE_WIDTH);
+	printf("                 0: %d rows of a tile fill half of the L2 cache\n", TILE_ROWS);
+	printf("                 whole rows if the right-hand side is a recurrence\n");
+	printf("                 only used by Gauß-Seidel and Jacobi\n");
+	printf("  - PARTDIFF_SOR_OMEGA: relaxation factor of SOR (default optimal)\n");
+	printf("                 optimal:  2 / (1 + sin(pi / N)) for the 5-point stencil\n");
+	printf("                 adaptive: estimated from the residuum decay during the run\n");
+	printf("                 0 .. 2:   fixed value\n");
+	printf("  - PARTDIFF_MG_CYCLE: multigrid cycle (default %d)\n", MG_V_CYCLE);
+	printf("                 %1d: V cycle\n", MG_V_CYCLE);
+	printf("                 %1d: W cycle\n", MG_W_CYCLE);
+	printf("                 %1d: full multigrid start, then V cycles\n", MG_FULL);
+	printf("  - PARTDIFF_MG_SMOOTHER: multigrid smoother (default %d)\n", METH_GAUSS_SEIDEL);
+	printf("                 %1d: Gauß-Seidel\n", METH_GAUSS_SEIDEL);
+	printf("                 %1d: Jacobi (damped)\n", METH_JACOBI);
+	printf("  - PARTDIFF_CG_PRECOND: CG preconditioner (default %d)\n", PRECOND_JACOBI);
+	printf("                 %1d: Jacobi\n", PRECOND_JACOBI);
+	printf("                 %1d: SSOR, uses PARTDIFF_SOR_OMEGA if it is a number\n", PRECOND_SSOR);
+	printf("                 %1d: one multigrid V cycle\n", PRECOND_MULTIGRID);
+	printf("  - PARTDIFF_RHS_BUDGET: memory for the right-hand side in KiB (default %d)\n", RHS_BUDGET);
+	printf("                 the whole plane if it fits, otherwise row and column vectors,\n");
+	printf("                 the default always holds them, a smaller budget generates\n");
+	printf("                 every row by a less exact recurrence\n");
+	printf("  - PARTDIFF_SIMD: highest instruction set of the Jacobi kernel (default %d)\n", SIMD_AVX512);
+	printf("                 %1d: scalar, %1d: SSE2, %1d: AVX2, %1d: AVX-512, limited by the CPU\n", SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512);
+	printf("  - PARTDIFF_CHECK: convergence checks with precision termination (default %d)\n", CHECK_EVERY);
+	printf("                 %1d: every iteration\n", CHECK_EVERY);
+	printf("                 %1d: adaptive, estimated from the residuum contraction,\n", CHECK_ADAPTIVE);
+	printf("                    at most %d iterations apart\n", CHECK_MAX_DISTANCE);
+#ifndef FLOAT
+	printf("  - PARTDIFF_MIXED: mixed precision, at most this many float sweeps per\n");
+	printf("                 defect correction in double (0 .. %d, default 0: off)\n", MAX_ITERATION);
+	printf("                 only used by Gauß-Seidel and Jacobi, the float sweeps use\n");
+	printf("                 the chosen method, double Gauß-Seidel sweeps finish once\n");
+	printf("                 the corrections no longer lower the defect\n");
+#endif
+	printf("  - PARTDIFF_CHECKPOINT: seconds between checkpoints (0 .. %d, default 0: off)\n", MAX_CHECKPOINT);
+	printf("                 written in the background to $PARTDIFF_CHECKPOINT_FILE\n");
+	printf("                 (default %s), only used by Gauß-Seidel, Jacobi,\n", CHECKPOINT_FILE);
+	printf("                 Red-Black Gauß-Seidel and SOR\n");
+	printf("  - PARTDIFF_OOC: matrices in a file in $TMPDIR instead of memory (0 .. 1, default 0)\n");
+	printf("                 Gauß-Seidel and Jacobi stream the rows through a window with\n");
+	printf("                 read-ahead and write-behind, PARTDIFF_TILE_DEPTH sweeps per pass,\n");
+	printf("                 all other methods leave the paging to the kernel\n");
+	printf("  - PARTDIFF_WARM_START: start from the interpolated solution for half the\n");
+	printf("                 interlines, found the same way down to 0 (0 .. 1, default 0),\n");
+	printf("                 not with --restart\n");
+	printf("\n");
 	printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
 
+/* ************************************************************************ */
+/* askEnvParam: reads an optional tuning parameter from the environment     */
+/* ************************************************************************ */
+static uint64_t
+askEnvParam(char* name, char const* variable, uint64_t min, uint64_t max, uint64_t fallback)
+{
+	char const* value = getenv(variable);
+	uint64_t    param;
+
+	if (value == NULL)
+	{
+		return fallback;
+	}
+
+	if (sscanf(value, "%" SCNu64, &param) != 1 || !(param >= min && param <= max))
+	{
+		usage(name);
+		exit(1);
+	}
+
+	return param;
+}
+
+/* ************************************************************************ */
+/* cpuSimdLevel: returns the highest instruction set supported by the CPU   */
+/* ************************************************************************ */
+static uint64_t
+cpuSimdLevel(void)
+{
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return SIMD_AVX512;
+	}
+	else if (__builtin_cpu_supports("avx2"))
+	{
+		return SIMD_AVX2;
+	}
+	else if (__builtin_cpu_supports("sse2"))
+	{
+		return SIMD_SSE2;
+	}
+#endif
+
+	return SIMD_SCALAR;
+}
+
 static void
 askParams(struct options* options, int argc, char** argv)
 {
 	int ret;
 
+	options->restart = argc > 1 && strcmp(argv[1], "--restart") == 0;
+
+	/* the remaining parameters are the usual ones */
+	if (options->restart)
+	{
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+
 	if (argc < 7 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "-?") == 0)
 	{
 		usage(argv[0]);
@@ -131,7 +405,7 @@ askParams(struct options* options, int argc, char** argv)
 
 	ret = sscanf(argv[2], "%" SCNu64, &(options->method));
 
-	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI))
+	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI || options->method == METH_RED_BLACK || options->method == METH_SOR || options->method == METH_MULTIGRID || options->method == METH_CG))
 	{
 		usage(argv[0]);
 		exit(1);
@@ -167,7 +441,7 @@ askParams(struct options* options, int argc, char** argv)
 
 		options->term_iteration = MAX_ITERATION;
 
-		if (ret != 1 || !(options->term_precision >= 1e-20 && options->term_precision <= 1e-4))
+		if (ret != 1 || !(options->term_precision >= MIN_PRECISION && options->term_precision <= 1e-4))
 		{
 			usage(argv[0]);
 			exit(1);
@@ -185,6 +459,70 @@ askParams(struct options* options, int argc, char** argv)
 			exit(1);
 		}
 	}
+
+	options->tile_depth  = askEnvParam(argv[0], "PARTDIFF_TILE_DEPTH", 1, MAX_TILE_DEPTH, 1);
+	options->tile_width  = askEnvParam(argv[0], "PARTDIFF_TILE_WIDTH", 0, MAX_TILE_WIDTH, 0);
+	options->mg_cycle    = askEnvParam(argv[0], "PARTDIFF_MG_CYCLE", MG_V_CYCLE, MG_FULL, MG_V_CYCLE);
+	options->mg_smoother = askEnvParam(argv[0], "PARTDIFF_MG_SMOOTHER", METH_GAUSS_SEIDEL, METH_JACOBI, METH_GAUSS_SEIDEL);
+	options->cg_precond  = askEnvParam(argv[0], "PARTDIFF_CG_PRECOND", PRECOND_JACOBI, PRECOND_MULTIGRID, PRECOND_JACOBI);
+	options->rhs_budget  = askEnvParam(argv[0], "PARTDIFF_RHS_BUDGET", 0, MAX_RHS_BUDGET, RHS_BUDGET);
+	options->simd        = askEnvParam(argv[0], "PARTDIFF_SIMD", SIMD_SCALAR, SIMD_AVX512, SIMD_AVX512);
+	options->check       = askEnvParam(argv[0], "PARTDIFF_CHECK", CHECK_EVERY, CHECK_ADAPTIVE, CHECK_EVERY);
+	options->ooc         = askEnvParam(argv[0], "PARTDIFF_OOC", 0, 1, 0);
+	options->checkpoint  = askEnvParam(argv[0], "PARTDIFF_CHECKPOINT", 0, MAX_CHECKPOINT, 0);
+	options->warm_start  = askEnvParam(argv[0], "PARTDIFF_WARM_START", 0, 1, 0);
+#ifdef FLOAT
+	/* the matrix itself is float, there is nothing to refine */
+	options->mixed       = askEnvParam(argv[0], "PARTDIFF_MIXED", 0, 0, 0);
+#else
+	options->mixed       = askEnvParam(argv[0], "PARTDIFF_MIXED", 0, MAX_ITERATION, 0);
+#endif
+
+	if (options->simd > cpuSimdLevel())
+	{
+		options->simd = cpuSimdLevel();
+	}
+
+	char const* omega = getenv("PARTDIFF_SOR_OMEGA");
+
+	options->sor_mode  = SOR_OPTIMAL;
+	options->sor_omega = 0;
+
+	if (omega != NULL && strcmp(omega, "adaptive") == 0)
+	{
+		options->sor_mode = SOR_ADAPTIVE;
+	}
+	else if (omega != NULL && strcmp(omega, "optimal") != 0)
+	{
+		ret = sscanf(omega, "%lf", &(options->sor_omega));
+
+		options->sor_mode = SOR_FIXED;
+
+		if (ret != 1 || !(options->sor_omega > 0 && options->sor_omega < 2))
+		{
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* rowLength: returns the leading dimension of a matrix with N + 1 columns  */
+/*            of size bytes each                                            */
+/*                                                                          */
+/* Rows are padded to an odd number of cache lines. Every row then starts   */
+/* at a cache line, so no stencil load is split, and consecutive rows walk  */
+/* through all cache sets instead of aliasing at power-of-two strides.      */
+/* ************************************************************************ */
+static uint64_t
+rowLength(uint64_t N, size_t size)
+{
+	uint64_t const line  = CACHE_LINE / size;
+	uint64_t       lines = (N + line) / line;
+
+	lines += (lines % 2 == 0) ? 1 : 0;
+
+	return lines * line;
 }
 
 /* ************************************************************************ */
@@ -194,12 +532,23 @@ static void
 initVariables(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
 {
 	arguments->N            = (options->interlines * 8) + 9 - 1;
+	arguments->ld           = rowLength(arguments->N, sizeof(real));
 	arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
 	arguments->h            = 1.0 / arguments->N;
 
 	results->m              = 0;
 	results->stat_iteration = 0;
 	results->stat_precision = 0;
+	results->stat_omega     = 0;
+	results->stat_levels    = 0;
+	results->stat_residual  = 0;
+	results->stat_corrections = 0;
+	results->stat_finish      = 0;
+	results->stat_checks      = 0;
+	results->stat_stalled     = 0;
+	results->stat_kernel      = 0;
+	results->stat_warm_levels     = 0;
+	results->stat_warm_iterations = 0;
 }
 
 /* ************************************************************************ */
@@ -208,19 +557,33 @@ initVariables(struct calculation_arguments* arguments, struct calculation_result
 static void
 freeMatrices(struct calculation_arguments* arguments)
 {
-	free(arguments->M);
+	if (arguments->ooc_fd >= 0)
+	{
+		munmap(arguments->M, arguments->ooc_size);
+		close(arguments->ooc_fd);
+	}
+	else
+	{
+		free(arguments->M);
+	}
+
+	free(arguments->rhs_row);
+	free(arguments->rhs_col);
+	free(arguments->rhs_plane);
+	free(arguments->rhs_buffer);
 }
 
 /* ************************************************************************ */
 /* allocateMemory ()                                                        */
-/* allocates memory and quits if there was a memory allocation problem      */
+/* allocates memory aligned to a cache line and quits if there was a memory */
+/* allocation problem                                                       */
 /* ************************************************************************ */
 static void*
 allocateMemory(size_t size)
 {
 	void* p;
 
-	if ((p = malloc(size)) == NULL)
+	if (posix_memalign(&p, CACHE_LINE, size) != 0)
 	{
 		printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", size);
 		exit(1);
@@ -229,15 +592,129 @@ allocateMemory(size_t size)
 	return p;
 }
 
+/* ************************************************************************ */
+/* allocateFile: maps a new file of size bytes in $TMPDIR, which reads as   */
+/*               zeros and is removed again when the program exits          */
+/* ************************************************************************ */
+static void*
+allocateFile(struct calculation_arguments* arguments, size_t size)
+{
+	char        path[4096];
+	char const* dir = getenv("TMPDIR");
+	void*       p;
+
+	snprintf(path, sizeof(path), "%s/partdiff-XXXXXX", (dir != NULL) ? dir : "/tmp");
+
+	if ((arguments->ooc_fd = mkstemp(path)) < 0)
+	{
+		printf("Dateiprobleme! (%s kann nicht angelegt werden)\n", path);
+		exit(1);
+	}
+
+	unlink(path);
+
+	if (ftruncate(arguments->ooc_fd, size) != 0 ||
+	    (p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, arguments->ooc_fd, 0)) == MAP_FAILED)
+	{
+		printf("Dateiprobleme! (%" PRIu64 " Bytes in %s angefordert)\n", size, path);
+		exit(1);
+	}
+
+	arguments->ooc_size = size;
+
+	return p;
+}
+
 /* ************************************************************************ */
 /* allocateMatrices: allocates memory for matrices                          */
 /* ************************************************************************ */
 static void
-allocateMatrices(struct calculation_arguments* arguments)
+allocateMatrices(struct calculation_arguments* arguments, struct options const* options)
 {
-	uint64_t const N = arguments->N;
+	uint64_t const N    = arguments->N;
+	uint64_t const size = arguments->num_matrices * (N + 1) * arguments->ld * sizeof(real);
+
+	arguments->ooc_fd    = -1;
+	arguments->ooc_size  = 0;
+	arguments->ooc_chunk = OOC_CHUNK / (arguments->ld * sizeof(real));
+	arguments->ooc_chunk = (arguments->ooc_chunk > 0) ? arguments->ooc_chunk : 1;
+
+	if (options->ooc)
+	{
+		arguments->M = allocateFile(arguments, size);
+	}
+	else
+	{
+		arguments->M = allocateMemory(size);
+	}
+}
+
+/* ************************************************************************ */
+/* oocRows: byte range of the rows first .. last - 1 of matrix g, cut to    */
+/*          whole pages inside of it (inner) or widened to them (outer)     */
+/* ************************************************************************ */
+static int
+oocRows(struct calculation_arguments const* arguments, uint64_t g, int64_t first, int64_t last, int inner, uint64_t* from, uint64_t* to)
+{
+	uint64_t const page = sysconf(_SC_PAGESIZE);
+	uint64_t const row  = arguments->ld * sizeof(real);
+	int64_t const  rows = arguments->N + 1;
+
+	first = (first > 0) ? first : 0;
+	last  = (last < rows) ? last : rows;
+
+	if (first >= last)
+	{
+		return 0;
+	}
+
+	*from = (g * rows + first) * row;
+	*to   = (g * rows + last) * row;
+
+	*from = inner ? (*from + page - 1) / page * page : *from / page * page;
+	*to   = inner ? *to / page * page : (*to + page - 1) / page * page;
+
+	return *from < *to;
+}
+
+/* ************************************************************************ */
+/* oocPrefetch: starts reading the rows first .. last - 1 of all matrices   */
+/* ************************************************************************ */
+static void
+oocPrefetch(struct calculation_arguments const* arguments, int64_t first, int64_t last)
+{
+	uint64_t g, from, to; /* matrix and byte range */
+
+	for (g = 0; g < arguments->num_matrices; g++)
+	{
+		if (oocRows(arguments, g, first, last, 0, &from, &to))
+		{
+			madvise((char*)arguments->M + from, to - from, MADV_WILLNEED);
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* oocRelease: drops the rows first .. last - 1 of all matrices from the    */
+/*             address space and the page cache                             */
+/*                                                                          */
+/* Dirty pages stay in the page cache, POSIX_FADV_DONTNEED only starts      */
+/* writing them back. Releasing every row a second time a chunk later       */
+/* drops them once they are clean.                                          */
+/* ************************************************************************ */
+static void
+oocRelease(struct calculation_arguments const* arguments, int64_t first, int64_t last)
+{
+	uint64_t g, from, to; /* matrix and byte range */
 
-	arguments->M = allocateMemory(arguments->num_matrices * (N + 1) * (N + 1) * sizeof(double));
+	for (g = 0; g < arguments->num_matrices; g++)
+	{
+		if (oocRows(arguments, g, first, last, 1, &from, &to))
+		{
+			madvise((char*)arguments->M + from, to - from, MADV_DONTNEED);
+			posix_fadvise(arguments->ooc_fd, from, to - from, POSIX_FADV_DONTNEED);
+		}
+	}
 }
 
 /* ************************************************************************ */
@@ -248,15 +725,16 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 {
 	uint64_t g, i, j; /* local variables for loops */
 
-	uint64_t const N = arguments->N;
-	double const   h = arguments->h;
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+	double const   h  = arguments->h;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
-	/* initialize matrix/matrices with zeros */
-	for (g = 0; g < arguments->num_matrices; g++)
+	/* initialize matrix/matrices with zeros, a new file already reads as zeros */
+	for (g = 0; g < arguments->num_matrices && arguments->ooc_fd < 0; g++)
 	{
 		for (i = 0; i <= N; i++)
 		{
@@ -274,6 +752,11 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 		{
 			for (i = 0; i <= N; i++)
 			{
+				if (arguments->ooc_fd >= 0 && i % arguments->ooc_chunk == 0)
+				{
+					oocRelease(arguments, i - 2 * arguments->ooc_chunk, i);
+				}
+
 				Matrix[g][i][0] = 1.0 - (h * i);
 				Matrix[g][i][N] = h * i;
 				Matrix[g][0][i] = 1.0 - (h * i);
@@ -283,154 +766,2492 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 			Matrix[g][N][0] = 0.0;
 			Matrix[g][0][N] = 0.0;
 		}
-	}
-}
-
-/* ************************************************************************ */
-/* calculate_func: calculates the interference function                     */
-/* ************************************************************************ */
-static inline double
-calculate_func(struct calculation_arguments const* arguments, struct options const* options, int i, int j)
-{
-	double const h = arguments->h;
 
-	if (options->inf_func == FUNC_FPISIN)
-	{
-		return ((2 * M_PI * M_PI) * h * h * sin(M_PI * h * (double)i) * sin(M_PI * h * (double)j)) / 4;
-	}
-	else
-	{
-		return 0.0;
+		if (arguments->ooc_fd >= 0)
+		{
+			oocRelease(arguments, 0, N + 1);
+		}
 	}
 }
 
 /* ************************************************************************ */
-/* calculate: solves the equation                                           */
+/* initRhs: prepares the right-hand side within the memory budget           */
+/*                                                                          */
+/* The interference function is the product of a row and a column factor.   */
+/* If the whole plane fits into the budget it is precomputed, otherwise     */
+/* both factor vectors are kept and multiplied for every row. Without even  */
+/* those, every row is generated by sin((j + 1) x) = 2 cos(x) sin(j x) -    */
+/* sin((j - 1) x), which only costs one sin() per row.                      */
 /* ************************************************************************ */
 static void
-calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+initRhs(struct calculation_arguments* arguments, struct options const* options)
 {
-	int    i, j;        /* local variables for loops */
-	int    m1, m2;      /* used as indices for old and new matrices */
-	double star;        /* four times center value minus 4 neigh.b values */
-	double residuum;    /* residuum of current iteration */
-	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	uint64_t i, j; /* local variables for loops */
 
-	int const N = arguments->N;
+	uint64_t const N      = arguments->N;
+	double const   h      = arguments->h;
+	uint64_t const budget = options->rhs_budget * 1024;
 
-	int term_iteration = options->term_iteration;
+	arguments->rhs_mode   = RHS_NONE;
+	arguments->rhs_sin    = sin(M_PI * h);
+	arguments->rhs_cos    = 2 * cos(M_PI * h);
+	arguments->rhs_row    = NULL;
+	arguments->rhs_col    = NULL;
+	arguments->rhs_plane  = NULL;
+	arguments->rhs_buffer = allocateMemory(2 * (N + 1) * sizeof(double));
 
-	typedef double(*matrix)[N + 1][N + 1];
+	/* f(x,y) = 0 leaves the buffers at 0 */
+	memset(arguments->rhs_buffer, 0, 2 * (N + 1) * sizeof(double));
 
-	matrix Matrix = (matrix)arguments->M;
+	if (options->inf_func != FUNC_FPISIN)
+	{
+		return;
+	}
 
-	/* initialize m1 and m2 depending on algorithm */
-	if (options->method == METH_JACOBI)
+	if ((N + 1) * (N + 1) * sizeof(double) <= budget)
 	{
-		m1 = 0;
-		m2 = 1;
+		arguments->rhs_mode = RHS_PLANE;
 	}
-	else
+	else if (2 * (N + 1) * sizeof(double) <= budget)
 	{
-		m1 = 0;
-		m2 = 0;
+		arguments->rhs_mode = RHS_VECTORS;
 	}
-	while (term_iteration > 0)
+	else
 	{
-		maxresiduum = 0;
-		/* over all rows */
-		for (i = 1; i < N; i++)
-		{
-			/* over all columns */
-			for (j = 1; j < N; j++)
-			{
-				star = (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
-
-				star += calculate_func(arguments, options, i, j);
-
-				residuum    = Matrix[m2][i][j] - star;
-				residuum    = fabs(residuum);
-				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+		arguments->rhs_mode = RHS_RECURRENCE;
+		return;
+	}
 
-				Matrix[m1][i][j] = star;
-			}
-		}
+	arguments->rhs_row = allocateMemory((N + 1) * sizeof(double));
+	arguments->rhs_col = allocateMemory((N + 1) * sizeof(double));
 
-		results->stat_iteration++;
-		results->stat_precision = maxresiduum;
+	for (i = 0; i <= N; i++)
+	{
+		arguments->rhs_row[i] = ((2 * M_PI * M_PI) * h * h * sin(M_PI * h * (double)i)) / 4;
+		arguments->rhs_col[i] = sin(M_PI * h * (double)i);
+	}
 
-		/* exchange m1 and m2 */
-		i  = m1;
-		m1 = m2;
-		m2 = i;
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		arguments->rhs_plane = allocateMemory((N + 1) * (N + 1) * sizeof(double));
 
-		/* check for stopping calculation depending on termination method */
-		if (options->termination == TERM_PREC)
+		for (i = 0; i <= N; i++)
 		{
-			if (maxresiduum < options->term_precision)
+			for (j = 0; j <= N; j++)
 			{
-				term_iteration = 0;
+				arguments->rhs_plane[i * (N + 1) + j] = arguments->rhs_row[i] * arguments->rhs_col[j];
 			}
 		}
-		else if (options->termination == TERM_ITER)
-		{
-			term_iteration--;
-		}
 	}
-
-	results->m = m2;
 }
 
 /* ************************************************************************ */
-/*  displayStatistics: displays some statistics about the calculation       */
+/* rhsLine: returns row i of the interference function, scaled by h^2 / 4   */
+/*          like the stencil; buffer holds N + 1 values if it is generated  */
 /* ************************************************************************ */
-static void
-displayStatistics(struct calculation_arguments const* arguments, struct calculation_results const* results, struct options const* options)
+static inline double const*
+rhsLine(struct calculation_arguments const* arguments, int i, double* buffer)
 {
-	int    N    = arguments->N;
-	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
+	int    j;  /* local variable for loop */
+	double fi; /* row factor */
 
-	printf("Berechnungszeit:    %f s\n", time);
-	printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) * arguments->num_matrices / 1024.0 / 1024.0);
-	printf("Berechnungsmethode: ");
+	int const N = arguments->N;
 
-	if (options->method == METH_GAUSS_SEIDEL)
+	if (arguments->rhs_mode == RHS_PLANE)
 	{
-		printf("Gauß-Seidel");
+		return arguments->rhs_plane + i * (N + 1);
 	}
-	else if (options->method == METH_JACOBI)
+	else if (arguments->rhs_mode == RHS_VECTORS)
 	{
-		printf("Jacobi");
-	}
-
-	printf("\n");
-	printf("Interlines:         %" PRIu64 "\n", options->interlines);
-	printf("Stoerfunktion:      ");
+		fi = arguments->rhs_row[i];
 
-	if (options->inf_func == FUNC_F0)
-	{
-		printf("f(x,y) = 0");
+		for (j = 0; j <= N; j++)
+		{
+			buffer[j] = fi * arguments->rhs_col[j];
+		}
 	}
-	else if (options->inf_func == FUNC_FPISIN)
+	else if (arguments->rhs_mode == RHS_RECURRENCE)
 	{
-		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+		fi = ((2 * M_PI * M_PI) * arguments->h * arguments->h * sin(M_PI * arguments->h * (double)i)) / 4;
+
+		buffer[0] = 0.0;
+		buffer[1] = fi * arguments->rhs_sin;
+
+		for (j = 1; j < N; j++)
+		{
+			buffer[j + 1] = arguments->rhs_cos * buffer[j] - buffer[j - 1];
+		}
 	}
 
-	printf("\n");
-	printf("Terminierung:       ");
+	return buffer;
+}
 
-	if (options->termination == TERM_PREC)
+/* ************************************************************************ */
+/* rhsTile: like rhsLine, but only the columns first .. last - 1 have to be */
+/*          valid, so a tile does not generate the whole row                */
+/* ************************************************************************ */
+static inline double const*
+rhsTile(struct calculation_arguments const* arguments, int i, int first, int last, double* buffer)
+{
+	int    j;  /* local variable for loop */
+	double fi; /* row factor */
+
+	if (arguments->rhs_mode != RHS_VECTORS)
 	{
-		printf("Hinreichende Genaugkeit");
+		return rhsLine(arguments, i, buffer);
 	}
-	else if (options->termination == TERM_ITER)
+
+	fi = arguments->rhs_row[i];
+
+	for (j = first; j < last; j++)
 	{
-		printf("Anzahl der Iterationen");
+		buffer[j] = fi * arguments->rhs_col[j];
+	}
+
+	return buffer;
+}
+
+/* ************************************************************************ */
+/* tileWidth: returns the number of columns per tile                        */
+/*                                                                          */
+/* A sweep runs over the matrix in tiles of full height. Each point only    */
+/* needs its four direct neighbours, so going tile by tile keeps the exact  */
+/* Gauß-Seidel update order. TILE_ROWS rows of a tile, counting matrix and  */
+/* right-hand side, have to stay in the L2 cache between two rows.          */
+/* ************************************************************************ */
+static int
+tileWidth(struct calculation_arguments const* arguments, struct options const* options)
+{
+	long cache = TILE_CACHE; /* size of the L2 cache in bytes */
+	int  width;              /* columns per tile */
+	int  tiles;              /* number of tiles */
+
+	int const N = arguments->N;
+
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	if (sysconf(_SC_LEVEL2_CACHE_SIZE) > 0)
+	{
+		cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	}
+#endif
+
+	width = options->tile_width;
+
+	if (width == 0)
+	{
+		/* whole cache lines of doubles */
+		width = (cache / 2 / (TILE_ROWS * sizeof(double))) & ~7;
+	}
+
+	/* the recurrence can only generate whole rows */
+	if (width <= 0 || width >= N - 1 || arguments->rhs_mode == RHS_RECURRENCE)
+	{
+		return N - 1;
+	}
+
+	if (options->tile_width == 0)
+	{
+		/* same number of tiles, but all of about the same width */
+		tiles = (N - 1 + width - 1) / width;
+		width = ((N - 1 + tiles - 1) / tiles + 7) & ~7;
+	}
+
+	return width;
+}
+
+/* ************************************************************************ */
+/* initCheck: prepares the convergence checks for a method whose residuum   */
+/*            contracts by about rho per iteration, the first check comes   */
+/*            after the first iteration                                     */
+/* ************************************************************************ */
+static void
+initCheck(struct convergence_check* check, struct options const* options, double rho)
+{
+	check->adaptive = options->check == CHECK_ADAPTIVE;
+	check->rho      = rho;
+	check->residuum = 0.0;
+	check->distance = 1;
+	check->checks   = 0;
+	check->best     = 0.0;
+	check->stalled  = 0;
+}
+
+/* ************************************************************************ */
+/* nextCheck: records the residuum of a check and returns the number of     */
+/*            iterations until the next one                                 */
+/*                                                                          */
+/* The contraction rate is measured between the last two checks and capped  */
+/* by rho, because it only slows down towards the spectral radius. The next */
+/* check comes after CHECK_SAFETY times the iterations the residuum still   */
+/* needs at that rate, so it rarely stops later than checking every time.   */
+/* ************************************************************************ */
+static uint64_t
+nextCheck(struct convergence_check* check, double maxresiduum, double term_precision)
+{
+	double rate = check->rho; /* residuum contraction per iteration */
+	double remaining;         /* iterations until the precision is reached */
+
+	if (check->residuum > 0.0 && maxresiduum < check->residuum)
+	{
+		double measured = pow(maxresiduum / check->residuum, 1.0 / check->distance);
+
+		rate = (measured < rate) ? measured : rate;
+	}
+
+	if (check->checks == 0 || maxresiduum < check->best)
+	{
+		check->best    = maxresiduum;
+		check->stalled = 0;
+	}
+	else
+	{
+		check->stalled += check->distance;
+	}
+
+	check->residuum = maxresiduum;
+	check->checks++;
+	check->distance = 1;
+
+	if (check->adaptive && rate > 0.0 && rate < 1.0 && maxresiduum > term_precision)
+	{
+		remaining = CHECK_SAFETY * log(term_precision / maxresiduum) / log(rate);
+
+		if (remaining >= CHECK_MAX_DISTANCE)
+		{
+			check->distance = CHECK_MAX_DISTANCE;
+		}
+		else if (remaining >= 1.0)
+		{
+			check->distance = remaining;
+		}
+	}
+
+	return check->distance;
+}
+
+/* ************************************************************************ */
+/* stagnated: returns whether the residuum has not reached a new minimum    */
+/*            for window iterations, i.e. it hit the rounding level of the  */
+/*            method above the requested precision                          */
+/*                                                                          */
+/* Over-relaxed methods keep changing the last bits of the solution, so     */
+/* their residuum does not reach every precision down to MIN_PRECISION.     */
+/* ************************************************************************ */
+static int
+stagnated(struct convergence_check const* check, uint64_t window)
+{
+	return check->stalled >= window;
+}
+
+/* ************************************************************************ */
+/* writeFully: writes size bytes, returns 0 on success                      */
+/* ************************************************************************ */
+static int
+writeFully(int fd, void const* data, size_t size)
+{
+	char const* from = data;
+	ssize_t     ret;
+
+	while (size > 0 && (ret = write(fd, from, size)) > 0)
+	{
+		from += ret;
+		size -= ret;
+	}
+
+	return (size == 0) ? 0 : -1;
+}
+
+/* ************************************************************************ */
+/* checkpointWriter: writes the snapshot to a temporary file in the         */
+/*                   background and renames it over the last checkpoint     */
+/*                                                                          */
+/* The file is synced before the rename, so a crash never leaves a half     */
+/* written checkpoint, and then dropped from the page cache again, so it    */
+/* does not evict the matrix.                                               */
+/* ************************************************************************ */
+static void*
+checkpointWriter(void* data)
+{
+	struct checkpoint* cp = data;
+
+	int fd  = open(cp->temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	int ret = (fd >= 0) ? 0 : -1;
+
+	ret = (ret == 0) ? writeFully(fd, &cp->header, sizeof(cp->header)) : ret;
+	ret = (ret == 0) ? writeFully(fd, cp->buffer, cp->size) : ret;
+	ret = (ret == 0) ? fdatasync(fd) : ret;
+
+	if (fd >= 0)
+	{
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+
+	if (ret != 0 || rename(cp->temp, cp->path) != 0)
+	{
+		printf("Checkpoint konnte nicht geschrieben werden (%s)\n", cp->path);
+	}
+
+	__atomic_store_n(&cp->done, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/* ************************************************************************ */
+/* checkpointDue: returns whether the interval since the last checkpoint    */
+/*                has passed                                                */
+/*                                                                          */
+/* While the writer is still busy with the last checkpoint, the next one is */
+/* postponed instead of waiting for it.                                     */
+/* ************************************************************************ */
+static int
+checkpointDue(void)
+{
+	struct checkpoint* cp = &checkpoint;
+	struct timeval     now;
+
+	if (cp->interval == 0)
+	{
+		return 0;
+	}
+
+	gettimeofday(&now, NULL);
+
+	if (cp->last.tv_sec == 0 && cp->last.tv_usec == 0)
+	{
+		cp->last = now;
+	}
+
+	return (uint64_t)(now.tv_sec - cp->last.tv_sec) >= cp->interval && !(cp->running && !__atomic_load_n(&cp->done, __ATOMIC_ACQUIRE));
+}
+
+/* ************************************************************************ */
+/* saveCheckpoint: starts writing matrix m and the state of the iteration   */
+/*                                                                          */
+/* The calculation only pays for copying the matrix into the snapshot, the  */
+/* file is written by a background thread.                                  */
+/* ************************************************************************ */
+static void
+saveCheckpoint(struct calculation_arguments const* arguments, struct calculation_results const* results, int m, uint64_t left, struct convergence_check const* check)
+{
+	struct checkpoint* cp = &checkpoint;
+	uint64_t           i;
+
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+
+	if (cp->running)
+	{
+		pthread_join(cp->thread, NULL);
+	}
+
+	if (cp->buffer == NULL)
+	{
+		cp->size   = (N + 1) * (N + 1) * sizeof(real);
+		cp->buffer = allocateMemory(cp->size);
+	}
+
+	/* rows without their padding */
+	for (i = 0; i <= N; i++)
+	{
+		memcpy(cp->buffer + i * (N + 1), arguments->M + (m * (N + 1) + i) * ld, (N + 1) * sizeof(real));
+	}
+
+	cp->header.stat_iteration = results->stat_iteration;
+	cp->header.stat_precision = results->stat_precision;
+	cp->header.stat_omega     = results->stat_omega;
+	cp->header.m              = m;
+	cp->header.left           = left;
+	cp->header.check          = *check;
+
+	gettimeofday(&cp->last, NULL);
+
+	cp->done    = 0;
+	cp->running = 1;
+
+	if (pthread_create(&cp->thread, NULL, checkpointWriter, cp) != 0)
+	{
+		cp->running = 0;
+		printf("Checkpoint konnte nicht geschrieben werden (%s)\n", cp->path);
+	}
+}
+
+/* ************************************************************************ */
+/* finishCheckpoint: waits for the last checkpoint to be written            */
+/* ************************************************************************ */
+static void
+finishCheckpoint(void)
+{
+	if (checkpoint.running)
+	{
+		pthread_join(checkpoint.thread, NULL);
+		checkpoint.running = 0;
+	}
+
+	free(checkpoint.buffer);
+	free(checkpoint.temp);
+	checkpoint.buffer = NULL;
+	checkpoint.temp   = NULL;
+}
+
+/* ************************************************************************ */
+/* initCheckpoint: prepares the checkpoints and with --restart loads the    */
+/*                 last one into the matrix and the results                 */
+/* ************************************************************************ */
+static void
+initCheckpoint(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
+{
+	struct checkpoint*       cp = &checkpoint;
+	struct checkpoint_header header;
+	FILE*                    file;
+	uint64_t                 i;
+
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+
+	char const* path = getenv("PARTDIFF_CHECKPOINT_FILE");
+
+	/* the other methods keep more state than the matrix */
+	int const supported = options->mixed == 0 && (options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI || options->method == METH_RED_BLACK || options->method == METH_SOR);
+
+	cp->interval = supported ? options->checkpoint : 0;
+	cp->path     = (path != NULL) ? path : CHECKPOINT_FILE;
+	cp->temp     = malloc(strlen(cp->path) + 5);
+	cp->buffer   = NULL;
+	cp->running  = 0;
+
+	sprintf(cp->temp, "%s.tmp", cp->path);
+
+	memset(&cp->header, 0, sizeof(cp->header));
+	memcpy(cp->header.magic, CHECKPOINT_MAGIC, sizeof(cp->header.magic));
+	cp->header.real_size   = sizeof(real);
+	cp->header.method      = options->method;
+	cp->header.interlines  = options->interlines;
+	cp->header.inf_func    = options->inf_func;
+	cp->header.termination = options->termination;
+
+	if (!options->restart)
+	{
+		return;
+	}
+
+	if (!supported)
+	{
+		printf("Checkpoints gibt es nur für Gauß-Seidel, Jacobi, Red-Black Gauß-Seidel und SOR\n");
+		exit(1);
+	}
+
+	if ((file = fopen(cp->path, "rb")) == NULL || fread(&header, sizeof(header), 1, file) != 1)
+	{
+		printf("Checkpoint kann nicht gelesen werden (%s)\n", cp->path);
+		exit(1);
+	}
+
+	if (memcmp(header.magic, cp->header.magic, sizeof(header.magic)) != 0 || header.real_size != cp->header.real_size || header.method != cp->header.method || header.interlines != cp->header.interlines || header.inf_func != cp->header.inf_func || header.termination != cp->header.termination || header.m >= arguments->num_matrices)
+	{
+		printf("Checkpoint passt nicht zu den Parametern (%s)\n", cp->path);
+		exit(1);
+	}
+
+	for (i = 0; i <= N; i++)
+	{
+		if (fread(arguments->M + (header.m * (N + 1) + i) * ld, sizeof(real), N + 1, file) != N + 1)
+		{
+			printf("Checkpoint ist unvollständig (%s)\n", cp->path);
+			exit(1);
+		}
+	}
+
+	posix_fadvise(fileno(file), 0, 0, POSIX_FADV_DONTNEED);
+	fclose(file);
+
+	cp->header    = header;
+	cp->restarted = header.stat_iteration;
+
+	results->m              = header.m;
+	results->stat_iteration = header.stat_iteration;
+	results->stat_precision = header.stat_precision;
+	results->stat_omega     = header.stat_omega;
+}
+
+/* ************************************************************************ */
+/* calculate_red_black: performs one red-black Gauß-Seidel iteration        */
+/*                                                                          */
+/* Updates all red points (i + j even) first and all black points after.    */
+/* Points of one colour only depend on points of the other colour, so every */
+/* half sweep can be computed in any order. The residuum is only computed   */
+/* if residual is set.                                                      */
+/* ************************************************************************ */
+static double
+calculate_red_black(struct calculation_arguments const* arguments, int residual)
+{
+	int    i, j;              /* local variables for loops */
+	int    colour;            /* 0: red, 1: black */
+	double star;              /* four times center value minus 4 neigh.b values */
+	double residuum;          /* residuum of current iteration */
+	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
+
+	typedef real(*matrix)[ld];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	for (colour = 0; colour < 2; colour++)
+	{
+		/* over all rows */
+		for (i = 1; i < N; i++)
+		{
+			double const* f = rhsLine(arguments, i, arguments->rhs_buffer);
+
+			/* over all columns of the current colour */
+			for (j = 1 + (i + colour + 1) % 2; j < N; j += 2)
+			{
+				star = ((double)Matrix[i - 1][j] + Matrix[i][j - 1] + Matrix[i][j + 1] + Matrix[i + 1][j]) / 4;
+
+				star += f[j];
+
+				if (residual)
+				{
+					residuum    = Matrix[i][j] - star;
+					residuum    = fabs(residuum);
+					maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+				}
+
+				Matrix[i][j] = star;
+			}
+		}
+	}
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* calculate_sor: performs one SOR iteration with relaxation factor omega,  */
+/*                the residuum is only computed if residual is set          */
+/* ************************************************************************ */
+static double
+calculate_sor(struct calculation_arguments const* arguments, double omega, int residual)
+{
+	int    i, j;              /* local variables for loops */
+	double star;              /* four times center value minus 4 neigh.b values */
+	double residuum;          /* residuum of current iteration */
+	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
+
+	typedef real(*matrix)[ld];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	/* over all rows */
+	for (i = 1; i < N; i++)
+	{
+		double const* f = rhsLine(arguments, i, arguments->rhs_buffer);
+
+		/* over all columns */
+		for (j = 1; j < N; j++)
+		{
+			star = ((double)Matrix[i - 1][j] + Matrix[i][j - 1] + Matrix[i][j + 1] + Matrix[i + 1][j]) / 4;
+
+			star += f[j];
+
+			star = Matrix[i][j] + omega * (star - Matrix[i][j]);
+
+			if (residual)
+			{
+				residuum    = Matrix[i][j] - star;
+				residuum    = fabs(residuum);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+			}
+
+			Matrix[i][j] = star;
+		}
+	}
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* adaptOmega: re-estimates the SOR relaxation factor                       */
+/*                                                                          */
+/* For SOR with factor omega every eigenvalue lambda belongs to a Jacobi    */
+/* eigenvalue mu with (lambda + omega - 1)^2 = lambda * omega^2 * mu^2.     */
+/* Once the residuum decays with a steady factor, that factor is the        */
+/* dominant lambda, which gives an estimate of the Jacobi spectral radius   */
+/* and from it the optimal omega. Starting at omega = 1 (Gauß-Seidel) the   */
+/* estimates stay below the optimum, where the decay is still steady.       */
+/* ************************************************************************ */
+static double
+adaptOmega(double omega, double ratio)
+{
+	double rho2 = (ratio + omega - 1) * (ratio + omega - 1) / (ratio * omega * omega);
+
+	if (rho2 >= 1.0)
+	{
+		return omega;
+	}
+
+	double estimate = 2.0 / (1.0 + sqrt(1.0 - rho2));
+
+	return (estimate > omega) ? estimate : omega;
+}
+
+/* ************************************************************************ */
+/* jacobi_rows_*: Jacobi update of the columns first .. last - 1 of one or  */
+/*                two rows                                                  */
+/*                                                                          */
+/* src points to the old row above the first updated row, dst to the first  */
+/* new row, f0 and f1 to the interference function of both rows, ld is the  */
+/* leading dimension of the matrices. The second row reuses the two middle  */
+/* rows the first one already loaded. Every kernel sums the neighbours in   */
+/* the same order as the scalar loop, so all of them give bit-identical     */
+/* results, and returns max |old - new|.                                    */
+/* ************************************************************************ */
+static double
+jacobi_rows_from(real const* src, real* dst, double const* f0, double const* f1, int ld, int rows, int first, int last)
+{
+	int    j, k;              /* local variables for loops */
+	double star;              /* four times center value minus 4 neigh.b values */
+	double residuum;          /* residuum of current point */
+	double maxresiduum = 0.0; /* maximum residuum value of the rows */
+
+	for (k = 0; k < rows; k++)
+	{
+		real const*   up   = src + k * ld;
+		real const*   cur  = up + ld;
+		real const*   down = cur + ld;
+		double const* f    = (k == 0) ? f0 : f1;
+		real*         out  = dst + k * ld;
+
+		for (j = first; j < last; j++)
+		{
+			star = 0.25 * ((double)up[j] + cur[j - 1] + cur[j + 1] + down[j]) + f[j];
+
+			residuum    = fabs(cur[j] - star);
+			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+
+			out[j] = star;
+		}
+	}
+
+	return maxresiduum;
+}
+
+static double
+jacobi_rows_scalar(real const* src, real* dst, double const* f0, double const* f1, int ld, int rows, int first, int last)
+{
+	return jacobi_rows_from(src, dst, f0, f1, ld, rows, first, last);
+}
+
+#ifdef HAVE_X86_SIMD
+/* float rows are widened on load and rounded once on store */
+#ifdef FLOAT
+#define LOAD_SSE2(p)       _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((__m128i const*)(p))))
+#define STORE_SSE2(p, v)   _mm_storel_epi64((__m128i*)(p), _mm_castps_si128(_mm_cvtpd_ps(v)))
+#define LOAD_AVX2(p)       _mm256_cvtps_pd(_mm_loadu_ps(p))
+#define STORE_AVX2(p, v)   _mm_storeu_ps((p), _mm256_cvtpd_ps(v))
+#define LOAD_AVX512(p)     _mm512_cvtps_pd(_mm256_loadu_ps(p))
+#define STORE_AVX512(p, v) _mm256_storeu_ps((p), _mm512_cvtpd_ps(v))
+#else
+#define LOAD_SSE2(p)       _mm_loadu_pd(p)
+#define STORE_SSE2(p, v)   _mm_storeu_pd((p), (v))
+#define LOAD_AVX2(p)       _mm256_loadu_pd(p)
+#define STORE_AVX2(p, v)   _mm256_storeu_pd((p), (v))
+#define LOAD_AVX512(p)     _mm512_loadu_pd(p)
+#define STORE_AVX512(p, v) _mm512_storeu_pd((p), (v))
+#endif
+
+static double
+jacobi_rows_sse2(real const* src, real* dst, double const* f0, double const* f1, int ld, int rows, int first, int last)
+{
+	int    j;         /* local variable for loop */
+	double lanes[2];  /* lanes of the maximum */
+	double rest;      /* maximum of the scalar remainder */
+
+	real const* r0 = src;
+	real const* r1 = r0 + ld;
+	real const* r2 = r1 + ld;
+	real const* r3 = r2 + ld;
+
+	__m128d const quarter = _mm_set1_pd(0.25);
+	__m128d const sign    = _mm_set1_pd(-0.0);
+	__m128d       vmax    = _mm_setzero_pd();
+
+	for (j = first; j + 2 <= last; j += 2)
+	{
+		__m128d c1 = LOAD_SSE2(r1 + j);
+		__m128d c2 = LOAD_SSE2(r2 + j);
+		__m128d s  = _mm_add_pd(_mm_add_pd(_mm_add_pd(LOAD_SSE2(r0 + j), LOAD_SSE2(r1 + j - 1)), LOAD_SSE2(r1 + j + 1)), c2);
+
+		s    = _mm_add_pd(_mm_mul_pd(quarter, s), _mm_loadu_pd(f0 + j));
+		vmax = _mm_max_pd(vmax, _mm_andnot_pd(sign, _mm_sub_pd(c1, s)));
+		STORE_SSE2(dst + j, s);
+
+		if (rows == 2)
+		{
+			s = _mm_add_pd(_mm_add_pd(_mm_add_pd(c1, LOAD_SSE2(r2 + j - 1)), LOAD_SSE2(r2 + j + 1)), LOAD_SSE2(r3 + j));
+
+			s    = _mm_add_pd(_mm_mul_pd(quarter, s), _mm_loadu_pd(f1 + j));
+			vmax = _mm_max_pd(vmax, _mm_andnot_pd(sign, _mm_sub_pd(c2, s)));
+			STORE_SSE2(dst + ld + j, s);
+		}
+	}
+
+	_mm_storeu_pd(lanes, vmax);
+
+	rest = jacobi_rows_from(src, dst, f0, f1, ld, rows, j, last);
+
+	return fmax(fmax(lanes[0], lanes[1]), rest);
+}
+
+__attribute__((target("avx2")))
+static double
+jacobi_rows_avx2(real const* src, real* dst, double const* f0, double const* f1, int ld, int rows, int first, int last)
+{
+	int    j;         /* local variable for loop */
+	double lanes[4];  /* lanes of the maximum */
+	double rest;      /* maximum of the scalar remainder */
+
+	real const* r0 = src;
+	real const* r1 = r0 + ld;
+	real const* r2 = r1 + ld;
+	real const* r3 = r2 + ld;
+
+	__m256d const quarter = _mm256_set1_pd(0.25);
+	__m256d const sign    = _mm256_set1_pd(-0.0);
+	__m256d       vmax    = _mm256_setzero_pd();
+
+	for (j = first; j + 4 <= last; j += 4)
+	{
+		__m256d c1 = LOAD_AVX2(r1 + j);
+		__m256d c2 = LOAD_AVX2(r2 + j);
+		__m256d s  = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(LOAD_AVX2(r0 + j), LOAD_AVX2(r1 + j - 1)), LOAD_AVX2(r1 + j + 1)), c2);
+
+		s    = _mm256_add_pd(_mm256_mul_pd(quarter, s), _mm256_loadu_pd(f0 + j));
+		vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(sign, _mm256_sub_pd(c1, s)));
+		STORE_AVX2(dst + j, s);
+
+		if (rows == 2)
+		{
+			s = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(c1, LOAD_AVX2(r2 + j - 1)), LOAD_AVX2(r2 + j + 1)), LOAD_AVX2(r3 + j));
+
+			s    = _mm256_add_pd(_mm256_mul_pd(quarter, s), _mm256_loadu_pd(f1 + j));
+			vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(sign, _mm256_sub_pd(c2, s)));
+			STORE_AVX2(dst + ld + j, s);
+		}
+	}
+
+	_mm256_storeu_pd(lanes, vmax);
+
+	rest = jacobi_rows_from(src, dst, f0, f1, ld, rows, j, last);
+
+	return fmax(fmax(fmax(lanes[0], lanes[1]), fmax(lanes[2], lanes[3])), rest);
+}
+
+__attribute__((target("avx512f")))
+static double
+jacobi_rows_avx512(real const* src, real* dst, double const* f0, double const* f1, int ld, int rows, int first, int last)
+{
+	int    j;    /* local variable for loop */
+	double rest; /* maximum of the scalar remainder */
+
+	real const* r0 = src;
+	real const* r1 = r0 + ld;
+	real const* r2 = r1 + ld;
+	real const* r3 = r2 + ld;
+
+	__m512d const quarter = _mm512_set1_pd(0.25);
+	__m512d       vmax    = _mm512_setzero_pd();
+
+	for (j = first; j + 8 <= last; j += 8)
+	{
+		__m512d c1 = LOAD_AVX512(r1 + j);
+		__m512d c2 = LOAD_AVX512(r2 + j);
+		__m512d s  = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(LOAD_AVX512(r0 + j), LOAD_AVX512(r1 + j - 1)), LOAD_AVX512(r1 + j + 1)), c2);
+
+		s    = _mm512_add_pd(_mm512_mul_pd(quarter, s), _mm512_loadu_pd(f0 + j));
+		vmax = _mm512_max_pd(vmax, _mm512_abs_pd(_mm512_sub_pd(c1, s)));
+		STORE_AVX512(dst + j, s);
+
+		if (rows == 2)
+		{
+			s = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(c1, LOAD_AVX512(r2 + j - 1)), LOAD_AVX512(r2 + j + 1)), LOAD_AVX512(r3 + j));
+
+			s    = _mm512_add_pd(_mm512_mul_pd(quarter, s), _mm512_loadu_pd(f1 + j));
+			vmax = _mm512_max_pd(vmax, _mm512_abs_pd(_mm512_sub_pd(c2, s)));
+			STORE_AVX512(dst + ld + j, s);
+		}
+	}
+
+	rest = jacobi_rows_from(src, dst, f0, f1, ld, rows, j, last);
+
+	return fmax(_mm512_reduce_max_pd(vmax), rest);
+}
+#endif
+
+/* ************************************************************************ */
+/* selectKernel: returns the Jacobi kernel for the given instruction set    */
+/* ************************************************************************ */
+static jacobi_kernel
+selectKernel(uint64_t simd)
+{
+#ifdef HAVE_X86_SIMD
+	if (simd == SIMD_AVX512)
+	{
+		return jacobi_rows_avx512;
+	}
+	else if (simd == SIMD_AVX2)
+	{
+		return jacobi_rows_avx2;
+	}
+	else if (simd == SIMD_SSE2)
+	{
+		return jacobi_rows_sse2;
+	}
+#else
+	(void)simd;
+#endif
+
+	return jacobi_rows_scalar;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation                                           */
+/* ************************************************************************ */
+static void
+calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int    i, j;        /* local variables for loops */
+	int    m1, m2;      /* used as indices for old and new matrices */
+	double star;        /* four times center value minus 4 neigh.b values */
+	double residuum;    /* residuum of current iteration */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	int    residual;    /* whether the current iteration computes the residuum */
+	int    first, last; /* columns of the current tile */
+
+	int const N     = arguments->N;
+	int const ld    = arguments->ld;
+	int const width = tileWidth(arguments, options);
+
+	int term_iteration = options->term_iteration;
+
+	/* optimal SOR can grow the residuum for about N iterations first */
+	uint64_t const stall = ((uint64_t)4 * N > STALL_ITERATIONS) ? (uint64_t)4 * N : STALL_ITERATIONS;
+
+	uint64_t                 left = 1; /* iterations until the next convergence check */
+	struct convergence_check check;    /* state of the convergence checks */
+
+	double omega      = 1.0; /* SOR relaxation factor */
+	double prevresid  = 0.0; /* SOR: maximum residuum of the previous iteration */
+	double prevratio  = 0.0; /* SOR: previous residuum decay factor */
+	int    steady     = 0;   /* SOR: iterations with steady decay factor */
+
+	jacobi_kernel const kernel = selectKernel(options->simd);
+
+	typedef real(*matrix)[N + 1][ld];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	if (options->sor_mode == SOR_OPTIMAL)
+	{
+		omega = 2.0 / (1.0 + sin(M_PI / N));
+	}
+	else if (options->sor_mode == SOR_FIXED)
+	{
+		omega = options->sor_omega;
+	}
+
+	if (options->method == METH_JACOBI)
+	{
+		initCheck(&check, options, cos(M_PI / N));
+	}
+	else if (options->method == METH_SOR)
+	{
+		initCheck(&check, options, fabs(omega - 1));
+
+		/* adaptive SOR needs the residuum of every iteration */
+		check.adaptive = check.adaptive && options->sor_mode != SOR_ADAPTIVE;
+	}
+	else
+	{
+		initCheck(&check, options, cos(M_PI / N) * cos(M_PI / N));
+	}
+
+	/* initialize m1 and m2 depending on algorithm */
+	if (options->method == METH_JACOBI)
+	{
+		m1 = 0;
+		m2 = 1;
+	}
+	else
+	{
+		m1 = 0;
+		m2 = 0;
+	}
+
+	/* continue with the state of the checkpoint */
+	if (options->restart)
+	{
+		m2 = results->m;
+		m1 = (options->method == METH_JACOBI) ? 1 - m2 : m2;
+
+		checkpoint.header.check.adaptive = check.adaptive;
+
+		left  = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+		check = checkpoint.header.check;
+		omega = (options->sor_mode == SOR_ADAPTIVE) ? results->stat_omega : omega;
+
+		if (options->termination == TERM_ITER)
+		{
+			term_iteration = (results->stat_iteration < options->term_iteration) ? options->term_iteration - results->stat_iteration : 0;
+		}
+	}
+
+	while (term_iteration > 0)
+	{
+		maxresiduum = 0;
+
+		residual = (options->termination == TERM_PREC && left == 1) || term_iteration == 1 || (options->method == METH_SOR && options->sor_mode == SOR_ADAPTIVE);
+
+		if (options->method == METH_RED_BLACK)
+		{
+			maxresiduum = calculate_red_black(arguments, residual);
+		}
+		else if (options->method == METH_SOR)
+		{
+			maxresiduum = calculate_sor(arguments, omega, residual);
+
+			results->stat_omega = omega;
+
+			if (options->sor_mode == SOR_ADAPTIVE && prevresid > 0.0 && maxresiduum < prevresid)
+			{
+				double ratio = maxresiduum / prevresid;
+
+				steady = (fabs(ratio - prevratio) < 1e-5 * ratio) ? steady + 1 : 0;
+
+				if (steady >= SOR_ADAPT_STEPS)
+				{
+					omega  = adaptOmega(omega, ratio);
+					steady = 0;
+				}
+
+				prevratio = ratio;
+			}
+
+			prevresid = maxresiduum;
+		}
+		else if (options->method == METH_JACOBI)
+		{
+			/* over all tiles */
+			for (first = 1; first < N; first += width)
+			{
+				last = (first + width < N) ? first + width : N;
+
+				/* two rows at a time, the last call may only get one */
+				for (i = 1; i < N; i += 2)
+				{
+					double const* f0 = rhsTile(arguments, i, first, last, arguments->rhs_buffer);
+					double const* f1 = rhsTile(arguments, i + 1, first, last, arguments->rhs_buffer + (N + 1));
+
+					/* the kernels always fuse the residuum, it is almost free there */
+					residuum    = kernel(&Matrix[m2][i - 1][0], &Matrix[m1][i][0], f0, f1, ld, (i + 1 < N) ? 2 : 1, first, last);
+					maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+				}
+			}
+		}
+		else
+		{
+			/* over all tiles */
+			for (first = 1; first < N; first += width)
+			{
+				last = (first + width < N) ? first + width : N;
+
+				/* over all rows */
+				for (i = 1; i < N; i++)
+				{
+					double const* f = rhsTile(arguments, i, first, last, arguments->rhs_buffer);
+
+					/* over all columns of the tile */
+					for (j = first; j < last; j++)
+					{
+						star = ((double)Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
+
+						star += f[j];
+
+						if (residual)
+						{
+							residuum    = Matrix[m2][i][j] - star;
+							residuum    = fabs(residuum);
+							maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+						}
+
+						Matrix[m1][i][j] = star;
+					}
+				}
+			}
+		}
+
+		results->stat_iteration++;
+
+		if (residual)
+		{
+			results->stat_precision = maxresiduum;
+		}
+
+		/* exchange m1 and m2 */
+		i  = m1;
+		m1 = m2;
+		m2 = i;
+
+		/* check for stopping calculation depending on termination method */
+		if (options->termination == TERM_PREC && --left == 0)
+		{
+			left = nextCheck(&check, maxresiduum, options->term_precision);
+
+			if (maxresiduum < options->term_precision)
+			{
+				term_iteration = 0;
+			}
+			else if (stagnated(&check, stall))
+			{
+				term_iteration        = 0;
+				results->stat_stalled = check.stalled;
+			}
+		}
+		else if (options->termination == TERM_ITER)
+		{
+			term_iteration--;
+		}
+
+		if (term_iteration > 0 && checkpointDue())
+		{
+			saveCheckpoint(arguments, results, m2, left, &check);
+		}
+	}
+
+	results->m           = m2;
+	results->stat_checks += check.checks;
+	results->stat_kernel  = options->method == METH_JACOBI;
+}
+
+/* ************************************************************************ */
+/* calculate_row: updates row i of matrix m2 into matrix m1                 */
+/* ************************************************************************ */
+static inline double
+calculate_row(struct calculation_arguments const* arguments, int m1, int m2, int i)
+{
+	int    j;                 /* local variable for loop */
+	double star;              /* four times center value minus 4 neigh.b values */
+	double residuum;          /* residuum of current row */
+	double maxresiduum = 0.0; /* maximum residuum value of current row */
+
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
+
+	typedef real(*matrix)[N + 1][ld];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	double const* f = rhsLine(arguments, i, arguments->rhs_buffer);
+
+	for (j = 1; j < N; j++)
+	{
+		star = ((double)Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
+
+		star += f[j];
+
+		residuum    = Matrix[m2][i][j] - star;
+		residuum    = fabs(residuum);
+		maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+
+		Matrix[m1][i][j] = star;
+	}
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* calculate_wavefront: solves the equation with temporal blocking          */
+/*                                                                          */
+/* Performs tile_depth sweeps per pass over the matrix. In step s sweep t   */
+/* updates row s - t, so sweep t - 1 always runs exactly one row ahead of   */
+/* sweep t and only the last few rows of every sweep have to stay in cache. */
+/* For Jacobi the sweeps alternate between both matrices: the row sweep t   */
+/* overwrites was last read by sweep t - 1 earlier in the same step. For    */
+/* Gauß-Seidel the skew reproduces the exact update order of the plain      */
+/* loop, so both methods give bit-identical matrices.                       */
+/*                                                                          */
+/* Out of core the pass streams through the file: the next chunk of rows is */
+/* read ahead and the rows below s - depth, which no sweep of the pass      */
+/* touches again, are written back and released.                            */
+/* ************************************************************************ */
+static void
+calculate_wavefront(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int    i, s, t;        /* local variables for loops */
+	int    t_min, t_max;   /* sweeps active in the current step */
+	int    m1, m2;         /* used as indices for old and new matrices */
+	int    depth;          /* number of sweeps in the current pass */
+	int    freed, older;    /* rows below are released out of core */
+	double residuum;       /* residuum of current row */
+	double maxresiduum;    /* maximum residuum value of last sweep in pass */
+
+	int const N     = arguments->N;
+	int const ooc   = arguments->ooc_fd >= 0;
+	int const chunk = arguments->ooc_chunk;
+
+	int term_iteration = options->term_iteration;
+
+	struct convergence_check check; /* fresh checks for a restart with calculate() */
+
+	initCheck(&check, options, (options->method == METH_JACOBI) ? cos(M_PI / N) : cos(M_PI / N) * cos(M_PI / N));
+
+	/* initialize m1 and m2 depending on algorithm */
+	if (options->method == METH_JACOBI)
+	{
+		m1 = 0;
+		m2 = 1;
+	}
+	else
+	{
+		m1 = 0;
+		m2 = 0;
+	}
+
+	/* continue with the state of the checkpoint */
+	if (options->restart)
+	{
+		m2 = results->m;
+		m1 = (options->method == METH_JACOBI) ? 1 - m2 : m2;
+
+		if (options->termination == TERM_ITER)
+		{
+			term_iteration = (results->stat_iteration < options->term_iteration) ? options->term_iteration - results->stat_iteration : 0;
+		}
+	}
+
+	while (term_iteration > 0)
+	{
+		depth = options->tile_depth;
+
+		if (options->termination == TERM_ITER && depth > term_iteration)
+		{
+			depth = term_iteration;
+		}
+
+		maxresiduum = 0;
+		freed       = 0;
+		older       = 0;
+
+		if (ooc)
+		{
+			oocPrefetch(arguments, 0, 2 * chunk);
+		}
+
+		for (s = 1; s < N + depth - 1; s++)
+		{
+			if (ooc && s % chunk == 0)
+			{
+				oocPrefetch(arguments, s + chunk, s + 2 * chunk);
+				oocRelease(arguments, older, s - depth);
+
+				older = freed;
+				freed = s - depth;
+			}
+
+			t_min = (s - N + 1 > 0) ? s - N + 1 : 0;
+			t_max = (s - 1 < depth - 1) ? s - 1 : depth - 1;
+
+			for (t = t_min; t <= t_max; t++)
+			{
+				i = s - t;
+
+				if (t % 2 == 0)
+				{
+					residuum = calculate_row(arguments, m1, m2, i);
+				}
+				else
+				{
+					residuum = calculate_row(arguments, m2, m1, i);
+				}
+
+				if (t == depth - 1)
+				{
+					maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+				}
+			}
+		}
+
+		results->stat_iteration += depth;
+		results->stat_precision = maxresiduum;
+
+		/* exchange m1 and m2 once per sweep */
+		if (depth % 2 == 1)
+		{
+			i  = m1;
+			m1 = m2;
+			m2 = i;
+		}
+
+		/* check for stopping calculation depending on termination method */
+		if (options->termination == TERM_PREC)
+		{
+			if (maxresiduum < options->term_precision)
+			{
+				term_iteration = 0;
+			}
+		}
+		else if (options->termination == TERM_ITER)
+		{
+			term_iteration -= depth;
+		}
+
+		if (term_iteration > 0 && checkpointDue())
+		{
+			saveCheckpoint(arguments, results, m2, 1, &check);
+		}
+	}
+
+	results->m = m2;
+}
+
+/* ************************************************************************ */
+/* mixed_defect: stores the defect d = f + (sum of neighbours) / 4 - u      */
+/*               of the double matrix as float and returns max |d|, i.e.    */
+/*               the largest change a Jacobi step would make                */
+/* ************************************************************************ */
+static double
+mixed_defect(struct calculation_arguments const* arguments, float* d)
+{
+	int    i, j;              /* local variables for loops */
+	double defect;            /* defect of one point */
+	double maxresiduum = 0.0; /* maximum defect */
+
+	int const N   = arguments->N;
+	int const ld  = arguments->ld;
+	int const ldf = rowLength(N, sizeof(float));
+
+	typedef real(*matrix)[ld];
+	typedef float(*float_matrix)[ldf];
+
+	matrix       U = (matrix)arguments->M;
+	float_matrix D = (float_matrix)d;
+
+	for (i = 1; i < N; i++)
+	{
+		double const* f = rhsLine(arguments, i, arguments->rhs_buffer);
+
+		for (j = 1; j < N; j++)
+		{
+			defect  = ((double)U[i - 1][j] + U[i][j - 1] + U[i][j + 1] + U[i + 1][j]) / 4;
+			defect += f[j] - U[i][j];
+
+			D[i][j]     = defect;
+			maxresiduum = (fabs(defect) < maxresiduum) ? maxresiduum : fabs(defect);
+		}
+	}
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* mixed_sweep: one float sweep of e = (sum of the 4 neighbours) / 4 + d    */
+/*              from e_old into e_new, Gauß-Seidel if both are the same,    */
+/*              all with leading dimension ldf                              */
+/* ************************************************************************ */
+static float
+mixed_sweep(int N, int ldf, float const* d, float const* e_old, float* e_new)
+{
+	int   i, j;               /* local variables for loops */
+	float star;               /* four times center value minus 4 neigh.b values */
+	float residuum;           /* change of one point */
+	float maxresiduum = 0.0f; /* maximum change in current sweep */
+
+	typedef float(*float_matrix)[ldf];
+
+	float_matrix       D   = (float_matrix)d;
+	float_matrix const Old = (float_matrix)e_old;
+	float_matrix       New = (float_matrix)e_new;
+
+	for (i = 1; i < N; i++)
+	{
+		for (j = 1; j < N; j++)
+		{
+			star = (Old[i - 1][j] + Old[i][j - 1] + Old[i][j + 1] + Old[i + 1][j]) / 4 + D[i][j];
+
+			residuum    = fabsf(Old[i][j] - star);
+			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+
+			New[i][j] = star;
+		}
+	}
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* calculate_mixed: solves the equation by iterative refinement             */
+/*                                                                          */
+/* The defect of the double matrix u is computed in double and handed to    */
+/* float Gauß-Seidel or Jacobi sweeps on the correction equation A e = d,   */
+/* which start at e = 0 and stop once a sweep changes e by less than        */
+/* MIXED_REDUCTION times the defect or options->mixed sweeps are done.      */
+/* u += e is added in double, so the precision is only limited by double,   */
+/* while the sweeps move half the bytes. Once a correction no longer lowers */
+/* the defect, u is within rounding of double and calculate() finishes      */
+/* with double Gauß-Seidel sweeps, which settle where Jacobi can cycle.     */
+/* Iterations count all sweeps, the reported error is the max defect of u,  */
+/* i.e. the change of a Jacobi step, until calculate() takes over.          */
+/* ************************************************************************ */
+static void
+calculate_mixed(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int      i, j;         /* local variables for loops */
+	uint64_t k;            /* local variable for sweeps */
+	int      m1, m2;       /* used as indices for old and new corrections */
+	double   maxresiduum;  /* maximum defect of u */
+	double   prevresiduum; /* maximum defect of u before the last correction */
+	float    change;       /* maximum change of the current sweep */
+
+	int const      N    = arguments->N;
+	int const      ld   = arguments->ld;
+	int const      ldf  = rowLength(N, sizeof(float));
+	uint64_t const size = (N + 1) * ldf * sizeof(float);
+	uint64_t const num  = (options->method == METH_JACOBI) ? 2 : 1;
+
+	uint64_t term_iteration = options->term_iteration;
+
+	typedef real(*matrix)[ld];
+	typedef float(*float_matrix)[N + 1][ldf];
+
+	matrix       U = (matrix)arguments->M;
+	float*       d = allocateMemory(size);
+	float_matrix E = (float_matrix)allocateMemory(num * size);
+
+	/* the borders of d and e stay 0 */
+	memset(d, 0, size);
+
+	m1 = 0;
+	m2 = num - 1;
+
+	prevresiduum = INFINITY;
+
+	while (1)
+	{
+		maxresiduum = mixed_defect(arguments, d);
+
+		results->stat_precision = maxresiduum;
+
+		/* check for stopping calculation depending on termination method */
+		if (options->termination == TERM_PREC && maxresiduum < options->term_precision)
+		{
+			break;
+		}
+		else if (options->termination == TERM_ITER && term_iteration == 0)
+		{
+			break;
+		}
+
+		if (maxresiduum >= prevresiduum)
+		{
+			break;
+		}
+
+		prevresiduum = maxresiduum;
+
+		memset(E, 0, num * size);
+
+		for (k = 0; k < options->mixed && term_iteration > 0; k++)
+		{
+			change = mixed_sweep(N, ldf, d, &E[m2][0][0], &E[m1][0][0]);
+
+			results->stat_iteration++;
+
+			if (options->termination == TERM_ITER)
+			{
+				term_iteration--;
+			}
+
+			/* exchange m1 and m2 */
+			i  = m1;
+			m1 = m2;
+			m2 = i;
+
+			if (change < MIXED_REDUCTION * maxresiduum)
+			{
+				break;
+			}
+		}
+
+		/* the newest correction is in m2 now */
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				U[i][j] += E[m2][i][j];
+			}
+		}
+
+		results->stat_corrections++;
+	}
+
+	free(d);
+	free(E);
+
+	results->m = 0;
+
+	if (maxresiduum >= prevresiduum)
+	{
+		struct options rest = *options;
+
+		rest.method         = METH_GAUSS_SEIDEL;
+		rest.term_iteration = term_iteration;
+
+		k = results->stat_iteration;
+
+		calculate(arguments, results, &rest);
+
+		results->stat_finish = results->stat_iteration - k;
+	}
+}
+
+/* ************************************************************************ */
+/* mg_smooth: performs sweeps smoothing steps on one multigrid level        */
+/* ************************************************************************ */
+static void
+mg_smooth(struct mg_level* level, uint64_t smoother, int sweeps)
+{
+	int    i, j, k; /* local variables for loops */
+	double star;    /* four times center value minus 4 neigh.b values */
+
+	int const    N  = level->N;
+	int const    ld = level->ld;
+	double const h2 = level->h * level->h;
+
+	typedef real(*matrix)[ld];
+
+	matrix U   = (matrix)level->u;
+	matrix F   = (matrix)level->f;
+	matrix Tmp = (matrix)level->r;
+
+	for (k = 0; k < sweeps; k++)
+	{
+		if (smoother == METH_GAUSS_SEIDEL)
+		{
+			for (i = 1; i < N; i++)
+			{
+				for (j = 1; j < N; j++)
+				{
+					U[i][j] = ((double)U[i - 1][j] + U[i][j - 1] + U[i][j + 1] + U[i + 1][j] + h2 * F[i][j]) / 4;
+				}
+			}
+		}
+		else
+		{
+			/* damped Jacobi, plain Jacobi does not smooth the highest frequencies */
+			for (i = 1; i < N; i++)
+			{
+				for (j = 1; j < N; j++)
+				{
+					star      = ((double)U[i - 1][j] + U[i][j - 1] + U[i][j + 1] + U[i + 1][j] + h2 * F[i][j]) / 4;
+					Tmp[i][j] = U[i][j] + MG_JACOBI_DAMPING * (star - U[i][j]);
+				}
+			}
+
+			for (i = 1; i < N; i++)
+			{
+				memcpy(&U[i][1], &Tmp[i][1], (N - 1) * sizeof(real));
+			}
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* mg_residual: computes r = f - A u and returns the largest change a       */
+/*              Jacobi step would still make, computed like in the other    */
+/*              methods so that it reaches the same rounding level          */
+/* ************************************************************************ */
+static double
+mg_residual(struct mg_level* level)
+{
+	int    i, j;              /* local variables for loops */
+	double star;              /* four times center value minus 4 neigh.b values */
+	double residuum;          /* change of one point */
+	double maxresiduum = 0.0; /* maximum change */
+
+	int const    N  = level->N;
+	int const    ld = level->ld;
+	double const h2 = level->h * level->h;
+
+	typedef real(*matrix)[ld];
+
+	matrix U = (matrix)level->u;
+	matrix F = (matrix)level->f;
+	matrix R = (matrix)level->r;
+
+	for (i = 1; i < N; i++)
+	{
+		for (j = 1; j < N; j++)
+		{
+			star    = ((double)U[i - 1][j] + U[i][j - 1] + U[i][j + 1] + U[i + 1][j] + h2 * F[i][j]) / 4;
+			R[i][j] = 4 * (star - U[i][j]) / h2;
+
+			residuum    = fabs(star - U[i][j]);
+			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+		}
+	}
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* mg_restrict: full weighting of the fine grid function from into to       */
+/* ************************************************************************ */
+static void
+mg_restrict(struct mg_level const* fine, struct mg_level* coarse, real const* from, real* to)
+{
+	int i, j; /* local variables for loops */
+
+	int const Nc = coarse->N;
+
+	typedef real(*fine_matrix)[fine->ld];
+	typedef real(*coarse_matrix)[coarse->ld];
+
+	fine_matrix   R = (fine_matrix)from;
+	coarse_matrix F = (coarse_matrix)to;
+
+	for (i = 1; i < Nc; i++)
+	{
+		for (j = 1; j < Nc; j++)
+		{
+			F[i][j] = (4 * (double)R[2 * i][2 * j]
+			           + 2 * ((double)R[2 * i - 1][2 * j] + R[2 * i + 1][2 * j] + R[2 * i][2 * j - 1] + R[2 * i][2 * j + 1])
+			           + R[2 * i - 1][2 * j - 1] + R[2 * i - 1][2 * j + 1] + R[2 * i + 1][2 * j - 1] + R[2 * i + 1][2 * j + 1]) / 16;
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* mg_prolongate: bilinear interpolation of the coarse solution onto the    */
+/*                fine interior, added to it (correction) or replacing it   */
+/* ************************************************************************ */
+static void
+mg_prolongate(struct mg_level const* coarse, struct mg_level* fine, int add)
+{
+	int    i, j;   /* local variables for loops */
+	int    ci, cj; /* coarse indices left of/above the fine point */
+	double value;  /* interpolated value */
+
+	int const Nf = fine->N;
+
+	typedef real(*fine_matrix)[fine->ld];
+	typedef real(*coarse_matrix)[coarse->ld];
+
+	fine_matrix   U = (fine_matrix)fine->u;
+	coarse_matrix C = (coarse_matrix)coarse->u;
+
+	for (i = 1; i < Nf; i++)
+	{
+		ci = i / 2;
+
+		for (j = 1; j < Nf; j++)
+		{
+			cj = j / 2;
+
+			if (i % 2 == 0 && j % 2 == 0)
+			{
+				value = C[ci][cj];
+			}
+			else if (i % 2 == 0)
+			{
+				value = ((double)C[ci][cj] + C[ci][cj + 1]) / 2;
+			}
+			else if (j % 2 == 0)
+			{
+				value = ((double)C[ci][cj] + C[ci + 1][cj]) / 2;
+			}
+			else
+			{
+				value = ((double)C[ci][cj] + C[ci + 1][cj] + C[ci][cj + 1] + C[ci + 1][cj + 1]) / 4;
+			}
+
+			U[i][j] = add ? U[i][j] + value : value;
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* mg_solve_coarse: solves on the coarsest level with optimal SOR           */
+/* ************************************************************************ */
+static void
+mg_solve_coarse(struct mg_level* level)
+{
+	int    i, j, k;           /* local variables for loops */
+	double star;              /* four times center value minus 4 neigh.b values */
+	double residuum;          /* change of one point */
+	double maxresiduum;       /* maximum change in current sweep */
+	double firstresiduum = 0; /* maximum change in first sweep */
+
+	int const    N     = level->N;
+	int const    ld    = level->ld;
+	double const h2    = level->h * level->h;
+	double const omega = 2.0 / (1.0 + sin(M_PI / N));
+
+	typedef real(*matrix)[ld];
+
+	matrix U = (matrix)level->u;
+	matrix F = (matrix)level->f;
+
+	/* the coarse solution only has to be a lot better than the smoothers */
+	for (k = 0; k < 10 * N + 10; k++)
+	{
+		maxresiduum = 0.0;
+
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				star = ((double)U[i - 1][j] + U[i][j - 1] + U[i][j + 1] + U[i + 1][j] + h2 * F[i][j]) / 4;
+				star = U[i][j] + omega * (star - U[i][j]);
+
+				residuum    = fabs(U[i][j] - star);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+
+				U[i][j] = star;
+			}
+		}
+
+		if (k == 0)
+		{
+			firstresiduum = maxresiduum;
+		}
+
+		if (maxresiduum <= MG_COARSE_REDUCTION * firstresiduum)
+		{
+			break;
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* mg_cycle: performs one V (gamma = 1) or W (gamma = 2) cycle on level l   */
+/* ************************************************************************ */
+static void
+mg_cycle(struct mg_level* levels, int l, int num_levels, int gamma, uint64_t smoother)
+{
+	int k; /* local variable for loop */
+
+	struct mg_level* fine   = &levels[l];
+	struct mg_level* coarse = &levels[l + 1];
+
+	if (l == num_levels - 1)
+	{
+		mg_solve_coarse(fine);
+		return;
+	}
+
+	mg_smooth(fine, smoother, MG_PRE_SMOOTH);
+	mg_residual(fine);
+	mg_restrict(fine, coarse, fine->r, coarse->f);
+
+	/* the coarse levels solve for the correction, which is 0 on the border */
+	memset(coarse->u, 0, (coarse->N + 1) * coarse->ld * sizeof(real));
+
+	for (k = 0; k < gamma; k++)
+	{
+		mg_cycle(levels, l + 1, num_levels, gamma, smoother);
+	}
+
+	mg_prolongate(coarse, fine, 1);
+	mg_smooth(fine, smoother, MG_POST_SMOOTH);
+}
+
+/* ************************************************************************ */
+/* mg_full: full multigrid, nested iteration from the coarsest level up     */
+/*                                                                          */
+/* Restricts the right-hand side to every level and injects the border,     */
+/* solves on the coarsest level and interpolates every solution as starting */
+/* point for one V cycle on the next finer level.                           */
+/* ************************************************************************ */
+static void
+mg_full(struct mg_level* levels, int num_levels, uint64_t smoother)
+{
+	int i, l; /* local variables for loops */
+
+	for (l = 1; l < num_levels; l++)
+	{
+		int const Nf = levels[l - 1].N;
+		int const Nc = levels[l].N;
+
+		typedef real(*fine_matrix)[levels[l - 1].ld];
+		typedef real(*coarse_matrix)[levels[l].ld];
+
+		fine_matrix   Uf = (fine_matrix)levels[l - 1].u;
+		coarse_matrix Uc = (coarse_matrix)levels[l].u;
+
+		mg_restrict(&levels[l - 1], &levels[l], levels[l - 1].f, levels[l].f);
+
+		memset(levels[l].u, 0, (Nc + 1) * levels[l].ld * sizeof(real));
+
+		for (i = 0; i <= Nc; i++)
+		{
+			Uc[i][0]  = Uf[2 * i][0];
+			Uc[i][Nc] = Uf[2 * i][Nf];
+			Uc[0][i]  = Uf[0][2 * i];
+			Uc[Nc][i] = Uf[Nf][2 * i];
+		}
+	}
+
+	mg_solve_coarse(&levels[num_levels - 1]);
+
+	for (l = num_levels - 2; l >= 0; l--)
+	{
+		mg_prolongate(&levels[l + 1], &levels[l], 0);
+		mg_cycle(levels, l, num_levels, 1, smoother);
+	}
+}
+
+/* ************************************************************************ */
+/* mg_allocate: sets up all levels below the finest level with solution u   */
+/*              and returns the number of levels                            */
+/* ************************************************************************ */
+static int
+mg_allocate(struct mg_level* levels, uint64_t N, real* u)
+{
+	int      l;              /* local variable for loop */
+	int      num_levels = 1; /* number of multigrid levels */
+	uint64_t size;           /* size of one level in bytes */
+
+	while (num_levels < MG_MAX_LEVELS && (N >> (num_levels - 1)) % 2 == 0 && (N >> (num_levels - 1)) > 2)
+	{
+		num_levels++;
+	}
+
+	for (l = 0; l < num_levels; l++)
+	{
+		levels[l].N  = N >> l;
+		levels[l].ld = rowLength(levels[l].N, sizeof(real));
+		levels[l].h  = 1.0 / levels[l].N;
+		size         = (levels[l].N + 1) * levels[l].ld * sizeof(real);
+		levels[l].u  = (l == 0) ? u : allocateMemory(size);
+		levels[l].f  = allocateMemory(size);
+		levels[l].r  = allocateMemory(size);
+
+		memset(levels[l].f, 0, size);
+		memset(levels[l].r, 0, size);
+	}
+
+	return num_levels;
+}
+
+/* ************************************************************************ */
+/* mg_free: frees all levels, the finest solution belongs to the caller     */
+/* ************************************************************************ */
+static void
+mg_free(struct mg_level* levels, int num_levels)
+{
+	int l; /* local variable for loop */
+
+	for (l = 0; l < num_levels; l++)
+	{
+		if (l != 0)
+		{
+			free(levels[l].u);
+		}
+
+		free(levels[l].f);
+		free(levels[l].r);
+	}
+}
+
+/* ************************************************************************ */
+/* calculate_multigrid: solves the equation with geometric multigrid        */
+/*                                                                          */
+/* The finest level works directly on the matrix. Every coarser level       */
+/* halves N as long as it stays even, which gives at least four levels      */
+/* because N = 8 * (interlines + 1). One iteration is one cycle, the        */
+/* reported residuum is the largest change a Jacobi step would still make.  */
+/* ************************************************************************ */
+static void
+calculate_multigrid(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int    i, j;        /* local variables for loops */
+	int    num_levels;  /* number of multigrid levels */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+
+	uint64_t const N = arguments->N;
+
+	int term_iteration = options->term_iteration;
+
+	struct mg_level          levels[MG_MAX_LEVELS];
+	struct convergence_check check; /* state of the convergence checks */
+
+	num_levels = mg_allocate(levels, N, arguments->M);
+
+	/* every cycle is checked, the check only watches for stagnation */
+	initCheck(&check, options, 0.0);
+	check.adaptive = 0;
+
+	/* the interference function already contains the factor h^2 / 4 */
+	typedef real(*matrix)[levels[0].ld];
+
+	matrix F = (matrix)levels[0].f;
+
+	for (i = 1; i < (int)N; i++)
+	{
+		double const* f = rhsLine(arguments, i, arguments->rhs_buffer);
+
+		for (j = 1; j < (int)N; j++)
+		{
+			F[i][j] = 4 * f[j] / (arguments->h * arguments->h);
+		}
+	}
+
+	if (options->mg_cycle == MG_FULL)
+	{
+		mg_full(levels, num_levels, options->mg_smoother);
+	}
+
+	while (term_iteration > 0)
+	{
+		if (options->mg_cycle != MG_FULL || results->stat_iteration > 0)
+		{
+			mg_cycle(levels, 0, num_levels, (options->mg_cycle == MG_W_CYCLE) ? 2 : 1, options->mg_smoother);
+		}
+
+		maxresiduum = mg_residual(&levels[0]);
+
+		results->stat_iteration++;
+		results->stat_precision = maxresiduum;
+
+		/* check for stopping calculation depending on termination method */
+		if (options->termination == TERM_PREC)
+		{
+			nextCheck(&check, maxresiduum, options->term_precision);
+
+			if (maxresiduum < options->term_precision)
+			{
+				term_iteration = 0;
+			}
+			else if (stagnated(&check, MG_STALL_CYCLES))
+			{
+				term_iteration        = 0;
+				results->stat_stalled = check.stalled;
+			}
+		}
+		else if (options->termination == TERM_ITER)
+		{
+			term_iteration--;
+		}
+	}
+
+	mg_free(levels, num_levels);
+
+	results->m           = 0;
+	results->stat_levels = num_levels;
+	results->stat_checks += check.checks;
+}
+
+/* ************************************************************************ */
+/* cg_residual: computes r = b - A u from the matrix and returns the        */
+/*              largest change a Jacobi step would still make, computed     */
+/*              like in the other methods, and the euclidean norm of r      */
+/* ************************************************************************ */
+static double
+cg_residual(struct calculation_arguments const* arguments, real* r, double* norm)
+{
+	int    i, j;              /* local variables for loops */
+	double star;              /* four times center value minus 4 neigh.b values */
+	double residuum;          /* change of one point */
+	double maxresiduum = 0.0; /* maximum change */
+	double rr          = 0.0; /* r * r */
+
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
+
+	typedef real(*matrix)[ld];
+
+	matrix U = (matrix)arguments->M;
+	matrix R = (matrix)r;
+
+	for (i = 1; i < N; i++)
+	{
+		double const* f = rhsLine(arguments, i, arguments->rhs_buffer);
+
+		for (j = 1; j < N; j++)
+		{
+			star    = 0.25 * ((double)U[i - 1][j] + U[i][j - 1] + U[i][j + 1] + U[i + 1][j]) + f[j];
+			R[i][j] = 4 * (star - U[i][j]);
+
+			rr         += (double)R[i][j] * R[i][j];
+			residuum    = fabs(star - U[i][j]);
+			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+		}
+	}
+
+	*norm = sqrt(rr);
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* cg_precondition: applies the preconditioner, z = M^-1 r                  */
+/* ************************************************************************ */
+static void
+cg_precondition(struct options const* options, struct mg_level* levels, int num_levels, int N, int ld, double omega, real const* r, real* z)
+{
+	int    i, j;  /* local variables for loops */
+	double star;  /* four times center value minus 4 neigh.b values */
+
+	typedef real(*matrix)[ld];
+
+	matrix R = (matrix)r;
+	matrix Z = (matrix)z;
+
+	if (options->cg_precond == PRECOND_JACOBI)
+	{
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				Z[i][j] = R[i][j] / 4;
+			}
+		}
+	}
+	else if (options->cg_precond == PRECOND_SSOR)
+	{
+		/* one forward and one backward SOR sweep on A z = r, starting at z = 0 */
+		memset(z, 0, (N + 1) * ld * sizeof(real));
+
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				star    = ((double)Z[i - 1][j] + Z[i][j - 1] + Z[i][j + 1] + Z[i + 1][j] + R[i][j]) / 4;
+				Z[i][j] = Z[i][j] + omega * (star - Z[i][j]);
+			}
+		}
+
+		for (i = N - 1; i > 0; i--)
+		{
+			for (j = N - 1; j > 0; j--)
+			{
+				star    = ((double)Z[i - 1][j] + Z[i][j - 1] + Z[i][j + 1] + Z[i + 1][j] + R[i][j]) / 4;
+				Z[i][j] = Z[i][j] + omega * (star - Z[i][j]);
+			}
+		}
+	}
+	else
+	{
+		/* one V cycle on A z = r, damped Jacobi keeps it symmetric */
+		matrix F = (matrix)levels[0].f;
+
+		double const h2 = levels[0].h * levels[0].h;
+
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				F[i][j] = R[i][j] / h2;
+			}
+		}
+
+		memset(z, 0, (N + 1) * ld * sizeof(real));
+
+		mg_cycle(levels, 0, num_levels, 1, METH_JACOBI);
+	}
+}
+
+/* ************************************************************************ */
+/* calculate_cg: solves the equation with preconditioned conjugate gradients */
+/*                                                                          */
+/* Works matrix-free on A u = 4 u - (sum of the 4 neighbours), the unscaled */
+/* 5-point stencil of the other methods. The right-hand side is 4 times     */
+/* the interference function plus the border values, which stay in the      */
+/* matrix, so the residuum can be computed directly from it. Since the      */
+/* preconditioners are only approximately symmetric (multigrid stops the    */
+/* coarse solve early), beta uses the flexible Polak-Ribiere formula. The   */
+/* reported error is the largest change a Jacobi step would still make,     */
+/* i.e. max |r| / 4. The updated r drifts away from b - A u near rounding   */
+/* level, so once it reaches the precision the true residuum is computed    */
+/* and replaces it; only that one ends the run or counts as stagnation.     */
+/* ************************************************************************ */
+static void
+calculate_cg(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int    i, j;           /* local variables for loops */
+	int    num_levels = 0; /* number of multigrid levels of the preconditioner */
+	double alpha, beta;    /* step length and direction update */
+	double rz, rz_old;     /* r * z of the current iteration and r * z of the old z */
+	double rz_new;         /* r * z of the new z */
+	double pq;             /* p * A p */
+	double rr;             /* r * r */
+	double residuum;       /* residuum of one point */
+	double maxresiduum;    /* maximum residuum value of a slave in iteration */
+	double norm;           /* euclidean norm of the true residuum */
+	uint64_t last = 0;     /* iteration of the last true residuum */
+
+	int const    N    = arguments->N;
+	int const    ld   = arguments->ld;
+	uint64_t const size = (N + 1) * ld * sizeof(real);
+
+	int term_iteration = options->term_iteration;
+
+	/* a restart with the true residuum may grow the updated one for a while */
+	uint64_t const stall = ((uint64_t)4 * N > STALL_ITERATIONS) ? (uint64_t)4 * N : STALL_ITERATIONS;
+
+	struct convergence_check check; /* the checks only watch the true residuum for stagnation */
+
+	/* SSOR converges best with a smaller factor than SOR */
+	double const omega = (options->sor_mode == SOR_FIXED) ? options->sor_omega : 2.0 / (1.0 + 2.0 * sin(M_PI / (2 * N)));
+
+	struct mg_level levels[MG_MAX_LEVELS];
+
+	typedef real(*matrix)[ld];
+
+	matrix U = (matrix)arguments->M;
+	matrix R = (matrix)allocateMemory(size);
+	matrix Z = (matrix)allocateMemory(size);
+	matrix P = (matrix)allocateMemory(size);
+	matrix Q = (matrix)allocateMemory(size);
+
+	memset(R, 0, size);
+	memset(Z, 0, size);
+	memset(P, 0, size);
+	memset(Q, 0, size);
+
+	initCheck(&check, options, 0.0);
+	check.adaptive = 0;
+
+	if (options->cg_precond == PRECOND_MULTIGRID)
+	{
+		num_levels = mg_allocate(levels, N, (real*)Z);
+	}
+
+	cg_residual(arguments, (real*)R, &norm);
+
+	cg_precondition(options, levels, num_levels, N, ld, omega, (real*)R, (real*)Z);
+
+	rz = 0.0;
+
+	for (i = 1; i < N; i++)
+	{
+		for (j = 1; j < N; j++)
+		{
+			P[i][j] = Z[i][j];
+			rz     += (double)R[i][j] * Z[i][j];
+		}
+	}
+
+	while (term_iteration > 0)
+	{
+		/* q = A p, fused with p * q */
+		pq = 0.0;
+
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				Q[i][j] = 4 * (double)P[i][j] - P[i - 1][j] - P[i][j - 1] - P[i][j + 1] - P[i + 1][j];
+				pq     += (double)P[i][j] * Q[i][j];
+			}
+		}
+
+		alpha = (pq > 0.0) ? rz / pq : 0.0;
+
+		/* u += alpha p, r -= alpha q, fused with the norms of r and r * z */
+		maxresiduum = 0.0;
+		rr          = 0.0;
+		rz_old      = 0.0;
+
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				U[i][j] += alpha * P[i][j];
+				R[i][j] -= alpha * Q[i][j];
+
+				rr     += (double)R[i][j] * R[i][j];
+				rz_old += (double)R[i][j] * Z[i][j];
+
+				residuum    = fabs(R[i][j]) / 4;
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+			}
+		}
+
+		results->stat_iteration++;
+		results->stat_precision = maxresiduum;
+		results->stat_residual  = sqrt(rr);
+
+		/* check for stopping calculation depending on termination method */
+		if (options->termination == TERM_PREC && maxresiduum < options->term_precision)
+		{
+			maxresiduum = cg_residual(arguments, (real*)R, &norm);
+
+			results->stat_precision = maxresiduum;
+			results->stat_residual  = norm;
+
+			check.distance = results->stat_iteration - last;
+			last           = results->stat_iteration;
+
+			nextCheck(&check, maxresiduum, options->term_precision);
+
+			if (maxresiduum < options->term_precision)
+			{
+				break;
+			}
+			else if (stagnated(&check, stall))
+			{
+				results->stat_stalled = check.stalled;
+				break;
+			}
+
+			/* beta needs r * z of the old z with the replaced r */
+			rz_old = 0.0;
+
+			for (i = 1; i < N; i++)
+			{
+				for (j = 1; j < N; j++)
+				{
+					rz_old += (double)R[i][j] * Z[i][j];
+				}
+			}
+		}
+		else if (options->termination == TERM_ITER)
+		{
+			if (--term_iteration == 0)
+			{
+				break;
+			}
+		}
+
+		cg_precondition(options, levels, num_levels, N, ld, omega, (real*)R, (real*)Z);
+
+		/* p = z + beta p */
+		rz_new = 0.0;
+
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				rz_new += (double)R[i][j] * Z[i][j];
+			}
+		}
+
+		beta = (rz_new - rz_old) / rz;
+		rz   = rz_new;
+
+		for (i = 1; i < N; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				P[i][j] = Z[i][j] + beta * P[i][j];
+			}
+		}
+	}
+
+	if (options->cg_precond == PRECOND_MULTIGRID)
+	{
+		mg_free(levels, num_levels);
+	}
+
+	/* the last updated r may differ from b - A u */
+	if (options->termination == TERM_ITER)
+	{
+		results->stat_precision = cg_residual(arguments, (real*)R, &norm);
+		results->stat_residual  = norm;
+	}
+
+	free(R);
+	free(Z);
+	free(P);
+	free(Q);
+
+	results->m            = 0;
+	results->stat_checks += check.checks;
+}
+
+/* ************************************************************************ */
+/* solve: solves the equation with the selected method                      */
+/* ************************************************************************ */
+static void
+solve(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	if (options->mixed > 0 && (options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI))
+	{
+		calculate_mixed(arguments, results, options);
+	}
+	else if ((options->tile_depth > 1 || options->ooc) && (options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI))
+	{
+		calculate_wavefront(arguments, results, options);
+	}
+	else if (options->method == METH_MULTIGRID)
+	{
+		calculate_multigrid(arguments, results, options);
+	}
+	else if (options->method == METH_CG)
+	{
+		calculate_cg(arguments, results, options);
+	}
+	else
+	{
+		calculate(arguments, results, options);
+	}
+}
+
+/* ************************************************************************ */
+/* interpolateMatrix: initializes the inner points of all fine matrices     */
+/*                    with the bilinear interpolation of coarse matrix m    */
+/*                                                                          */
+/* Halving the interlines only halves N for odd interlines, so the fine     */
+/* points are placed on the coarse grid by their coordinates.               */
+/* ************************************************************************ */
+static void
+interpolateMatrix(struct calculation_arguments const* coarse, uint64_t m, struct calculation_arguments* fine)
+{
+	uint64_t g, i, j; /* local variables for loops */
+
+	uint64_t const N  = fine->N;
+	uint64_t const NC = coarse->N;
+
+	typedef real(*matrix)[N + 1][fine->ld];
+	typedef real(*coarse_matrix)[coarse->ld];
+
+	matrix        Matrix = (matrix)fine->M;
+	coarse_matrix Coarse = (coarse_matrix)(coarse->M + m * (NC + 1) * coarse->ld);
+
+	for (i = 1; i < N; i++)
+	{
+		double const   x  = (double)(i * NC) / N;
+		uint64_t const ic = (x < NC - 1) ? (uint64_t)x : NC - 1;
+		double const   s  = x - ic;
+
+		for (j = 1; j < N; j++)
+		{
+			double const   y  = (double)(j * NC) / N;
+			uint64_t const jc = (y < NC - 1) ? (uint64_t)y : NC - 1;
+			double const   t  = y - jc;
+
+			double const value = (1 - s) * ((1 - t) * Coarse[ic][jc] + t * Coarse[ic][jc + 1])
+			                   + s * ((1 - t) * Coarse[ic + 1][jc] + t * Coarse[ic + 1][jc + 1]);
+
+			for (g = 0; g < fine->num_matrices; g++)
+			{
+				Matrix[g][i][j] = value;
+			}
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* warmStart: initializes the matrices with the solution for half the       */
+/*            interlines, which is found the same way                       */
+/*                                                                          */
+/* The coarser grids are solved first, down to 0 interlines, with the same  */
+/* method and termination. Their smooth error components are the ones that  */
+/* converge slowest, so the fine grid only has to remove what the coarse    */
+/* grid cannot resolve. Every level reports its result when it is done.     */
+/* ************************************************************************ */
+static void
+warmStart(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
+{
+	struct options               coarse_options = *options;
+	struct calculation_arguments coarse;
+	struct calculation_results   coarse_results;
+
+	uint64_t const interval = checkpoint.interval;
+
+	if (options->interlines == 0)
+	{
+		return;
+	}
+
+	coarse_options.interlines = options->interlines / 2;
+
+	initVariables(&coarse, &coarse_results, &coarse_options);
+	allocateMatrices(&coarse, &coarse_options);
+	initMatrices(&coarse, &coarse_options);
+	initRhs(&coarse, &coarse_options);
+
+	warmStart(&coarse, &coarse_results, &coarse_options);
+
+	/* only the finest grid writes checkpoints */
+	checkpoint.interval = 0;
+
+	solve(&coarse, &coarse_results, &coarse_options);
+
+	checkpoint.interval = interval;
+
+	printf("Vorstufe:           %" PRIu64 " Interlines, %" PRIu64 " Iterationen, Norm des Fehlers %e\n", coarse_options.interlines, coarse_results.stat_iteration, coarse_results.stat_precision);
+	fflush(stdout);
+
+	interpolateMatrix(&coarse, coarse_results.m, arguments);
+	freeMatrices(&coarse);
+
+	results->stat_warm_levels     = coarse_results.stat_warm_levels + 1;
+	results->stat_warm_iterations = coarse_results.stat_warm_iterations + coarse_results.stat_iteration;
+}
+
+/* ************************************************************************ */
+/*  displayStatistics: displays some statistics about the calculation       */
+/* ************************************************************************ */
+static void
+displayStatistics(struct calculation_arguments const* arguments, struct calculation_results const* results, struct options const* options)
+{
+	int    N    = arguments->N;
+	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
+
+	printf("Berechnungszeit:    %f s\n", time);
+	printf("Speicherbedarf:     %f MiB", (N + 1) * (N + 1) * sizeof(real) * arguments->num_matrices / 1024.0 / 1024.0);
+#ifdef FLOAT
+	printf(" (float)");
+#endif
+	if (arguments->ooc_fd >= 0)
+	{
+		printf(" (Datei)");
+	}
+	printf("\n");
+	printf("Berechnungsmethode: ");
+
+	if (options->method == METH_GAUSS_SEIDEL)
+	{
+		printf("Gauß-Seidel");
+
+		if (options->mixed > 0)
+		{
+			printf(" (mixed precision: float Gauß-Seidel, %" PRIu64 " corrections", results->stat_corrections);
+
+			if (results->stat_finish > 0)
+			{
+				printf(", %" PRIu64 " double Gauß-Seidel iterations", results->stat_finish);
+			}
+
+			printf(")");
+		}
+	}
+	else if (options->method == METH_JACOBI)
+	{
+		printf("Jacobi");
+
+		if (options->mixed > 0)
+		{
+			printf(" (mixed precision: float Jacobi, %" PRIu64 " corrections", results->stat_corrections);
+
+			if (results->stat_finish > 0)
+			{
+				printf(", %" PRIu64 " double Gauß-Seidel iterations", results->stat_finish);
+			}
+
+			printf(")");
+		}
+		else if (results->stat_kernel && getenv("PARTDIFF_SIMD") != NULL)
+		{
+			/* only on request, the default output matches the reference */
+			if (options->simd == SIMD_AVX512)
+			{
+				printf(" (AVX-512)");
+			}
+			else if (options->simd == SIMD_AVX2)
+			{
+				printf(" (AVX2)");
+			}
+			else if (options->simd == SIMD_SSE2)
+			{
+				printf(" (SSE2)");
+			}
+		}
+	}
+	else if (options->method == METH_RED_BLACK)
+	{
+		printf("Red-Black Gauß-Seidel");
+	}
+	else if (options->method == METH_SOR)
+	{
+		printf("SOR (omega = %f)", results->stat_omega);
+	}
+	else if (options->method == METH_MULTIGRID)
+	{
+		printf("Multigrid (%c cycle, %" PRIu64 " levels)", (options->mg_cycle == MG_W_CYCLE) ? 'W' : (options->mg_cycle == MG_FULL) ? 'F' : 'V', results->stat_levels);
+	}
+	else if (options->method == METH_CG)
+	{
+		printf("CG (%s preconditioner)", (options->cg_precond == PRECOND_SSOR) ? "SSOR" : (options->cg_precond == PRECOND_MULTIGRID) ? "multigrid" : "Jacobi");
+	}
+
+	if (results->stat_warm_levels > 0)
+	{
+		printf(" (warm start, %" PRIu64 " coarser levels, %" PRIu64 " iterations)", results->stat_warm_levels, results->stat_warm_iterations);
+	}
+
+	printf("\n");
+	printf("Interlines:         %" PRIu64 "\n", options->interlines);
+	printf("Stoerfunktion:      ");
+
+	if (options->inf_func == FUNC_F0)
+	{
+		printf("f(x,y) = 0");
+	}
+	else if (options->inf_func == FUNC_FPISIN)
+	{
+		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+
+		/* only on request, the default output matches the reference */
+		if (getenv("PARTDIFF_RHS_BUDGET") != NULL)
+		{
+			if (arguments->rhs_mode == RHS_PLANE)
+			{
+				printf(" (Ebene)");
+			}
+			else if (arguments->rhs_mode == RHS_VECTORS)
+			{
+				printf(" (Vektoren)");
+			}
+			else
+			{
+				printf(" (Rekurrenz)");
+			}
+		}
+	}
+
+	printf("\n");
+	printf("Terminierung:       ");
+
+	if (options->termination == TERM_PREC && options->check == CHECK_ADAPTIVE)
+	{
+		printf("Hinreichende Genaugkeit (%" PRIu64 " Prüfungen)", results->stat_checks);
+	}
+	else if (options->termination == TERM_PREC)
+	{
+		printf("Hinreichende Genaugkeit");
+	}
+	else if (options->termination == TERM_ITER)
+	{
+		printf("Anzahl der Iterationen");
+	}
+
+	if (results->stat_stalled > 0)
+	{
+		printf(", abgebrochen: Residuum stagniert seit %" PRIu64 " Iterationen", results->stat_stalled);
 	}
 
 	printf("\n");
 	printf("Anzahl Iterationen: %" PRIu64 "\n", results->stat_iteration);
+
+	if (options->restart)
+	{
+		printf("Checkpoint:         fortgesetzt nach %" PRIu64 " Iterationen\n", checkpoint.restarted);
+	}
+
 	printf("Norm des Fehlers:   %e\n", results->stat_precision);
+
+	if (options->method == METH_CG)
+	{
+		printf("Norm des Residuums: %e\n", results->stat_residual);
+	}
+
 	printf("\n");
 }
 
@@ -451,8 +3272,9 @@ displayMatrix(struct calculation_arguments* arguments, struct calculation_result
 
 	int const interlines = options->interlines;
 	int const N          = arguments->N;
+	int const ld         = arguments->ld;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
@@ -485,13 +3307,21 @@ main(int argc, char** argv)
 
 	initVariables(&arguments, &results, &options);
 
-	allocateMatrices(&arguments);
+	allocateMatrices(&arguments, &options);
 	initMatrices(&arguments, &options);
+	initRhs(&arguments, &options);
+	initCheckpoint(&arguments, &results, &options);
 
 	gettimeofday(&start_time, NULL);
-	calculate(&arguments, &results, &options);
+	if (options.warm_start && !options.restart)
+	{
+		warmStart(&arguments, &results, &options);
+	}
+	solve(&arguments, &results, &options);
 	gettimeofday(&comp_time, NULL);
 
+	finishCheckpoint();
+
 	displayStatistics(&arguments, &results, &options);
 	displayMatrix(&arguments, &results, &options);
 
@@ -24,6 +24,7 @@
 /* Include standard header file.                                            */
 /* ************************************************************************ */
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,8 +32,21 @@
 #include <inttypes.h>
 #include <math.h>
 #include <malloc.h>
+#include <pthread.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/time.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
 
 /* ************* */
 /* Some defines. */
@@ -47,17 +61,58 @@
 #define MAX_THREADS       1024
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI       2
+#define METH_RED_BLACK    3
 #define FUNC_F0           1
 #define FUNC_FPISIN       2
 #define TERM_PREC         1
 #define TERM_ITER         2
+#define RHS_NONE          0
+#define RHS_RECURRENCE    1
+#define RHS_VECTORS       2
+#define RHS_PLANE         3
+#define RHS_BUDGET        2048 /* KiB, holds the vectors up to MAX_INTERLINES */
+#define MAX_RHS_BUDGET    (UINT64_C(1) << 30)
+#define CACHE_LINE        64
+#define SIMD_SCALAR       0
+#define SIMD_SSE2         1
+#define SIMD_AVX2         2
+#define SIMD_AVX512       3
+#define CHECK_EVERY       0
+#define CHECK_ADAPTIVE    1
+#define CHECK_MAX_DISTANCE 64
+#define CHECK_SAFETY      0.5
+#define STALL_ITERATIONS  1000
+#define HUGEPAGES_OFF     0
+#define HUGEPAGES_TRANSPARENT 1
+#define HUGEPAGES_EXPLICIT 2
+#define HUGEPAGE_SIZE     (UINT64_C(2) << 20)
+#define MAX_CHECKPOINT    86400
+#define CHECKPOINT_FILE   "partdiff.checkpoint"
+#define CHECKPOINT_MAGIC  "partdiff"
+
+/* matrix entries, -D FLOAT halves the memory traffic; sums stay double */
+#ifdef FLOAT
+typedef float real;
+#define MIN_PRECISION     1e-6
+#else
+typedef double real;
+#define MIN_PRECISION     1e-20
+#endif
 
 struct calculation_arguments
 {
 	uint64_t N;            /* number of spaces between lines (lines=N+1) */
+	uint64_t ld;           /* leading dimension, reals per padded matrix row */
 	uint64_t num_matrices; /* number of matrices */
 	double   h;            /* length of a space between two lines */
-	double*  M;            /* two matrices with real values */
+	real*    M;            /* two matrices with real values */
+	uint64_t rhs_mode;     /* how the right-hand side is provided */
+	double   rhs_sin;      /* sin(pi * h), start of the recurrence */
+	double   rhs_cos;      /* 2 * cos(pi * h), factor of the recurrence */
+	double*  rhs_row;      /* row factors 2 * pi^2 * h^2 * sin(pi * h * i) / 4 */
+	double*  rhs_col;      /* column factors sin(pi * h * j) */
+	double*  rhs_plane;    /* complete right-hand side */
+	double*  rhs_buffer;   /* two rows of the right-hand side per thread */
 };
 
 struct calculation_results
@@ -65,6 +120,8 @@ struct calculation_results
 	uint64_t m;
 	uint64_t stat_iteration; /* number of current iteration */
 	double   stat_precision; /* actual precision of all slaves in iteration */
+	uint64_t stat_checks;    /* number of convergence checks */
+	uint64_t stat_stalled;   /* iterations without a smaller residuum, if that stopped the run */
 };
 
 struct options
@@ -76,6 +133,19 @@ struct options
 	uint64_t termination;    /* termination condition */
 	uint64_t term_iteration; /* terminate if iteration number reached */
 	double   term_precision; /* terminate if precision reached */
+	uint64_t rhs_budget;     /* memory for the right-hand side in KiB */
+	uint64_t simd;           /* instruction set of the Jacobi kernel */
+	uint64_t check;          /* when the convergence is checked */
+	uint64_t hugepages;      /* page size of the matrices */
+	uint64_t checkpoint;     /* seconds between checkpoints, 0: off */
+	uint64_t restart;        /* continue from the last checkpoint */
+	uint64_t chebyshev;      /* Jacobi with Chebyshev acceleration */
+};
+
+struct mapping
+{
+	void*  addr; /* start of the mapped memory, NULL if there is none */
+	size_t size; /* length of the mapping in bytes */
 };
 
 struct vector
@@ -85,6 +155,50 @@ struct vector
 	size_t max_size;
 };
 
+struct convergence_check
+{
+	uint64_t adaptive; /* check only as often as the contraction requires */
+	double   rho;      /* spectral radius estimate of the method */
+	double   residuum; /* maximum residuum at the last check, 0 before */
+	uint64_t distance; /* iterations between the last and the next check */
+	uint64_t checks;   /* number of checks so far */
+	double   best;     /* smallest residuum of all checks */
+	uint64_t stalled;  /* iterations since the residuum last reached a new minimum */
+};
+
+struct checkpoint_header
+{
+	char     magic[8];       /* CHECKPOINT_MAGIC */
+	uint64_t real_size;      /* bytes per matrix entry */
+	uint64_t method;         /* parameters a restart has to match */
+	uint64_t interlines;
+	uint64_t inf_func;
+	uint64_t termination;
+	uint64_t stat_iteration; /* iterations done so far */
+	double   stat_precision; /* precision of the last checked iteration */
+	double   stat_omega;     /* relaxation factor (SOR) */
+	uint64_t m;              /* matrix with the newest values */
+	uint64_t left;           /* iterations until the next convergence check */
+	struct convergence_check check; /* state of the convergence checks */
+};
+
+struct checkpoint
+{
+	uint64_t       interval;  /* seconds between checkpoints, 0: off */
+	char const*    path;      /* checkpoint file */
+	char*          temp;      /* file a checkpoint is written to first */
+	struct timeval last;      /* time of the last checkpoint */
+	uint64_t       restarted; /* iterations done before a restart */
+	real*          buffer;    /* snapshot of the matrix, rows without padding */
+	size_t         size;      /* bytes in the snapshot */
+	pthread_t      thread;    /* background writer */
+	int            running;   /* the writer has been started and not joined */
+	int            done;      /* the writer has finished */
+	struct checkpoint_header header; /* state written with the snapshot */
+};
+
+typedef double (*jacobi_kernel)(real const*, real*, double const*, double const*, int, int, int);
+
 static void push(void*);
 static void* pop();
 
@@ -96,16 +210,23 @@ static void* pop();
 struct timeval start_time; /* time when program started */
 struct timeval comp_time;  /* time when calculation completed */
 struct vector allocated_memory;
+struct mapping matrix_memory;
+
+/* periodic checkpoints of the calculation */
+struct checkpoint checkpoint;
 
 static void
 usage(char* name)
 {
-	printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter]\n", name);
+	printf("Usage: %s [--restart] [num] [method] [lines] [func] [term] [prec/iter]\n", name);
 	printf("\n");
+	printf("  - --restart: continue from the last checkpoint, which has to be written\n");
+	printf("               with the same method, lines, func and term\n");
 	printf("  - num:       number of threads (1 .. %d)\n", MAX_THREADS);
-	printf("  - method:    calculation method (1 .. 2)\n");
+	printf("  - method:    calculation method (1 .. 3)\n");
 	printf("                 %1d: Gauß-Seidel\n", METH_GAUSS_SEIDEL);
 	printf("                 %1d: Jacobi\n", METH_JACOBI);
+	printf("                 %1d: Red-Black Gauß-Seidel\n", METH_RED_BLACK);
 	printf("  - lines:     number of interlines (0 .. %d)\n", MAX_INTERLINES);
 	printf("                 matrixsize = (interlines * 8) + 9\n");
 	printf("  - func:      interference function (1 .. 2)\n");
@@ -115,17 +236,98 @@ usage(char* name)
 	printf("                 %1d: sufficient precision\n", TERM_PREC);
 	printf("                 %1d: number of iterations\n", TERM_ITER);
 	printf("  - prec/iter: depending on term:\n");
-	printf("                 precision:  1e-4 .. 1e-20\n");
+	printf("                 precision:  1e-4 .. %g\n", MIN_PRECISION);
 	printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
 	printf("\n");
+	printf("Environment:\n");
+	printf("  - PARTDIFF_RHS_BUDGET: memory for the right-hand side in KiB (default %d)\n", RHS_BUDGET);
+	printf("                 the whole plane if it fits, otherwise row and column vectors,\n");
+	printf("                 the default always holds them, a smaller budget generates\n");
+	printf("                 every row by a less exact recurrence\n");
+	printf("  - PARTDIFF_SIMD: highest instruction set of the Jacobi kernel (default %d)\n", SIMD_AVX512);
+	printf("                 %1d: scalar, %1d: SSE2, %1d: AVX2, %1d: AVX-512, limited by the CPU\n", SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512);
+	printf("                 only used by the row distribution\n");
+	printf("  - PARTDIFF_CHECK: convergence checks with precision termination (default %d)\n", CHECK_EVERY);
+	printf("                 %1d: every iteration\n", CHECK_EVERY);
+	printf("                 %1d: adaptive, estimated from the residuum contraction,\n", CHECK_ADAPTIVE);
+	printf("                    at most %d iterations apart\n", CHECK_MAX_DISTANCE);
+	printf("  - PARTDIFF_HUGEPAGES: page size of the matrices (default %d)\n", HUGEPAGES_OFF);
+	printf("                 %1d: normal pages\n", HUGEPAGES_OFF);
+	printf("                 %1d: transparent huge pages\n", HUGEPAGES_TRANSPARENT);
+	printf("                 %1d: explicit huge pages, transparent ones if none are reserved\n", HUGEPAGES_EXPLICIT);
+	printf("  - PARTDIFF_CHECKPOINT: seconds between checkpoints (0 .. %d, default 0: off)\n", MAX_CHECKPOINT);
+	printf("                 written in the background to $PARTDIFF_CHECKPOINT_FILE\n");
+	printf("                 (default %s)\n", CHECKPOINT_FILE);
+	printf("  - PARTDIFF_CHEBYSHEV: Chebyshev acceleration of Jacobi (0 .. 1, default 0)\n");
+	printf("                 without the SIMD kernels\n");
+	printf("\n");
 	printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
 
+/* ************************************************************************ */
+/* askEnvParam: reads an optional tuning parameter from the environment     */
+/* ************************************************************************ */
+static uint64_t
+askEnvParam(char* name, char const* variable, uint64_t min, uint64_t max, uint64_t fallback)
+{
+	char const* value = getenv(variable);
+	uint64_t    param;
+
+	if (value == NULL)
+	{
+		return fallback;
+	}
+
+	if (sscanf(value, "%" SCNu64, &param) != 1 || !(param >= min && param <= max))
+	{
+		usage(name);
+		exit(1);
+	}
+
+	return param;
+}
+
+/* ************************************************************************ */
+/* cpuSimdLevel: returns the highest instruction set supported by the CPU   */
+/* ************************************************************************ */
+static uint64_t
+cpuSimdLevel(void)
+{
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return SIMD_AVX512;
+	}
+	else if (__builtin_cpu_supports("avx2"))
+	{
+		return SIMD_AVX2;
+	}
+	else if (__builtin_cpu_supports("sse2"))
+	{
+		return SIMD_SSE2;
+	}
+#endif
+
+	return SIMD_SCALAR;
+}
+
 static void
 askParams(struct options* options, int argc, char** argv)
 {
 	int ret;
 
+	options->restart = argc > 1 && strcmp(argv[1], "--restart") == 0;
+
+	/* the remaining parameters are the usual ones */
+	if (options->restart)
+	{
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+
 	if (argc < 7 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "-?") == 0)
 	{
 		usage(argv[0]);
@@ -142,7 +344,7 @@ askParams(struct options* options, int argc, char** argv)
 
 	ret = sscanf(argv[2], "%" SCNu64, &(options->method));
 
-	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI))
+	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI || options->method == METH_RED_BLACK))
 	{
 		usage(argv[0]);
 		exit(1);
@@ -178,7 +380,7 @@ askParams(struct options* options, int argc, char** argv)
 
 		options->term_iteration = MAX_ITERATION;
 
-		if (ret != 1 || !(options->term_precision >= 1e-20 && options->term_precision <= 1e-4))
+		if (ret != 1 || !(options->term_precision >= MIN_PRECISION && options->term_precision <= 1e-4))
 		{
 			usage(argv[0]);
 			exit(1);
@@ -196,6 +398,48 @@ askParams(struct options* options, int argc, char** argv)
 			exit(1);
 		}
 	}
+
+	options->rhs_budget = askEnvParam(argv[0], "PARTDIFF_RHS_BUDGET", 0, MAX_RHS_BUDGET, RHS_BUDGET);
+	options->simd       = askEnvParam(argv[0], "PARTDIFF_SIMD", SIMD_SCALAR, SIMD_AVX512, SIMD_AVX512);
+	options->check      = askEnvParam(argv[0], "PARTDIFF_CHECK", CHECK_EVERY, CHECK_ADAPTIVE, CHECK_EVERY);
+	options->hugepages  = askEnvParam(argv[0], "PARTDIFF_HUGEPAGES", HUGEPAGES_OFF, HUGEPAGES_EXPLICIT, HUGEPAGES_OFF);
+	options->checkpoint = askEnvParam(argv[0], "PARTDIFF_CHECKPOINT", 0, MAX_CHECKPOINT, 0);
+	options->chebyshev  = askEnvParam(argv[0], "PARTDIFF_CHEBYSHEV", 0, 1, 0);
+
+	if (options->simd > cpuSimdLevel())
+	{
+		options->simd = cpuSimdLevel();
+	}
+
+	/* the kernels only do plain Jacobi sweeps */
+	if (options->chebyshev && options->method == METH_JACOBI)
+	{
+		options->simd = SIMD_SCALAR;
+	}
+
+#ifndef ROW
+	/* only the row distribution has SIMD kernels */
+	options->simd = SIMD_SCALAR;
+#endif
+}
+
+/* ************************************************************************ */
+/* rowLength: returns the leading dimension of a matrix with N + 1 columns  */
+/*            of size bytes each                                            */
+/*                                                                          */
+/* Rows are padded to an odd number of cache lines. Every row then starts   */
+/* at a cache line, so no stencil load is split, and consecutive rows walk  */
+/* through all cache sets instead of aliasing at power-of-two strides.      */
+/* ************************************************************************ */
+static uint64_t
+rowLength(uint64_t N, size_t size)
+{
+	uint64_t const line  = CACHE_LINE / size;
+	uint64_t       lines = (N + line) / line;
+
+	lines += (lines % 2 == 0) ? 1 : 0;
+
+	return lines * line;
 }
 
 /* ************************************************************************ */
@@ -205,12 +449,15 @@ static void
 initVariables(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
 {
 	arguments->N            = (options->interlines * 8) + 9 - 1;
+	arguments->ld           = rowLength(arguments->N, sizeof(real));
 	arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
 	arguments->h            = 1.0 / arguments->N;
 
 	results->m              = 0;
 	results->stat_iteration = 0;
 	results->stat_precision = 0;
+	results->stat_checks    = 0;
+	results->stat_stalled   = 0;
 }
 
 /* ************************************************************************ */
@@ -221,6 +468,11 @@ cleanup() {
 	for (void* p = pop(); p != NULL; p = pop())
 		free(p);
 	free(allocated_memory.buf);
+
+	if (matrix_memory.addr != NULL)
+	{
+		munmap(matrix_memory.addr, matrix_memory.size);
+	}
 }
 
 /* ************************************************************************ */
@@ -295,49 +547,147 @@ pop()
 	return p;
 }
 
+/* ************************************************************************ */
+/* allocateMatrixMemory: maps zeroed memory for the matrices                */
+/*                                                                          */
+/* Anonymous mappings start out on the shared zero page, so the matrices    */
+/* need no zero pass and every page is placed on the NUMA node of the       */
+/* thread that writes it first. With huge pages the mapping is aligned to   */
+/* HUGEPAGE_SIZE, so the kernel can back all of it with them.               */
+/* ************************************************************************ */
+static void*
+allocateMatrixMemory(size_t size, uint64_t hugepages)
+{
+	size_t const align  = (hugepages == HUGEPAGES_OFF) ? (size_t)sysconf(_SC_PAGESIZE) : HUGEPAGE_SIZE;
+	size_t const length = (size + align - 1) & ~(align - 1);
+	size_t const extra  = (hugepages == HUGEPAGES_OFF) ? 0 : align;
+	char*        p      = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (hugepages == HUGEPAGES_EXPLICIT)
+	{
+		p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+		if (p == MAP_FAILED)
+		{
+			printf("Keine Huge Pages reserviert, verwende transparente Huge Pages\n");
+		}
+	}
+#endif
+
+	if (p == MAP_FAILED)
+	{
+		/* map one alignment more and give back the unaligned ends */
+		char* q = mmap(NULL, length + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (q == MAP_FAILED)
+		{
+			printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", length + extra);
+			cleanup();
+			exit(1);
+		}
+
+		p = (char*)(((uintptr_t)q + align - 1) & ~(uintptr_t)(align - 1));
+
+		if (p > q)
+		{
+			munmap(q, p - q);
+		}
+
+		if (q + extra > p)
+		{
+			munmap(p + length, q + extra - p);
+		}
+
+#ifdef MADV_HUGEPAGE
+		if (hugepages != HUGEPAGES_OFF)
+		{
+			madvise(p, length, MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	matrix_memory.addr = p;
+	matrix_memory.size = length;
+
+	return p;
+}
+
 /* ************************************************************************ */
 /* allocateMatrices: allocates memory for matrices                          */
 /* ************************************************************************ */
 static void
-allocateMatrices(struct calculation_arguments* arguments)
+allocateMatrices(struct calculation_arguments* arguments, struct options const* options)
 {
 	uint64_t const N = arguments->N;
 
-	arguments->M = allocateMemory(arguments->num_matrices * (N + 1) * (N + 1) * sizeof(double));
+	arguments->M = allocateMatrixMemory(arguments->num_matrices * (N + 1) * arguments->ld * sizeof(real), options->hugepages);
 }
 
 /* ************************************************************************ */
 /* initMatrices: Initialize matrix/matrices and some global variables       */
+/*                                                                          */
+/* The mapped memory is already zero. The inner points are written once by  */
+/* the same distribution as in calculate, so the first touch puts every     */
+/* page on the NUMA node of the thread that computes it.                    */
 /* ************************************************************************ */
 static void
 initMatrices(struct calculation_arguments* arguments, struct options const* options)
 {
 	uint64_t g, i, j; /* local variables for loops */
 
-	uint64_t const N = arguments->N;
-	double const   h = arguments->h;
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+	double const   h  = arguments->h;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
-	/* initialize matrix/matrices with zeros */
-	#pragma omp parallel for collapse(2) private(g,i,j) schedule(runtime)
+	/* place the inner points on the NUMA nodes of their threads */
 	for (g = 0; g < arguments->num_matrices; g++)
 	{
-		for (i = 0; i <= N; i++)
+#if defined(ROW)
+		/* Jacobi computes two rows per call */
+		uint64_t const rows = (options->method == METH_JACOBI) ? 2 : 1;
+		uint64_t       k;
+
+		#pragma omp parallel for private(j,k) schedule(runtime)
+		for (i = 1; i < N; i += rows)
 		{
-			for (j = 0; j <= N; j++)
+			for (k = i; k < i + rows && k < N; k++)
+			{
+				for (j = 1; j < N; j++)
+				{
+					Matrix[g][k][j] = 0.0;
+				}
+			}
+		}
+#elif defined(COLUMN)
+		#pragma omp parallel for private(i) schedule(runtime)
+		for (j = 1; j < N; j++)
+		{
+			for (i = 1; i < N; i++)
+			{
+				Matrix[g][i][j] = 0.0;
+			}
+		}
+#else
+		#pragma omp parallel for collapse(2) schedule(runtime)
+		for (j = 1; j < N; j++)
+		{
+			for (i = 1; i < N; i++)
 			{
 				Matrix[g][i][j] = 0.0;
 			}
 		}
+#endif
 	}
 
 	/* initialize borders, depending on function (function 2: nothing to do) */
 	if (options->inf_func == FUNC_F0)
 	{
-		#pragma omp parallel for private(g,i,j) schedule(runtime)
+		#pragma omp parallel for private(g,i) schedule(runtime)
 		for (g = 0; g < arguments->num_matrices; g++)
 		{
 			for (i = 0; i <= N; i++)
@@ -354,202 +704,793 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 	}
 }
 
-#ifdef ELEMENT
 /* ************************************************************************ */
-/* calculate: solves the equation                                           */
+/* initRhs: prepares the right-hand side within the memory budget           */
+/*                                                                          */
+/* The interference function is the product of a row and a column factor.   */
+/* If the whole plane fits into the budget it is precomputed, otherwise     */
+/* both factor vectors are kept and multiplied for every row. Without even  */
+/* those, every row is generated by sin((j + 1) x) = 2 cos(x) sin(j x) -    */
+/* sin((j - 1) x), which only costs one sin() per row. The element-wise     */
+/* distribution needs random access, so it keeps at least both vectors.     */
 /* ************************************************************************ */
 static void
-calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+initRhs(struct calculation_arguments* arguments, struct options const* options)
 {
-	int    i, j;        /* local variables for loops */
-	int    m1, m2;      /* used as indices for old and new matrices */
-	double star;        /* four times center value minus 4 neigh.b values */
-	double residuum;    /* residuum of current iteration */
-	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	uint64_t i, j; /* local variables for loops */
 
-	int const    N = arguments->N;
-	double const h = arguments->h;
+	uint64_t const N      = arguments->N;
+	double const   h      = arguments->h;
+	uint64_t const budget = options->rhs_budget * 1024;
 
-	double pih    = 0.0;
-	double fpisin = 0.0;
+	arguments->rhs_mode   = RHS_NONE;
+	arguments->rhs_sin    = sin(M_PI * h);
+	arguments->rhs_cos    = 2 * cos(M_PI * h);
+	arguments->rhs_row    = NULL;
+	arguments->rhs_col    = NULL;
+	arguments->rhs_plane  = NULL;
+	arguments->rhs_buffer = allocateMemory(2 * options->number * (N + 1) * sizeof(double));
 
-	typedef double(*matrix)[N + 1][N + 1];
+	/* f(x,y) = 0 leaves the buffers at 0 */
+	memset(arguments->rhs_buffer, 0, 2 * options->number * (N + 1) * sizeof(double));
 
-	matrix Matrix = (matrix)arguments->M;
+	if (options->inf_func != FUNC_FPISIN)
+	{
+		return;
+	}
 
-	if (options->inf_func == FUNC_FPISIN)
+	if ((N + 1) * (N + 1) * sizeof(double) <= budget)
+	{
+		arguments->rhs_mode = RHS_PLANE;
+	}
+#ifndef ELEMENT
+	else if (2 * (N + 1) * sizeof(double) > budget)
+	{
+		arguments->rhs_mode = RHS_RECURRENCE;
+		return;
+	}
+#endif
+	else
 	{
-		pih    = M_PI * h;
-		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+		arguments->rhs_mode = RHS_VECTORS;
 	}
 
-	uint64_t stat_iteration = 0;
-	double stat_precision = 0.0;
-	uint64_t term_iteration;
+	arguments->rhs_row = allocateMemory((N + 1) * sizeof(double));
+	arguments->rhs_col = allocateMemory((N + 1) * sizeof(double));
 
-	#pragma omp parallel default(none) shared(options,maxresiduum,N,pih,fpisin,Matrix,results) private(i,j,m1,m2,star,residuum,term_iteration) reduction(+:stat_iteration) reduction(max:stat_precision)
+	for (i = 0; i <= N; i++)
 	{
-		/* initialize m1 and m2 depending on algorithm */
-		if (options->method == METH_JACOBI)
-		{
-			m1 = 0;
-			m2 = 1;
-		}
-		else
-		{
-			m1 = 0;
-			m2 = 0;
-		}
-		
-		stat_iteration = 0;
-		stat_precision = 0.0;
-		term_iteration = options->term_iteration;
+		arguments->rhs_row[i] = ((2 * M_PI * M_PI) * h * h * sin(M_PI * h * (double)i)) / 4;
+		arguments->rhs_col[i] = sin(M_PI * h * (double)i);
+	}
 
-		while (term_iteration > 0)
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		arguments->rhs_plane = allocateMemory((N + 1) * (N + 1) * sizeof(double));
+
+		#pragma omp parallel for private(i,j) schedule(runtime)
+		for (i = 0; i <= N; i++)
 		{
-			maxresiduum = 0;
-			/* over all columns */
-			#pragma omp for reduction(max:maxresiduum) collapse(2) schedule(runtime)
-			for (j = 1; j < N; j++)
+			for (j = 0; j <= N; j++)
 			{
-				/* over all rows */
-				for (i = 1; i < N; i++)
-				{
-					double fpisin_i = 0.0;
+				arguments->rhs_plane[i * (N + 1) + j] = arguments->rhs_row[i] * arguments->rhs_col[j];
+			}
+		}
+	}
+}
 
-					if (options->inf_func == FUNC_FPISIN)
-					{
-						fpisin_i = fpisin * sin(pih * (double)i);
-					}
+/* ************************************************************************ */
+/* rhsLine: returns row i of the interference function, scaled by h^2 / 4   */
+/*          like the stencil; generated rows go into buffer k (0 or 1) of   */
+/*          the calling thread. f is symmetric, so row j is also column j.  */
+/* ************************************************************************ */
+static inline double const*
+rhsLine(struct calculation_arguments const* arguments, int i, int k)
+{
+	int    j;  /* local variable for loop */
+	double fi; /* row factor */
 
-					star = 0.25 * (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
+	int const N = arguments->N;
 
-					if (options->inf_func == FUNC_FPISIN)
-					{
-						star += fpisin_i * sin(pih * (double)j);
-					}
+#ifdef _OPENMP
+	double* buffer = arguments->rhs_buffer + (2 * omp_get_thread_num() + k) * (N + 1);
+#else
+	double* buffer = arguments->rhs_buffer + k * (N + 1);
+#endif
 
-					if (options->termination == TERM_PREC || term_iteration == 1)
-					{
-						residuum    = Matrix[m2][i][j] - star;
-						residuum    = fabs(residuum);
-						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
-					}
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		return arguments->rhs_plane + i * (N + 1);
+	}
+	else if (arguments->rhs_mode == RHS_VECTORS)
+	{
+		fi = arguments->rhs_row[i];
 
-					Matrix[m1][i][j] = star;
-				}
-			}
-			/* exchange m1 and m2 */
-			i  = m1;
-			m1 = m2;
-			m2 = i;
-			stat_iteration++;
-			stat_precision = maxresiduum;
-			/* check for stopping calculation depending on termination method */
-			if (options->termination == TERM_PREC)
-			{
-				if (maxresiduum < options->term_precision)
-				{
-					term_iteration = 0;
-				}
-			}
-			else if (options->termination == TERM_ITER)
-			{
-				term_iteration--;
-			}
+		for (j = 0; j <= N; j++)
+		{
+			buffer[j] = fi * arguments->rhs_col[j];
 		}
-		#pragma omp single nowait
+	}
+	else if (arguments->rhs_mode == RHS_RECURRENCE)
+	{
+		fi = ((2 * M_PI * M_PI) * arguments->h * arguments->h * sin(M_PI * arguments->h * (double)i)) / 4;
+
+		buffer[0] = 0.0;
+		buffer[1] = fi * arguments->rhs_sin;
+
+		for (j = 1; j < N; j++)
 		{
-			results->m = m2;
+			buffer[j + 1] = arguments->rhs_cos * buffer[j] - buffer[j - 1];
 		}
 	}
-	results->stat_iteration = stat_iteration / options->number;
-	results->stat_precision = stat_precision;
+
+	return buffer;
 }
-#endif
-#ifdef COLUMN
+
 /* ************************************************************************ */
-/* calculate: solves the equation                                           */
+/* initCheck: prepares the convergence checks for a method whose residuum   */
+/*            contracts by about rho per iteration, the first check comes   */
+/*            after the first iteration                                     */
 /* ************************************************************************ */
 static void
-calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+initCheck(struct convergence_check* check, struct options const* options, double rho)
 {
-	int    i, j;        /* local variables for loops */
-	int    m1, m2;      /* used as indices for old and new matrices */
-	double star;        /* four times center value minus 4 neigh.b values */
-	double residuum;    /* residuum of current iteration */
-	double maxresiduum; /* maximum residuum value of a slave in iteration */
-
-	int const    N = arguments->N;
-	double const h = arguments->h;
+	check->adaptive = options->check == CHECK_ADAPTIVE;
+	check->rho      = rho;
+	check->residuum = 0.0;
+	check->distance = 1;
+	check->checks   = 0;
+	check->best     = 0.0;
+	check->stalled  = 0;
+}
 
-	double pih    = 0.0;
-	double fpisin = 0.0;
+/* ************************************************************************ */
+/* nextCheck: records the residuum of a check and returns the number of     */
+/*            iterations until the next one                                 */
+/*                                                                          */
+/* The contraction rate is measured between the last two checks and capped  */
+/* by rho, because it only slows down towards the spectral radius. The next */
+/* check comes after CHECK_SAFETY times the iterations the residuum still   */
+/* needs at that rate, so it rarely stops later than checking every time.   */
+/* ************************************************************************ */
+static uint64_t
+nextCheck(struct convergence_check* check, double maxresiduum, double term_precision)
+{
+	double rate = check->rho; /* residuum contraction per iteration */
+	double remaining;         /* iterations until the precision is reached */
 
-	typedef double(*matrix)[N + 1][N + 1];
+	if (check->residuum > 0.0 && maxresiduum < check->residuum)
+	{
+		double measured = pow(maxresiduum / check->residuum, 1.0 / check->distance);
 
-	matrix Matrix = (matrix)arguments->M;
+		rate = (measured < rate) ? measured : rate;
+	}
 
-	if (options->inf_func == FUNC_FPISIN)
+	if (check->checks == 0 || maxresiduum < check->best)
+	{
+		check->best    = maxresiduum;
+		check->stalled = 0;
+	}
+	else
 	{
-		pih    = M_PI * h;
-		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+		check->stalled += check->distance;
 	}
 
-	uint64_t stat_iteration = 0;
-	double stat_precision = 0.0;
-	uint64_t term_iteration;
+	check->residuum = maxresiduum;
+	check->checks++;
+	check->distance = 1;
 
-	#pragma omp parallel default(none) shared(options,maxresiduum,N,pih,fpisin,Matrix,results) private(i,j,m1,m2,star,residuum,term_iteration) reduction(+:stat_iteration) reduction(max:stat_precision)
+	if (check->adaptive && rate > 0.0 && rate < 1.0 && maxresiduum > term_precision)
 	{
-		/* initialize m1 and m2 depending on algorithm */
-		if (options->method == METH_JACOBI)
+		remaining = CHECK_SAFETY * log(term_precision / maxresiduum) / log(rate);
+
+		if (remaining >= CHECK_MAX_DISTANCE)
 		{
-			m1 = 0;
-			m2 = 1;
+			check->distance = CHECK_MAX_DISTANCE;
 		}
-		else
+		else if (remaining >= 1.0)
 		{
-			m1 = 0;
-			m2 = 0;
+			check->distance = remaining;
+		}
+	}
+
+	return check->distance;
+}
+
+/* ************************************************************************ */
+/* stagnated: returns whether the residuum has not reached a new minimum    */
+/*            for a long time, i.e. it hit the rounding level of the        */
+/*            method above the requested precision                          */
+/*                                                                          */
+/* Chebyshev keeps changing the last bits of the solution, so its residuum  */
+/* does not reach every precision down to MIN_PRECISION. The window grows   */
+/* with N because the residuum of over-relaxed methods can grow for about   */
+/* N iterations before it decreases.                                        */
+/* ************************************************************************ */
+static int
+stagnated(struct convergence_check const* check, uint64_t N)
+{
+	uint64_t const window = (4 * N > STALL_ITERATIONS) ? 4 * N : STALL_ITERATIONS;
+
+	return check->stalled >= window;
+}
+
+/* ************************************************************************ */
+/* checkRate: spectral radius estimate of a method for initCheck            */
+/* ************************************************************************ */
+static double
+checkRate(struct calculation_arguments const* arguments, struct options const* options)
+{
+	double rho = cos(M_PI / arguments->N);
+
+	/* Chebyshev approaches the contraction of SOR with the optimal factor */
+	if (options->method == METH_JACOBI && options->chebyshev)
+	{
+		return (1 - sqrt(1 - rho * rho)) / (1 + sqrt(1 - rho * rho));
+	}
+
+	return (options->method == METH_JACOBI) ? rho : rho * rho;
+}
+
+/* ************************************************************************ */
+/* chebyshevWeight: returns the weight of iteration k of Jacobi with        */
+/*                  Chebyshev acceleration, omega is the one of k - 1       */
+/*                                                                          */
+/* u(k) = u(k - 2) + omega(k) (J u(k - 1) - u(k - 2)) with a Jacobi sweep J */
+/* and omega(1) = 1, omega(2) = 1 / (1 - rho^2 / 2), omega(k) = 1 / (1 -    */
+/* rho^2 omega(k - 1) / 4). The eigenvalues of J on the 5-point stencil lie */
+/* in [-rho, rho] with rho = cos(pi / N), so no estimate is needed.         */
+/* u(k - 2) is the old content of the matrix that u(k) is written to, and   */
+/* the weights only depend on k, so every thread computes them itself.      */
+/* ************************************************************************ */
+static double
+chebyshevWeight(uint64_t k, double omega, double rho)
+{
+	if (k <= 1)
+	{
+		return 1.0;
+	}
+	else if (k == 2)
+	{
+		return 1.0 / (1.0 - rho * rho / 2);
+	}
+
+	return 1.0 / (1.0 - rho * rho * omega / 4);
+}
+
+/* ************************************************************************ */
+/* writeFully: writes size bytes, returns 0 on success                      */
+/* ************************************************************************ */
+static int
+writeFully(int fd, void const* data, size_t size)
+{
+	char const* from = data;
+	ssize_t     ret;
+
+	while (size > 0 && (ret = write(fd, from, size)) > 0)
+	{
+		from += ret;
+		size -= ret;
+	}
+
+	return (size == 0) ? 0 : -1;
+}
+
+/* ************************************************************************ */
+/* checkpointWriter: writes the snapshot to a temporary file in the         */
+/*                   background and renames it over the last checkpoint     */
+/*                                                                          */
+/* The file is synced before the rename, so a crash never leaves a half     */
+/* written checkpoint, and then dropped from the page cache again, so it    */
+/* does not evict the matrix.                                               */
+/* ************************************************************************ */
+static void*
+checkpointWriter(void* data)
+{
+	struct checkpoint* cp = data;
+
+	int fd  = open(cp->temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	int ret = (fd >= 0) ? 0 : -1;
+
+	ret = (ret == 0) ? writeFully(fd, &cp->header, sizeof(cp->header)) : ret;
+	ret = (ret == 0) ? writeFully(fd, cp->buffer, cp->size) : ret;
+	ret = (ret == 0) ? fdatasync(fd) : ret;
+
+	if (fd >= 0)
+	{
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+
+	if (ret != 0 || rename(cp->temp, cp->path) != 0)
+	{
+		printf("Checkpoint konnte nicht geschrieben werden (%s)\n", cp->path);
+	}
+
+	__atomic_store_n(&cp->done, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/* ************************************************************************ */
+/* checkpointDue: returns whether the interval since the last checkpoint    */
+/*                has passed                                                */
+/*                                                                          */
+/* While the writer is still busy with the last checkpoint, the next one is */
+/* postponed instead of waiting for it.                                     */
+/* ************************************************************************ */
+static int
+checkpointDue(void)
+{
+	struct checkpoint* cp = &checkpoint;
+	struct timeval     now;
+
+	if (cp->interval == 0)
+	{
+		return 0;
+	}
+
+	gettimeofday(&now, NULL);
+
+	if (cp->last.tv_sec == 0 && cp->last.tv_usec == 0)
+	{
+		cp->last = now;
+	}
+
+	return (uint64_t)(now.tv_sec - cp->last.tv_sec) >= cp->interval && !(cp->running && !__atomic_load_n(&cp->done, __ATOMIC_ACQUIRE));
+}
+
+/* ************************************************************************ */
+/* saveCheckpoint: starts writing matrix m and the state of the iteration   */
+/*                                                                          */
+/* The calculation only pays for copying the matrix into the snapshot, the  */
+/* file is written by a background thread.                                  */
+/* ************************************************************************ */
+static void
+saveCheckpoint(struct calculation_arguments const* arguments, int m, uint64_t stat_iteration, double stat_precision, uint64_t left, struct convergence_check const* check)
+{
+	struct checkpoint* cp = &checkpoint;
+	uint64_t           i;
+
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+
+	if (cp->running)
+	{
+		pthread_join(cp->thread, NULL);
+	}
+
+	if (cp->buffer == NULL)
+	{
+		cp->size   = (N + 1) * (N + 1) * sizeof(real);
+		cp->buffer = allocateMemory(cp->size);
+	}
+
+	/* rows without their padding */
+	for (i = 0; i <= N; i++)
+	{
+		memcpy(cp->buffer + i * (N + 1), arguments->M + (m * (N + 1) + i) * ld, (N + 1) * sizeof(real));
+	}
+
+	cp->header.stat_iteration = stat_iteration;
+	cp->header.stat_precision = stat_precision;
+	cp->header.m              = m;
+	cp->header.left           = left;
+	cp->header.check          = *check;
+
+	gettimeofday(&cp->last, NULL);
+
+	cp->done    = 0;
+	cp->running = 1;
+
+	if (pthread_create(&cp->thread, NULL, checkpointWriter, cp) != 0)
+	{
+		cp->running = 0;
+		printf("Checkpoint konnte nicht geschrieben werden (%s)\n", cp->path);
+	}
+}
+
+/* ************************************************************************ */
+/* finishCheckpoint: waits for the last checkpoint to be written            */
+/* ************************************************************************ */
+static void
+finishCheckpoint(void)
+{
+	if (checkpoint.running)
+	{
+		pthread_join(checkpoint.thread, NULL);
+		checkpoint.running = 0;
+	}
+}
+
+/* ************************************************************************ */
+/* initCheckpoint: prepares the checkpoints and with --restart loads the    */
+/*                 last one into the matrix and the results                 */
+/* ************************************************************************ */
+static void
+initCheckpoint(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
+{
+	struct checkpoint*       cp = &checkpoint;
+	struct checkpoint_header header;
+	FILE*                    file;
+	uint64_t                 i;
+
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+
+	char const* path = getenv("PARTDIFF_CHECKPOINT_FILE");
+
+	cp->interval = options->checkpoint;
+	cp->path     = (path != NULL) ? path : CHECKPOINT_FILE;
+	cp->temp     = allocateMemory(strlen(cp->path) + 5);
+	cp->buffer   = NULL;
+	cp->running  = 0;
+
+	sprintf(cp->temp, "%s.tmp", cp->path);
+
+	memset(&cp->header, 0, sizeof(cp->header));
+	memcpy(cp->header.magic, CHECKPOINT_MAGIC, sizeof(cp->header.magic));
+	cp->header.real_size   = sizeof(real);
+	cp->header.method      = options->method;
+	cp->header.interlines  = options->interlines;
+	cp->header.inf_func    = options->inf_func;
+	cp->header.termination = options->termination;
+
+	if (!options->restart)
+	{
+		return;
+	}
+
+	if ((file = fopen(cp->path, "rb")) == NULL || fread(&header, sizeof(header), 1, file) != 1)
+	{
+		printf("Checkpoint kann nicht gelesen werden (%s)\n", cp->path);
+		cleanup();
+		exit(1);
+	}
+
+	if (memcmp(header.magic, cp->header.magic, sizeof(header.magic)) != 0 || header.real_size != cp->header.real_size || header.method != cp->header.method || header.interlines != cp->header.interlines || header.inf_func != cp->header.inf_func || header.termination != cp->header.termination || header.m >= arguments->num_matrices)
+	{
+		printf("Checkpoint passt nicht zu den Parametern (%s)\n", cp->path);
+		cleanup();
+		exit(1);
+	}
+
+	for (i = 0; i <= N; i++)
+	{
+		if (fread(arguments->M + (header.m * (N + 1) + i) * ld, sizeof(real), N + 1, file) != N + 1)
+		{
+			printf("Checkpoint ist unvollständig (%s)\n", cp->path);
+			cleanup();
+			exit(1);
+		}
+	}
+
+	posix_fadvise(fileno(file), 0, 0, POSIX_FADV_DONTNEED);
+	fclose(file);
+
+	cp->header    = header;
+	cp->restarted = header.stat_iteration;
+
+	results->m              = header.m;
+	results->stat_iteration = header.stat_iteration;
+	results->stat_precision = header.stat_precision;
+}
+
+#ifdef ELEMENT
+/* ************************************************************************ */
+/* rhsPoint: returns the interference function at (i, j), scaled by h^2 / 4 */
+/* ************************************************************************ */
+static inline double
+rhsPoint(struct calculation_arguments const* arguments, int i, int j)
+{
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		return arguments->rhs_plane[i * (arguments->N + 1) + j];
+	}
+	else if (arguments->rhs_mode == RHS_VECTORS)
+	{
+		return arguments->rhs_row[i] * arguments->rhs_col[j];
+	}
+
+	return 0.0;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation                                           */
+/* ************************************************************************ */
+static void
+calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int    i, j;        /* local variables for loops */
+	int    m1, m2;      /* used as indices for old and new matrices */
+	double star;        /* four times center value minus 4 neigh.b values */
+	double residuum;    /* residuum of current iteration */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
+
+	typedef real(*matrix)[N + 1][ld];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	uint64_t stat_iteration = 0;
+	double stat_precision = 0.0;
+	uint64_t term_iteration;
+	uint64_t left;     /* iterations until the next convergence check */
+	int      residual; /* whether the current iteration computes the residuum */
+
+	struct convergence_check check; /* shared state of the convergence checks */
+
+	int due[2] = { 0, 0 }; /* the master found a checkpoint due, by iteration parity */
+
+	int const    chebyshev = options->chebyshev && options->method == METH_JACOBI;
+	double const rho       = cos(M_PI / N); /* spectral radius of Jacobi */
+
+	initCheck(&check, options, checkRate(arguments, options));
+
+	/* continue with the convergence checks of the checkpoint */
+	if (options->restart)
+	{
+		checkpoint.header.check.adaptive = check.adaptive;
+
+		check = checkpoint.header.check;
+	}
+
+	/* only reset after a check, when no thread is inside a sweep */
+	maxresiduum = 0;
+
+	#pragma omp parallel default(none) shared(arguments,options,maxresiduum,check,checkpoint,due,chebyshev,rho,N,ld,Matrix,results) private(i,j,m1,m2,star,residuum,term_iteration,left,residual) reduction(+:stat_iteration) reduction(max:stat_precision)
+	{
+		double   omega  = 0.0; /* weight of the current iteration (Chebyshev) */
+		uint64_t sweeps = 0;   /* iterations since the start, a restart starts anew */
+
+		/* initialize m1 and m2 depending on algorithm */
+		if (options->method == METH_JACOBI)
+		{
+			m1 = 0;
+			m2 = 1;
+		}
+		else
+		{
+			m1 = 0;
+			m2 = 0;
+		}
+		
+		stat_iteration = 0;
+		stat_precision = 0.0;
+		term_iteration = options->term_iteration;
+		left           = 1;
+
+		/* continue with the state of the checkpoint */
+		if (options->restart)
+		{
+			m2             = results->m;
+			m1             = (options->method == METH_JACOBI) ? 1 - m2 : m2;
+			stat_iteration = results->stat_iteration;
+			stat_precision = results->stat_precision;
+			left           = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+
+			if (options->termination == TERM_ITER)
+			{
+				term_iteration = (stat_iteration < term_iteration) ? term_iteration - stat_iteration : 0;
+			}
 		}
-		
-		stat_iteration = 0;
-		stat_precision = 0.0;
-		term_iteration = options->term_iteration;
 
 		while (term_iteration > 0)
 		{
-			maxresiduum = 0;
+			residual = (options->termination == TERM_PREC && left == 1) || term_iteration == 1;
+
+			if (chebyshev)
+			{
+				omega = chebyshevWeight(++sweeps, omega, rho);
+			}
+
+			/* the barrier after the sweep publishes it, the slot is only reused two iterations later */
+			#pragma omp master
+			due[(stat_iteration + 1) % 2] = checkpointDue();
+
 			/* over all columns */
-			#pragma omp for reduction(max:maxresiduum) schedule(runtime)
+			#pragma omp for reduction(max:maxresiduum) collapse(2) schedule(runtime)
 			for (j = 1; j < N; j++)
 			{
 				/* over all rows */
-				#pragma omp simd
 				for (i = 1; i < N; i++)
 				{
-					double fpisin_i = 0.0;
+					star = 0.25 * ((double)Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
+
+					star += rhsPoint(arguments, i, j);
 
-					if (options->inf_func == FUNC_FPISIN)
+					if (residual)
 					{
-						fpisin_i = fpisin * sin(pih * (double)i);
+						residuum    = Matrix[m2][i][j] - star;
+						residuum    = fabs(residuum);
+						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
 					}
 
-					star = 0.25 * (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
-
-					if (options->inf_func == FUNC_FPISIN)
+					if (chebyshev)
 					{
-						star += fpisin_i * sin(pih * (double)j);
+						star = Matrix[m1][i][j] + omega * (star - Matrix[m1][i][j]);
 					}
 
-					if (options->termination == TERM_PREC || term_iteration == 1)
+					Matrix[m1][i][j] = star;
+				}
+			}
+			/* exchange m1 and m2 */
+			i  = m1;
+			m1 = m2;
+			m2 = i;
+			stat_iteration++;
+			/* check for stopping calculation depending on termination method */
+			if (options->termination == TERM_PREC && --left == 0)
+			{
+				#pragma omp single
+				{
+					nextCheck(&check, maxresiduum, options->term_precision);
+					maxresiduum = 0;
+				}
+
+				/* the barrier of single makes the check visible to all threads */
+				left           = check.distance;
+				stat_precision = check.residuum;
+
+				if (check.residuum < options->term_precision || stagnated(&check, N))
+				{
+					term_iteration = 0;
+				}
+			}
+			else if (options->termination == TERM_ITER)
+			{
+				if (residual)
+				{
+					stat_precision = maxresiduum;
+				}
+
+				term_iteration--;
+			}
+
+			/* all threads agree on both, so either all or none wait here */
+			if (due[stat_iteration % 2] && term_iteration > 0)
+			{
+				#pragma omp single
+				{
+					saveCheckpoint(arguments, m2, stat_iteration, stat_precision, left, &check);
+				}
+			}
+		}
+		#pragma omp single nowait
+		{
+			results->m = m2;
+		}
+	}
+	results->stat_iteration = stat_iteration / options->number;
+	results->stat_precision = stat_precision;
+	results->stat_checks    = check.checks;
+	results->stat_stalled   = stagnated(&check, N) ? check.stalled : 0;
+}
+#endif
+#ifdef COLUMN
+/* ************************************************************************ */
+/* calculate: solves the equation                                           */
+/* ************************************************************************ */
+static void
+calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int    i, j;        /* local variables for loops */
+	int    m1, m2;      /* used as indices for old and new matrices */
+	double star;        /* four times center value minus 4 neigh.b values */
+	double residuum;    /* residuum of current iteration */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
+
+	typedef real(*matrix)[N + 1][ld];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	uint64_t stat_iteration = 0;
+	double stat_precision = 0.0;
+	uint64_t term_iteration;
+	uint64_t left;     /* iterations until the next convergence check */
+	int      residual; /* whether the current iteration computes the residuum */
+
+	struct convergence_check check; /* shared state of the convergence checks */
+
+	int due[2] = { 0, 0 }; /* the master found a checkpoint due, by iteration parity */
+
+	int const    chebyshev = options->chebyshev && options->method == METH_JACOBI;
+	double const rho       = cos(M_PI / N); /* spectral radius of Jacobi */
+
+	initCheck(&check, options, checkRate(arguments, options));
+
+	/* continue with the convergence checks of the checkpoint */
+	if (options->restart)
+	{
+		checkpoint.header.check.adaptive = check.adaptive;
+
+		check = checkpoint.header.check;
+	}
+
+	/* only reset after a check, when no thread is inside a sweep */
+	maxresiduum = 0;
+
+	#pragma omp parallel default(none) shared(arguments,options,maxresiduum,check,checkpoint,due,chebyshev,rho,N,ld,Matrix,results) private(i,j,m1,m2,star,residuum,term_iteration,left,residual) reduction(+:stat_iteration) reduction(max:stat_precision)
+	{
+		double   omega  = 0.0; /* weight of the current iteration (Chebyshev) */
+		uint64_t sweeps = 0;   /* iterations since the start, a restart starts anew */
+
+		/* initialize m1 and m2 depending on algorithm */
+		if (options->method == METH_JACOBI)
+		{
+			m1 = 0;
+			m2 = 1;
+		}
+		else
+		{
+			m1 = 0;
+			m2 = 0;
+		}
+		
+		stat_iteration = 0;
+		stat_precision = 0.0;
+		term_iteration = options->term_iteration;
+		left           = 1;
+
+		/* continue with the state of the checkpoint */
+		if (options->restart)
+		{
+			m2             = results->m;
+			m1             = (options->method == METH_JACOBI) ? 1 - m2 : m2;
+			stat_iteration = results->stat_iteration;
+			stat_precision = results->stat_precision;
+			left           = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+
+			if (options->termination == TERM_ITER)
+			{
+				term_iteration = (stat_iteration < term_iteration) ? term_iteration - stat_iteration : 0;
+			}
+		}
+
+		while (term_iteration > 0)
+		{
+			residual = (options->termination == TERM_PREC && left == 1) || term_iteration == 1;
+
+			if (chebyshev)
+			{
+				omega = chebyshevWeight(++sweeps, omega, rho);
+			}
+
+			/* the barrier after the sweep publishes it, the slot is only reused two iterations later */
+			#pragma omp master
+			due[(stat_iteration + 1) % 2] = checkpointDue();
+
+			/* over all columns */
+			#pragma omp for reduction(max:maxresiduum) schedule(runtime)
+			for (j = 1; j < N; j++)
+			{
+				double const* f = rhsLine(arguments, j, 0);
+
+				/* over all rows */
+				#pragma omp simd
+				for (i = 1; i < N; i++)
+				{
+					star = 0.25 * ((double)Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
+
+					star += f[i];
+
+					if (residual)
 					{
 						residuum    = Matrix[m2][i][j] - star;
 						residuum    = fabs(residuum);
 						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
 					}
 
+					if (chebyshev)
+					{
+						star = Matrix[m1][i][j] + omega * (star - Matrix[m1][i][j]);
+					}
+
 					Matrix[m1][i][j] = star;
 				}
 			}
@@ -558,19 +1499,42 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 			m1 = m2;
 			m2 = i;
 			stat_iteration++;
-			stat_precision = maxresiduum;
 			/* check for stopping calculation depending on termination method */
-			if (options->termination == TERM_PREC)
+			if (options->termination == TERM_PREC && --left == 0)
 			{
-				if (maxresiduum < options->term_precision)
+				#pragma omp single
+				{
+					nextCheck(&check, maxresiduum, options->term_precision);
+					maxresiduum = 0;
+				}
+
+				/* the barrier of single makes the check visible to all threads */
+				left           = check.distance;
+				stat_precision = check.residuum;
+
+				if (check.residuum < options->term_precision || stagnated(&check, N))
 				{
 					term_iteration = 0;
 				}
 			}
 			else if (options->termination == TERM_ITER)
 			{
+				if (residual)
+				{
+					stat_precision = maxresiduum;
+				}
+
 				term_iteration--;
 			}
+
+			/* all threads agree on both, so either all or none wait here */
+			if (due[stat_iteration % 2] && term_iteration > 0)
+			{
+				#pragma omp single
+				{
+					saveCheckpoint(arguments, m2, stat_iteration, stat_precision, left, &check);
+				}
+			}
 		}
 		#pragma omp single nowait
 		{
@@ -579,9 +1543,229 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 	}
 	results->stat_iteration = stat_iteration / options->number;
 	results->stat_precision = stat_precision;
+	results->stat_checks    = check.checks;
+	results->stat_stalled   = stagnated(&check, N) ? check.stalled : 0;
 }
 #endif
 #ifdef ROW
+/* ************************************************************************ */
+/* jacobi_rows_*: Jacobi update of one or two rows                          */
+/*                                                                          */
+/* src points to the old row above the first updated row, dst to the first  */
+/* new row, f0 and f1 to the interference function of both rows, ld is the  */
+/* leading dimension of the matrices. The second row reuses the two middle  */
+/* rows the first one already loaded. Every kernel sums the neighbours in   */
+/* the same order as the scalar loop, so all of them give bit-identical     */
+/* results, and returns max |old - new|.                                    */
+/* ************************************************************************ */
+static double
+jacobi_rows_from(real const* src, real* dst, double const* f0, double const* f1, int N, int ld, int rows, int first)
+{
+	int    j, k;              /* local variables for loops */
+	double star;              /* four times center value minus 4 neigh.b values */
+	double residuum;          /* residuum of current point */
+	double maxresiduum = 0.0; /* maximum residuum value of the rows */
+
+	for (k = 0; k < rows; k++)
+	{
+		real const*   up   = src + k * ld;
+		real const*   cur  = up + ld;
+		real const*   down = cur + ld;
+		double const* f    = (k == 0) ? f0 : f1;
+		real*         out  = dst + k * ld;
+
+		for (j = first; j < N; j++)
+		{
+			star = 0.25 * ((double)up[j] + cur[j - 1] + cur[j + 1] + down[j]) + f[j];
+
+			residuum    = fabs(cur[j] - star);
+			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+
+			out[j] = star;
+		}
+	}
+
+	return maxresiduum;
+}
+
+static double
+jacobi_rows_scalar(real const* src, real* dst, double const* f0, double const* f1, int N, int ld, int rows)
+{
+	return jacobi_rows_from(src, dst, f0, f1, N, ld, rows, 1);
+}
+
+#ifdef HAVE_X86_SIMD
+/* float rows are widened on load and rounded once on store */
+#ifdef FLOAT
+#define LOAD_SSE2(p)       _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((__m128i const*)(p))))
+#define STORE_SSE2(p, v)   _mm_storel_epi64((__m128i*)(p), _mm_castps_si128(_mm_cvtpd_ps(v)))
+#define LOAD_AVX2(p)       _mm256_cvtps_pd(_mm_loadu_ps(p))
+#define STORE_AVX2(p, v)   _mm_storeu_ps((p), _mm256_cvtpd_ps(v))
+#define LOAD_AVX512(p)     _mm512_cvtps_pd(_mm256_loadu_ps(p))
+#define STORE_AVX512(p, v) _mm256_storeu_ps((p), _mm512_cvtpd_ps(v))
+#else
+#define LOAD_SSE2(p)       _mm_loadu_pd(p)
+#define STORE_SSE2(p, v)   _mm_storeu_pd((p), (v))
+#define LOAD_AVX2(p)       _mm256_loadu_pd(p)
+#define STORE_AVX2(p, v)   _mm256_storeu_pd((p), (v))
+#define LOAD_AVX512(p)     _mm512_loadu_pd(p)
+#define STORE_AVX512(p, v) _mm512_storeu_pd((p), (v))
+#endif
+
+static double
+jacobi_rows_sse2(real const* src, real* dst, double const* f0, double const* f1, int N, int ld, int rows)
+{
+	int    j;         /* local variable for loop */
+	double lanes[2];  /* lanes of the maximum */
+	double rest;      /* maximum of the scalar remainder */
+
+	real const* r0 = src;
+	real const* r1 = r0 + ld;
+	real const* r2 = r1 + ld;
+	real const* r3 = r2 + ld;
+
+	__m128d const quarter = _mm_set1_pd(0.25);
+	__m128d const sign    = _mm_set1_pd(-0.0);
+	__m128d       vmax    = _mm_setzero_pd();
+
+	for (j = 1; j + 2 <= N; j += 2)
+	{
+		__m128d c1 = LOAD_SSE2(r1 + j);
+		__m128d c2 = LOAD_SSE2(r2 + j);
+		__m128d s  = _mm_add_pd(_mm_add_pd(_mm_add_pd(LOAD_SSE2(r0 + j), LOAD_SSE2(r1 + j - 1)), LOAD_SSE2(r1 + j + 1)), c2);
+
+		s    = _mm_add_pd(_mm_mul_pd(quarter, s), _mm_loadu_pd(f0 + j));
+		vmax = _mm_max_pd(vmax, _mm_andnot_pd(sign, _mm_sub_pd(c1, s)));
+		STORE_SSE2(dst + j, s);
+
+		if (rows == 2)
+		{
+			s = _mm_add_pd(_mm_add_pd(_mm_add_pd(c1, LOAD_SSE2(r2 + j - 1)), LOAD_SSE2(r2 + j + 1)), LOAD_SSE2(r3 + j));
+
+			s    = _mm_add_pd(_mm_mul_pd(quarter, s), _mm_loadu_pd(f1 + j));
+			vmax = _mm_max_pd(vmax, _mm_andnot_pd(sign, _mm_sub_pd(c2, s)));
+			STORE_SSE2(dst + ld + j, s);
+		}
+	}
+
+	_mm_storeu_pd(lanes, vmax);
+
+	rest = jacobi_rows_from(src, dst, f0, f1, N, ld, rows, j);
+
+	return fmax(fmax(lanes[0], lanes[1]), rest);
+}
+
+__attribute__((target("avx2")))
+static double
+jacobi_rows_avx2(real const* src, real* dst, double const* f0, double const* f1, int N, int ld, int rows)
+{
+	int    j;         /* local variable for loop */
+	double lanes[4];  /* lanes of the maximum */
+	double rest;      /* maximum of the scalar remainder */
+
+	real const* r0 = src;
+	real const* r1 = r0 + ld;
+	real const* r2 = r1 + ld;
+	real const* r3 = r2 + ld;
+
+	__m256d const quarter = _mm256_set1_pd(0.25);
+	__m256d const sign    = _mm256_set1_pd(-0.0);
+	__m256d       vmax    = _mm256_setzero_pd();
+
+	for (j = 1; j + 4 <= N; j += 4)
+	{
+		__m256d c1 = LOAD_AVX2(r1 + j);
+		__m256d c2 = LOAD_AVX2(r2 + j);
+		__m256d s  = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(LOAD_AVX2(r0 + j), LOAD_AVX2(r1 + j - 1)), LOAD_AVX2(r1 + j + 1)), c2);
+
+		s    = _mm256_add_pd(_mm256_mul_pd(quarter, s), _mm256_loadu_pd(f0 + j));
+		vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(sign, _mm256_sub_pd(c1, s)));
+		STORE_AVX2(dst + j, s);
+
+		if (rows == 2)
+		{
+			s = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(c1, LOAD_AVX2(r2 + j - 1)), LOAD_AVX2(r2 + j + 1)), LOAD_AVX2(r3 + j));
+
+			s    = _mm256_add_pd(_mm256_mul_pd(quarter, s), _mm256_loadu_pd(f1 + j));
+			vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(sign, _mm256_sub_pd(c2, s)));
+			STORE_AVX2(dst + ld + j, s);
+		}
+	}
+
+	_mm256_storeu_pd(lanes, vmax);
+
+	rest = jacobi_rows_from(src, dst, f0, f1, N, ld, rows, j);
+
+	return fmax(fmax(fmax(lanes[0], lanes[1]), fmax(lanes[2], lanes[3])), rest);
+}
+
+__attribute__((target("avx512f")))
+static double
+jacobi_rows_avx512(real const* src, real* dst, double const* f0, double const* f1, int N, int ld, int rows)
+{
+	int    j;    /* local variable for loop */
+	double rest; /* maximum of the scalar remainder */
+
+	real const* r0 = src;
+	real const* r1 = r0 + ld;
+	real const* r2 = r1 + ld;
+	real const* r3 = r2 + ld;
+
+	__m512d const quarter = _mm512_set1_pd(0.25);
+	__m512d       vmax    = _mm512_setzero_pd();
+
+	for (j = 1; j + 8 <= N; j += 8)
+	{
+		__m512d c1 = LOAD_AVX512(r1 + j);
+		__m512d c2 = LOAD_AVX512(r2 + j);
+		__m512d s  = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(LOAD_AVX512(r0 + j), LOAD_AVX512(r1 + j - 1)), LOAD_AVX512(r1 + j + 1)), c2);
+
+		s    = _mm512_add_pd(_mm512_mul_pd(quarter, s), _mm512_loadu_pd(f0 + j));
+		vmax = _mm512_max_pd(vmax, _mm512_abs_pd(_mm512_sub_pd(c1, s)));
+		STORE_AVX512(dst + j, s);
+
+		if (rows == 2)
+		{
+			s = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(c1, LOAD_AVX512(r2 + j - 1)), LOAD_AVX512(r2 + j + 1)), LOAD_AVX512(r3 + j));
+
+			s    = _mm512_add_pd(_mm512_mul_pd(quarter, s), _mm512_loadu_pd(f1 + j));
+			vmax = _mm512_max_pd(vmax, _mm512_abs_pd(_mm512_sub_pd(c2, s)));
+			STORE_AVX512(dst + ld + j, s);
+		}
+	}
+
+	rest = jacobi_rows_from(src, dst, f0, f1, N, ld, rows, j);
+
+	return fmax(_mm512_reduce_max_pd(vmax), rest);
+}
+#endif
+
+/* ************************************************************************ */
+/* selectKernel: returns the Jacobi kernel for the given instruction set    */
+/* ************************************************************************ */
+static jacobi_kernel
+selectKernel(uint64_t simd)
+{
+#ifdef HAVE_X86_SIMD
+	if (simd == SIMD_AVX512)
+	{
+		return jacobi_rows_avx512;
+	}
+	else if (simd == SIMD_AVX2)
+	{
+		return jacobi_rows_avx2;
+	}
+	else if (simd == SIMD_SSE2)
+	{
+		return jacobi_rows_sse2;
+	}
+#else
+	(void)simd;
+#endif
+
+	return jacobi_rows_scalar;
+}
+
 /* ************************************************************************ */
 /* calculate: solves the equation                                           */
 /* ************************************************************************ */
@@ -594,28 +1778,46 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 	double residuum;    /* residuum of current iteration */
 	double maxresiduum; /* maximum residuum value of a slave in iteration */
 
-	int const    N = arguments->N;
-	double const h = arguments->h;
-
-	double pih    = 0.0;
-	double fpisin = 0.0;
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
-	if (options->inf_func == FUNC_FPISIN)
-	{
-		pih    = M_PI * h;
-		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
-	}
-
 	uint64_t stat_iteration = 0;
 	double stat_precision = 0.0;
 	uint64_t term_iteration;
+	uint64_t left;     /* iterations until the next convergence check */
+	int      residual; /* whether the current iteration computes the residuum */
+
+	struct convergence_check check; /* shared state of the convergence checks */
+
+	int due[2] = { 0, 0 }; /* the master found a checkpoint due, by iteration parity */
+
+	int const    chebyshev = options->chebyshev && options->method == METH_JACOBI;
+	double const rho       = cos(M_PI / N); /* spectral radius of Jacobi */
+
+	initCheck(&check, options, checkRate(arguments, options));
+
+	/* continue with the convergence checks of the checkpoint */
+	if (options->restart)
+	{
+		checkpoint.header.check.adaptive = check.adaptive;
+
+		check = checkpoint.header.check;
+	}
+
+	/* only reset after a check, when no thread is inside a sweep */
+	maxresiduum = 0;
 
-	#pragma omp parallel default(none) shared(options,maxresiduum,N,pih,fpisin,Matrix,results) private(i,j,m1,m2,star,residuum,term_iteration) reduction(+:stat_iteration) reduction(max:stat_precision)
+	jacobi_kernel kernel = selectKernel(options->simd);
+
+	#pragma omp parallel default(none) shared(arguments,options,maxresiduum,check,checkpoint,due,chebyshev,rho,N,ld,Matrix,results,kernel) private(i,j,m1,m2,star,residuum,term_iteration,left,residual) reduction(+:stat_iteration) reduction(max:stat_precision)
 	{
+		double   omega  = 0.0; /* weight of the current iteration (Chebyshev) */
+		uint64_t sweeps = 0;   /* iterations since the start, a restart starts anew */
+
 		/* initialize m1 and m2 depending on algorithm */
 		if (options->method == METH_JACOBI)
 		{
@@ -631,40 +1833,83 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 		stat_iteration = 0;
 		stat_precision = 0.0;
 		term_iteration = options->term_iteration;
+		left           = 1;
+
+		/* continue with the state of the checkpoint */
+		if (options->restart)
+		{
+			m2             = results->m;
+			m1             = (options->method == METH_JACOBI) ? 1 - m2 : m2;
+			stat_iteration = results->stat_iteration;
+			stat_precision = results->stat_precision;
+			left           = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+
+			if (options->termination == TERM_ITER)
+			{
+				term_iteration = (stat_iteration < term_iteration) ? term_iteration - stat_iteration : 0;
+			}
+		}
 
 		while (term_iteration > 0)
 		{
-			maxresiduum = 0;
-			/* over all rows */
-			#pragma omp for reduction(max:maxresiduum) schedule(runtime)
-			for (i = 1; i < N; i++)
+			residual = (options->termination == TERM_PREC && left == 1) || term_iteration == 1;
+
+			if (chebyshev)
 			{
-				double fpisin_i = 0.0;
+				omega = chebyshevWeight(++sweeps, omega, rho);
+			}
 
-				if (options->inf_func == FUNC_FPISIN)
-				{
-					fpisin_i = fpisin * sin(pih * (double)i);
-				}
+			/* the barrier after the sweep publishes it, the slot is only reused two iterations later */
+			#pragma omp master
+			due[(stat_iteration + 1) % 2] = checkpointDue();
 
-				/* over all columns */
-				#pragma omp simd
-				for (j = 1; j < N; j++)
+			if (options->method == METH_JACOBI && !chebyshev)
+			{
+				/* two rows at a time, the last call may only get one */
+				#pragma omp for reduction(max:maxresiduum) schedule(runtime)
+				for (i = 1; i < N; i += 2)
 				{
-					star = 0.25 * (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
+					double const* f0 = rhsLine(arguments, i, 0);
+					double const* f1 = rhsLine(arguments, i + 1, 1);
 
-					if (options->inf_func == FUNC_FPISIN)
-					{
-						star += fpisin_i * sin(pih * (double)j);
-					}
+					residuum = kernel(&Matrix[m2][i - 1][0], &Matrix[m1][i][0], f0, f1, N, ld, (i + 1 < N) ? 2 : 1);
 
-					if (options->termination == TERM_PREC || term_iteration == 1)
+					if (residual)
 					{
-						residuum    = Matrix[m2][i][j] - star;
-						residuum    = fabs(residuum);
 						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
 					}
+				}
+			}
+			else
+			{
+				/* over all rows */
+				#pragma omp for reduction(max:maxresiduum) schedule(runtime)
+				for (i = 1; i < N; i++)
+				{
+					double const* f = rhsLine(arguments, i, 0);
 
-					Matrix[m1][i][j] = star;
+					/* over all columns */
+					#pragma omp simd
+					for (j = 1; j < N; j++)
+					{
+						star = 0.25 * ((double)Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
+
+						star += f[j];
+
+						if (residual)
+						{
+							residuum    = Matrix[m2][i][j] - star;
+							residuum    = fabs(residuum);
+							maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+						}
+
+						if (chebyshev)
+						{
+							star = Matrix[m1][i][j] + omega * (star - Matrix[m1][i][j]);
+						}
+
+						Matrix[m1][i][j] = star;
+					}
 				}
 			}
 			/* exchange m1 and m2 */
@@ -672,19 +1917,42 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 			m1 = m2;
 			m2 = i;
 			stat_iteration++;
-			stat_precision = maxresiduum;
 			/* check for stopping calculation depending on termination method */
-			if (options->termination == TERM_PREC)
+			if (options->termination == TERM_PREC && --left == 0)
 			{
-				if (maxresiduum < options->term_precision)
+				#pragma omp single
+				{
+					nextCheck(&check, maxresiduum, options->term_precision);
+					maxresiduum = 0;
+				}
+
+				/* the barrier of single makes the check visible to all threads */
+				left           = check.distance;
+				stat_precision = check.residuum;
+
+				if (check.residuum < options->term_precision || stagnated(&check, N))
 				{
 					term_iteration = 0;
 				}
 			}
 			else if (options->termination == TERM_ITER)
 			{
+				if (residual)
+				{
+					stat_precision = maxresiduum;
+				}
+
 				term_iteration--;
 			}
+
+			/* all threads agree on both, so either all or none wait here */
+			if (due[stat_iteration % 2] && term_iteration > 0)
+			{
+				#pragma omp single
+				{
+					saveCheckpoint(arguments, m2, stat_iteration, stat_precision, left, &check);
+				}
+			}
 		}
 		#pragma omp single nowait
 		{
@@ -693,9 +1961,122 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 	}
 	results->stat_iteration = stat_iteration / options->number;
 	results->stat_precision = stat_precision;
+	results->stat_checks    = check.checks;
+	results->stat_stalled   = stagnated(&check, N) ? check.stalled : 0;
 }
 #endif
 
+/* ************************************************************************ */
+/* calculate_red_black: solves the equation with red-black Gauß-Seidel      */
+/*                                                                          */
+/* Updates all red points (i + j even) first and all black points after.    */
+/* Points of one colour only depend on points of the other colour, so both  */
+/* half sweeps are split across all threads like a Jacobi sweep.            */
+/* ************************************************************************ */
+static void
+calculate_red_black(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int    i, j;        /* local variables for loops */
+	int    colour;      /* 0: red, 1: black */
+	double star;        /* four times center value minus 4 neigh.b values */
+	double residuum;    /* residuum of current iteration */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	int    residual;    /* whether the current iteration computes the residuum */
+
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
+
+	typedef real(*matrix)[ld];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	uint64_t term_iteration = options->term_iteration;
+
+	uint64_t                 left = 1; /* iterations until the next convergence check */
+	struct convergence_check check;    /* state of the convergence checks */
+
+	initCheck(&check, options, checkRate(arguments, options));
+
+	/* continue with the state of the checkpoint */
+	if (options->restart)
+	{
+		checkpoint.header.check.adaptive = check.adaptive;
+
+		left  = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+		check = checkpoint.header.check;
+
+		if (options->termination == TERM_ITER)
+		{
+			term_iteration = (results->stat_iteration < term_iteration) ? term_iteration - results->stat_iteration : 0;
+		}
+	}
+
+	while (term_iteration > 0)
+	{
+		maxresiduum = 0;
+
+		residual = (options->termination == TERM_PREC && left == 1) || term_iteration == 1;
+
+		for (colour = 0; colour < 2; colour++)
+		{
+			/* over all rows */
+			#pragma omp parallel for private(j,star,residuum) reduction(max:maxresiduum) schedule(runtime)
+			for (i = 1; i < N; i++)
+			{
+				double const* f = rhsLine(arguments, i, 0);
+
+				/* over all columns of the current colour */
+				for (j = 1 + (i + colour + 1) % 2; j < N; j += 2)
+				{
+					star = 0.25 * ((double)Matrix[i - 1][j] + Matrix[i][j - 1] + Matrix[i][j + 1] + Matrix[i + 1][j]);
+
+					star += f[j];
+
+					if (residual)
+					{
+						residuum    = Matrix[i][j] - star;
+						residuum    = fabs(residuum);
+						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+					}
+
+					Matrix[i][j] = star;
+				}
+			}
+		}
+
+		results->stat_iteration++;
+
+		if (residual)
+		{
+			results->stat_precision = maxresiduum;
+		}
+
+		/* check for stopping calculation depending on termination method */
+		if (options->termination == TERM_PREC && --left == 0)
+		{
+			left = nextCheck(&check, maxresiduum, options->term_precision);
+
+			if (maxresiduum < options->term_precision || stagnated(&check, N))
+			{
+				term_iteration = 0;
+			}
+		}
+		else if (options->termination == TERM_ITER)
+		{
+			term_iteration--;
+		}
+
+		if (term_iteration > 0 && checkpointDue())
+		{
+			saveCheckpoint(arguments, 0, results->stat_iteration, results->stat_precision, left, &check);
+		}
+	}
+
+	results->m           = 0;
+	results->stat_checks  = check.checks;
+	results->stat_stalled = stagnated(&check, N) ? check.stalled : 0;
+}
+
 /* ************************************************************************ */
 /*  displayStatistics: displays some statistics about the calculation       */
 /* ************************************************************************ */
@@ -706,7 +2087,11 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
 
 	printf("Berechnungszeit:    %f s\n", time);
-	printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) * arguments->num_matrices / 1024.0 / 1024.0);
+	printf("Speicherbedarf:     %f MiB", (N + 1) * (N + 1) * sizeof(real) * arguments->num_matrices / 1024.0 / 1024.0);
+#ifdef FLOAT
+	printf(" (float)");
+#endif
+	printf("\n");
 	printf("Berechnungsmethode: ");
 
 	if (options->method == METH_GAUSS_SEIDEL)
@@ -716,6 +2101,31 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	else if (options->method == METH_JACOBI)
 	{
 		printf("Jacobi");
+
+		if (options->chebyshev)
+		{
+			printf(" (Chebyshev)");
+		}
+		else if (getenv("PARTDIFF_SIMD") != NULL)
+		{
+			/* only on request, the default output matches the reference */
+			if (options->simd == SIMD_AVX512)
+			{
+				printf(" (AVX-512)");
+			}
+			else if (options->simd == SIMD_AVX2)
+			{
+				printf(" (AVX2)");
+			}
+			else if (options->simd == SIMD_SSE2)
+			{
+				printf(" (SSE2)");
+			}
+		}
+	}
+	else if (options->method == METH_RED_BLACK)
+	{
+		printf("Red-Black Gauß-Seidel");
 	}
 
 	printf("\n");
@@ -729,12 +2139,33 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	else if (options->inf_func == FUNC_FPISIN)
 	{
 		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+
+		/* only on request, the default output matches the reference */
+		if (getenv("PARTDIFF_RHS_BUDGET") != NULL)
+		{
+			if (arguments->rhs_mode == RHS_PLANE)
+			{
+				printf(" (Ebene)");
+			}
+			else if (arguments->rhs_mode == RHS_VECTORS)
+			{
+				printf(" (Vektoren)");
+			}
+			else
+			{
+				printf(" (Rekurrenz)");
+			}
+		}
 	}
 
 	printf("\n");
 	printf("Terminierung:       ");
 
-	if (options->termination == TERM_PREC)
+	if (options->termination == TERM_PREC && options->check == CHECK_ADAPTIVE)
+	{
+		printf("Hinreichende Genaugkeit (%" PRIu64 " Prüfungen)", results->stat_checks);
+	}
+	else if (options->termination == TERM_PREC)
 	{
 		printf("Hinreichende Genaugkeit");
 	}
@@ -743,8 +2174,19 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 		printf("Anzahl der Iterationen");
 	}
 
+	if (results->stat_stalled > 0)
+	{
+		printf(", abgebrochen: Residuum stagniert seit %" PRIu64 " Iterationen", results->stat_stalled);
+	}
+
 	printf("\n");
 	printf("Anzahl Iterationen: %" PRIu64 "\n", results->stat_iteration);
+
+	if (options->restart)
+	{
+		printf("Checkpoint:         fortgesetzt nach %" PRIu64 " Iterationen\n", checkpoint.restarted);
+	}
+
 	printf("Norm des Fehlers:   %e\n", results->stat_precision);
 	printf("\n");
 }
@@ -766,8 +2208,9 @@ displayMatrix(struct calculation_arguments* arguments, struct calculation_result
 
 	int const interlines = options->interlines;
 	int const N          = arguments->N;
+	int const ld         = arguments->ld;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
@@ -808,13 +2251,24 @@ main(int argc, char** argv)
 
 	initVariables(&arguments, &results, &options);
 
-	allocateMatrices(&arguments);
+	allocateMatrices(&arguments, &options);
 	initMatrices(&arguments, &options);
+	initRhs(&arguments, &options);
+	initCheckpoint(&arguments, &results, &options);
 
 	gettimeofday(&start_time, NULL);
-	calculate(&arguments, &results, &options);
+	if (options.method == METH_RED_BLACK)
+	{
+		calculate_red_black(&arguments, &results, &options);
+	}
+	else
+	{
+		calculate(&arguments, &results, &options);
+	}
 	gettimeofday(&comp_time, NULL);
 
+	finishCheckpoint();
+
 	displayStatistics(&arguments, &results, &options);
 	displayMatrix(&arguments, &results, &options);
 
@@ -26,6 +26,7 @@
 /* Include standard header file.                                            */
 /* ************************************************************************ */
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,7 +35,10 @@
 #include <math.h>
 #include <malloc.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/time.h>
+#include <unistd.h>
 #include <pthread.h>
 
 /* ************* */
@@ -48,19 +52,69 @@
 #define MAX_INTERLINES    10240
 #define MAX_ITERATION     200000
 #define MAX_THREADS       1024
+#define MAX_TILE_DEPTH    64
+#define MAX_TILE_WIDTH    (MAX_INTERLINES * 8 + 8)
+#define TILE_ROWS         8
+#define TILE_CACHE        (1 << 20)
+#define CACHE_LINE        64
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI       2
+#define METH_RED_BLACK    3
 #define FUNC_F0           1
 #define FUNC_FPISIN       2
 #define TERM_PREC         1
 #define TERM_ITER         2
+#define RHS_NONE          0
+#define RHS_RECURRENCE    1
+#define RHS_VECTORS       2
+#define RHS_PLANE         3
+#define RHS_BUDGET        2048 /* KiB, holds the vectors up to MAX_INTERLINES */
+#define MAX_RHS_BUDGET    (UINT64_C(1) << 30)
+#define CHECK_EVERY       0
+#define CHECK_ADAPTIVE    1
+#define CHECK_MAX_DISTANCE 64
+#define CHECK_SAFETY      0.5
+#define STALL_ITERATIONS  1000
+#define HUGEPAGES_OFF     0
+#define HUGEPAGES_TRANSPARENT 1
+#define HUGEPAGES_EXPLICIT 2
+#define HUGEPAGE_SIZE     (UINT64_C(2) << 20)
+#define MAX_CHECKPOINT    86400
+#define CHECKPOINT_FILE   "partdiff.checkpoint"
+#define CHECKPOINT_MAGIC  "partdiff"
+
+/* -D INTERLINES=n fixes the matrix size, the kernels then know their trip count */
+#ifdef INTERLINES
+#define KERNEL_N(N)       (INTERLINES * 8 + 8)
+#define KERNEL_TILES      0
+#else
+#define KERNEL_N(N)       (N)
+#define KERNEL_TILES      1
+#endif
+
+/* matrix entries, -D FLOAT halves the memory traffic; sums stay double */
+#ifdef FLOAT
+typedef float real;
+#define MIN_PRECISION     1e-6
+#else
+typedef double real;
+#define MIN_PRECISION     1e-20
+#endif
 
 struct calculation_arguments
 {
 	uint64_t N;            /* number of spaces between lines (lines=N+1) */
+	uint64_t ld;           /* leading dimension, reals per padded matrix row */
 	uint64_t num_matrices; /* number of matrices */
 	double   h;            /* length of a space between two lines */
-	double*  M;            /* two matrices with real values */
+	real*    M;            /* two matrices with real values */
+	uint64_t rhs_mode;     /* how the right-hand side is provided */
+	double   rhs_sin;      /* sin(pi * h), start of the recurrence */
+	double   rhs_cos;      /* 2 * cos(pi * h), factor of the recurrence */
+	double*  rhs_row;      /* row factors 2 * pi^2 * h^2 * sin(pi * h * i) / 4 */
+	double*  rhs_col;      /* column factors sin(pi * h * j) */
+	double*  rhs_plane;    /* complete right-hand side */
+	double*  rhs_buffer;   /* one row of the right-hand side per thread */
 };
 
 struct calculation_results
@@ -68,6 +122,8 @@ struct calculation_results
 	uint64_t m;
 	uint64_t stat_iteration; /* number of current iteration */
 	double   stat_precision; /* actual precision of all slaves in iteration */
+	uint64_t stat_checks;    /* number of convergence checks */
+	uint64_t stat_stalled;   /* iterations without a smaller residuum, if that stopped the run */
 };
 
 struct options
@@ -79,29 +135,97 @@ struct options
 	uint64_t termination;    /* termination condition */
 	uint64_t term_iteration; /* terminate if iteration number reached */
 	double   term_precision; /* terminate if precision reached */
+	uint64_t tile_depth;     /* number of sweeps per wavefront pass */
+	uint64_t tile_width;     /* columns per tile of a sweep, 0: from the cache */
+	uint64_t inplace;        /* Jacobi in one matrix with copies of the old rows */
+	uint64_t rhs_budget;     /* memory for the right-hand side in KiB */
+	uint64_t check;          /* when the convergence is checked */
+	uint64_t hugepages;      /* page size of the matrices */
+	uint64_t checkpoint;     /* seconds between checkpoints, 0: off */
+	uint64_t restart;        /* continue from the last checkpoint */
+	uint64_t chebyshev;      /* Jacobi with Chebyshev acceleration */
 };
 
 struct init_args
 {
-	double* Matrix;
+	real* Matrix;
 	uint64_t thread_num;
 	struct options const* options;
+	uint64_t num_matrices;
+	int ld;
 	int N;
 };
 
+/* updates every step-th column of first .. last - 1 in a row, see ROW_KERNEL */
+typedef double (*row_kernel)(real const*, real const*, real const*, real*, double const*, double, int, int);
+
 struct shared_args
 {
-	double pih;
-	double fpisin;
-	double* Matrix;
+	struct calculation_arguments const* arguments;
+	row_kernel kernel[2]; /* without and with residuum */
+	double* rhs_buffer;
+	real* Matrix;
 	double* shared_maxresiduum;
 	uint64_t thread_num;
 	struct options const* options;
 	struct calculation_results* results;
 	pthread_barrier_t* inner_barrier;
+	int* due; /* thread 0 found a checkpoint due, by iteration parity */
+	real* saved; /* in place: old rows i - 1 and i of this thread */
+	real* edges; /* in place: old first row of every thread */
+	int width; /* columns per tile */
+	int ld; /* leading dimension of the matrices */
 	int N;
 };
 
+struct convergence_check
+{
+	uint64_t adaptive; /* check only as often as the contraction requires */
+	double   rho;      /* spectral radius estimate of the method */
+	double   residuum; /* maximum residuum at the last check, 0 before */
+	uint64_t distance; /* iterations between the last and the next check */
+	uint64_t checks;   /* number of checks so far */
+	double   best;     /* smallest residuum of all checks */
+	uint64_t stalled;  /* iterations since the residuum last reached a new minimum */
+};
+
+struct checkpoint_header
+{
+	char     magic[8];       /* CHECKPOINT_MAGIC */
+	uint64_t real_size;      /* bytes per matrix entry */
+	uint64_t method;         /* parameters a restart has to match */
+	uint64_t interlines;
+	uint64_t inf_func;
+	uint64_t termination;
+	uint64_t stat_iteration; /* iterations done so far */
+	double   stat_precision; /* precision of the last checked iteration */
+	double   stat_omega;     /* relaxation factor (SOR) */
+	uint64_t m;              /* matrix with the newest values */
+	uint64_t left;           /* iterations until the next convergence check */
+	struct convergence_check check; /* state of the convergence checks */
+};
+
+struct checkpoint
+{
+	uint64_t       interval;  /* seconds between checkpoints, 0: off */
+	char const*    path;      /* checkpoint file */
+	char*          temp;      /* file a checkpoint is written to first */
+	struct timeval last;      /* time of the last checkpoint */
+	uint64_t       restarted; /* iterations done before a restart */
+	real*          buffer;    /* snapshot of the matrix, rows without padding */
+	size_t         size;      /* bytes in the snapshot */
+	pthread_t      thread;    /* background writer */
+	int            running;   /* the writer has been started and not joined */
+	int            done;      /* the writer has finished */
+	struct checkpoint_header header; /* state written with the snapshot */
+};
+
+struct mapping
+{
+	void*  addr; /* start of the mapped memory, NULL if there is none */
+	size_t size; /* length of the mapping in bytes */
+};
+
 struct vector
 {
 	size_t** buf;
@@ -120,17 +244,28 @@ static void* pop();
 struct timeval start_time; /* time when program started */
 struct timeval comp_time;  /* time when calculation completed */
 struct vector allocated_memory;
+struct mapping matrix_memory;
+
+/* periodic checkpoints of the calculation */
+struct checkpoint checkpoint;
 
 static void
 usage(char* name)
 {
-	printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter]\n", name);
+	printf("Usage: %s [--restart] [num] [method] [lines] [func] [term] [prec/iter]\n", name);
 	printf("\n");
+	printf("  - --restart: continue from the last checkpoint, which has to be written\n");
+	printf("               with the same method, lines, func and term\n");
 	printf("  - num:       number of threads (1 .. %d)\n", MAX_THREADS);
-	printf("  - method:    calculation method (1 .. 2)\n");
+	printf("  - method:    calculation method (1 .. 3)\n");
 	printf("                 %1d: Gauß-Seidel\n", METH_GAUSS_SEIDEL);
 	printf("                 %1d: Jacobi\n", METH_JACOBI);
+	printf("                 %1d: Red-Black Gauß-Seidel\n", METH_RED_BLACK);
+#ifdef INTERLINES
+	printf("  - lines:     number of interlines (only %d, fixed at compile time)\n", INTERLINES);
+#else
 	printf("  - lines:     number of interlines (0 .. %d)\n", MAX_INTERLINES);
+#endif
 	printf("                 matrixsize = (interlines * 8) + 9\n");
 	printf("  - func:      interference function (1 .. 2)\n");
 	printf("                 %1d: f(x,y) = 0\n", FUNC_F0);
@@ -139,17 +274,79 @@ usage(char* name)
 	printf("                 %1d: sufficient precision\n", TERM_PREC);
 	printf("                 %1d: number of iterations\n", TERM_ITER);
 	printf("  - prec/iter: depending on term:\n");
-	printf("                 precision:  1e-4 .. 1e-20\n");
+	printf("                 precision:  1e-4 .. %g\n", MIN_PRECISION);
 	printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
 	printf("\n");
+	printf("Environment:\n");
+	printf("  - PARTDIFF_TILE_DEPTH: sweeps per wavefront pass (1 .. %d, default 1)\n", MAX_TILE_DEPTH);
+	printf("                 with precision termination the check happens once per pass\n");
+	printf("                 only used by Jacobi with two matrices\n");
+	printf("  - PARTDIFF_TILE_WIDTH: columns per tile of a sweep (0 .. %d, default 0)\n", MAX_TILE_WIDTH);
+	printf("                 0: %d rows of a tile fill half of the L2 cache\n", TILE_ROWS);
+	printf("                 whole rows if the right-hand side is a recurrence\n");
+	printf("                 whole rows with -D INTERLINES or in place\n");
+	printf("  - PARTDIFF_INPLACE: Jacobi in one matrix (0 .. 1, default 0)\n");
+	printf("                 every thread keeps copies of the old rows it still needs\n");
+	printf("  - PARTDIFF_RHS_BUDGET: memory for the right-hand side in KiB (default %d)\n", RHS_BUDGET);
+	printf("                 the whole plane if it fits, otherwise row and column vectors,\n");
+	printf("                 the default always holds them, a smaller budget generates\n");
+	printf("                 every row by a less exact recurrence\n");
+	printf("  - PARTDIFF_CHECK: convergence checks with precision termination (default %d)\n", CHECK_EVERY);
+	printf("                 %1d: every iteration\n", CHECK_EVERY);
+	printf("                 %1d: adaptive, estimated from the residuum contraction,\n", CHECK_ADAPTIVE);
+	printf("                    at most %d iterations apart\n", CHECK_MAX_DISTANCE);
+	printf("                 not used by the wavefront passes\n");
+	printf("  - PARTDIFF_HUGEPAGES: page size of the matrices (default %d)\n", HUGEPAGES_OFF);
+	printf("                 %1d: normal pages\n", HUGEPAGES_OFF);
+	printf("                 %1d: transparent huge pages\n", HUGEPAGES_TRANSPARENT);
+	printf("                 %1d: explicit huge pages, transparent ones if none are reserved\n", HUGEPAGES_EXPLICIT);
+	printf("  - PARTDIFF_CHECKPOINT: seconds between checkpoints (0 .. %d, default 0: off)\n", MAX_CHECKPOINT);
+	printf("                 written in the background to $PARTDIFF_CHECKPOINT_FILE\n");
+	printf("                 (default %s)\n", CHECKPOINT_FILE);
+	printf("  - PARTDIFF_CHEBYSHEV: Chebyshev acceleration of Jacobi (0 .. 1, default 0)\n");
+	printf("                 always with two matrices and one sweep per pass\n");
+	printf("\n");
 	printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
 
+/* ************************************************************************ */
+/* askEnvParam: reads an optional tuning parameter from the environment     */
+/* ************************************************************************ */
+static uint64_t
+askEnvParam(char* name, char const* variable, uint64_t min, uint64_t max, uint64_t fallback)
+{
+	char const* value = getenv(variable);
+	uint64_t    param;
+
+	if (value == NULL)
+	{
+		return fallback;
+	}
+
+	if (sscanf(value, "%" SCNu64, &param) != 1 || !(param >= min && param <= max))
+	{
+		usage(name);
+		exit(1);
+	}
+
+	return param;
+}
+
 static void
 askParams(struct options* options, int argc, char** argv)
 {
 	int ret;
 
+	options->restart = argc > 1 && strcmp(argv[1], "--restart") == 0;
+
+	/* the remaining parameters are the usual ones */
+	if (options->restart)
+	{
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+
 	if (argc < 7 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "-?") == 0)
 	{
 		usage(argv[0]);
@@ -166,7 +363,7 @@ askParams(struct options* options, int argc, char** argv)
 
 	ret = sscanf(argv[2], "%" SCNu64, &(options->method));
 
-	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI))
+	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI || options->method == METH_RED_BLACK))
 	{
 		usage(argv[0]);
 		exit(1);
@@ -174,7 +371,11 @@ askParams(struct options* options, int argc, char** argv)
 
 	ret = sscanf(argv[3], "%" SCNu64, &(options->interlines));
 
+#ifdef INTERLINES
+	if (ret != 1 || options->interlines != INTERLINES)
+#else
 	if (ret != 1 || !(options->interlines <= MAX_INTERLINES))
+#endif
 	{
 		usage(argv[0]);
 		exit(1);
@@ -202,7 +403,7 @@ askParams(struct options* options, int argc, char** argv)
 
 		options->term_iteration = MAX_ITERATION;
 
-		if (ret != 1 || !(options->term_precision >= 1e-20 && options->term_precision <= 1e-4))
+		if (ret != 1 || !(options->term_precision >= MIN_PRECISION && options->term_precision <= 1e-4))
 		{
 			usage(argv[0]);
 			exit(1);
@@ -220,6 +421,41 @@ askParams(struct options* options, int argc, char** argv)
 			exit(1);
 		}
 	}
+
+	options->tile_depth = askEnvParam(argv[0], "PARTDIFF_TILE_DEPTH", 1, MAX_TILE_DEPTH, 1);
+	options->tile_width = askEnvParam(argv[0], "PARTDIFF_TILE_WIDTH", 0, MAX_TILE_WIDTH, 0);
+	options->inplace    = askEnvParam(argv[0], "PARTDIFF_INPLACE", 0, 1, 0);
+	options->rhs_budget = askEnvParam(argv[0], "PARTDIFF_RHS_BUDGET", 0, MAX_RHS_BUDGET, RHS_BUDGET);
+	options->check      = askEnvParam(argv[0], "PARTDIFF_CHECK", CHECK_EVERY, CHECK_ADAPTIVE, CHECK_EVERY);
+	options->hugepages  = askEnvParam(argv[0], "PARTDIFF_HUGEPAGES", HUGEPAGES_OFF, HUGEPAGES_EXPLICIT, HUGEPAGES_OFF);
+	options->checkpoint = askEnvParam(argv[0], "PARTDIFF_CHECKPOINT", 0, MAX_CHECKPOINT, 0);
+	options->chebyshev  = askEnvParam(argv[0], "PARTDIFF_CHEBYSHEV", 0, 1, 0);
+
+	/* the weights combine the sweep with the iterate before the last one */
+	if (options->chebyshev && options->method == METH_JACOBI)
+	{
+		options->inplace    = 0;
+		options->tile_depth = 1;
+	}
+}
+
+/* ************************************************************************ */
+/* rowLength: returns the leading dimension of a matrix with N + 1 columns  */
+/*            of size bytes each                                            */
+/*                                                                          */
+/* Rows are padded to an odd number of cache lines. Every row then starts   */
+/* at a cache line, so no stencil load is split, and consecutive rows walk  */
+/* through all cache sets instead of aliasing at power-of-two strides.      */
+/* ************************************************************************ */
+static uint64_t
+rowLength(uint64_t N, size_t size)
+{
+	uint64_t const line  = CACHE_LINE / size;
+	uint64_t       lines = (N + line) / line;
+
+	lines += (lines % 2 == 0) ? 1 : 0;
+
+	return lines * line;
 }
 
 /* ************************************************************************ */
@@ -229,12 +465,15 @@ static void
 initVariables(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
 {
 	arguments->N            = (options->interlines * 8) + 9 - 1;
-	arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
+	arguments->ld           = rowLength(arguments->N, sizeof(real));
+	arguments->num_matrices = (options->method == METH_JACOBI && !options->inplace) ? 2 : 1;
 	arguments->h            = 1.0 / arguments->N;
 
 	results->m              = 0;
 	results->stat_iteration = 0;
 	results->stat_precision = 0;
+	results->stat_checks    = 0;
+	results->stat_stalled   = 0;
 }
 
 /* ************************************************************************ */
@@ -245,18 +484,24 @@ cleanup() {
 	for (void* p = pop(); p != NULL; p = pop())
 		free(p);
 	free(allocated_memory.buf);
+
+	if (matrix_memory.addr != NULL)
+	{
+		munmap(matrix_memory.addr, matrix_memory.size);
+	}
 }
 
 /* ************************************************************************ */
 /* allocateMemory ()                                                        */
-/* allocates memory and quits if there was a memory allocation problem      */
+/* allocates memory aligned to a cache line and quits if there was a memory */
+/* allocation problem                                                       */
 /* ************************************************************************ */
 static void*
 allocateMemory(size_t size)
 {
 	void* p;
 
-	if ((p = malloc(size)) == NULL)
+	if (posix_memalign(&p, CACHE_LINE, size) != 0)
 	{
 		printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", size);
 		cleanup();
@@ -317,19 +562,89 @@ pop()
 	return p;
 }
 
+/* ************************************************************************ */
+/* allocateMatrixMemory: maps zeroed memory for the matrices                */
+/*                                                                          */
+/* Anonymous mappings start out on the shared zero page, so the matrices    */
+/* need no zero pass and every page is placed on the NUMA node of the       */
+/* thread that writes it first. With huge pages the mapping is aligned to   */
+/* HUGEPAGE_SIZE, so the kernel can back all of it with them.               */
+/* ************************************************************************ */
+static void*
+allocateMatrixMemory(size_t size, uint64_t hugepages)
+{
+	size_t const align  = (hugepages == HUGEPAGES_OFF) ? (size_t)sysconf(_SC_PAGESIZE) : HUGEPAGE_SIZE;
+	size_t const length = (size + align - 1) & ~(align - 1);
+	size_t const extra  = (hugepages == HUGEPAGES_OFF) ? 0 : align;
+	char*        p      = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (hugepages == HUGEPAGES_EXPLICIT)
+	{
+		p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+		if (p == MAP_FAILED)
+		{
+			printf("Keine Huge Pages reserviert, verwende transparente Huge Pages\n");
+		}
+	}
+#endif
+
+	if (p == MAP_FAILED)
+	{
+		/* map one alignment more and give back the unaligned ends */
+		char* q = mmap(NULL, length + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (q == MAP_FAILED)
+		{
+			printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", length + extra);
+			cleanup();
+			exit(1);
+		}
+
+		p = (char*)(((uintptr_t)q + align - 1) & ~(uintptr_t)(align - 1));
+
+		if (p > q)
+		{
+			munmap(q, p - q);
+		}
+
+		if (q + extra > p)
+		{
+			munmap(p + length, q + extra - p);
+		}
+
+#ifdef MADV_HUGEPAGE
+		if (hugepages != HUGEPAGES_OFF)
+		{
+			madvise(p, length, MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	matrix_memory.addr = p;
+	matrix_memory.size = length;
+
+	return p;
+}
+
 /* ************************************************************************ */
 /* allocateMatrices: allocates memory for matrices                          */
 /* ************************************************************************ */
 static void
-allocateMatrices(struct calculation_arguments* arguments)
+allocateMatrices(struct calculation_arguments* arguments, struct options const* options)
 {
 	uint64_t const N = arguments->N;
 
-	arguments->M = allocateMemory(arguments->num_matrices * (N + 1) * (N + 1) * sizeof(double));
+	arguments->M = allocateMatrixMemory(arguments->num_matrices * (N + 1) * arguments->ld * sizeof(real), options->hugepages);
 }
 
 /* ************************************************************************ */
-/* initMatrices_t: per-thread function to zero out the matrix               */
+/* initMatrices_t: per-thread function to place the matrix rows             */
+/*                                                                          */
+/* The mapped memory is already zero. Every thread writes one zero into     */
+/* each page of the rows it computes in calculate_t, so the first touch     */
+/* puts them on its NUMA node. The border rows go to the outer threads.     */
 /* ************************************************************************ */
 static void *
 initMatrices_t(void *data)
@@ -337,22 +652,35 @@ initMatrices_t(void *data)
 	struct init_args *args = (struct init_args *)data;
 	uint64_t num_threads = args->options->number;
 	uint64_t thread_num = args->thread_num;
-	uint64_t method = args->options->method;
-	size_t N = (size_t)args->N + 1;
-	N *= N;
-	N <<= method == METH_JACOBI ? 1 : 0;
-	double* Matrix = args->Matrix;
-
-	size_t count = N / num_threads;
-	size_t remainder = N % num_threads;
-	size_t lower = thread_num * count;
+	size_t N = args->N;
+	size_t ld = args->ld;
+	size_t step = sysconf(_SC_PAGESIZE) / sizeof(real);
+	real* Matrix = args->Matrix;
+
+	size_t count = (N - 1) / num_threads;
+	size_t remainder = (N - 1) % num_threads;
+	size_t lower = 1 + thread_num * count;
 	size_t upper = lower + count;
 
 	lower += thread_num < remainder ? thread_num : remainder;
 	upper += thread_num < remainder ? thread_num + 1 : remainder;
 
-	for (size_t i = lower; i < upper; ++i)
-		Matrix[i] = 0;
+	lower -= thread_num == 0 ? 1 : 0;
+	upper += thread_num + 1 == num_threads ? 1 : 0;
+
+	if (lower == upper)
+		return NULL;
+
+	for (size_t g = 0; g < args->num_matrices; ++g)
+	{
+		real* first = Matrix + (g * (N + 1) + lower) * ld;
+		real* last = Matrix + (g * (N + 1) + upper) * ld - 1;
+
+		for (real* p = first; p < last; p += step)
+			*p = 0;
+
+		*last = 0;
+	}
 
 	return NULL;
 }
@@ -365,22 +693,25 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 {
 	uint64_t g, i; /* local variables for loops */
 
-	uint64_t const N = arguments->N;
-	double const   h = arguments->h;
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+	double const   h  = arguments->h;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
 	struct init_args t_args[options->number];
 	pthread_t threads[options->number];
 
-	/* initialize matrix/matrices with zeros */
+	/* place the rows of every thread on its NUMA node */
 	for (uint64_t t = 0; t < options->number; ++t)
 	{
 		t_args[t].Matrix = arguments->M;
+		t_args[t].ld = ld;
 		t_args[t].N = N;
 		t_args[t].options = options;
+		t_args[t].num_matrices = arguments->num_matrices;
 		t_args[t].thread_num = t;	
 		pthread_create(&threads[t], NULL, initMatrices_t, (void *)&t_args[t]);
 	}
@@ -410,220 +741,1157 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 }
 
 /* ************************************************************************ */
-/* calculate_t: gets run by each thread to solve the equation               */
+/* initRhs: prepares the right-hand side within the memory budget           */
+/*                                                                          */
+/* The interference function is the product of a row and a column factor.   */
+/* If the whole plane fits into the budget it is precomputed, otherwise     */
+/* both factor vectors are kept and multiplied for every row. Without even  */
+/* those, every row is generated by sin((j + 1) x) = 2 cos(x) sin(j x) -    */
+/* sin((j - 1) x), which only costs one sin() per row.                      */
 /* ************************************************************************ */
-static void *
-calculate_t(void *data)
+static void
+initRhs(struct calculation_arguments* arguments, struct options const* options)
 {
-	struct shared_args *args = (struct shared_args *)data;
-	struct options const *options = args->options;
-	int const N = args->N;
-	double pih = args->pih;
-	double fpisin = args->fpisin;
-	typedef double(*matrix)[N + 1][N + 1];
-	matrix Matrix = (matrix)args->Matrix;
-	struct calculation_results *results = args->results;
-	int thread_num = args->thread_num;
-	pthread_barrier_t *inner_barrier = args->inner_barrier;
-	double *shared_maxresiduum = args->shared_maxresiduum;
+	uint64_t i, j; /* local variables for loops */
 
-	int i, j;			      /* local variables for loops */
-	int m1, m2;			      /* used as indices for old and new matrices */
-	double star;		      /* four times center value minus 4 neigh.b values */
-	double residuum;	      /* residuum of current iteration */
-	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+	uint64_t const N      = arguments->N;
+	double const   h      = arguments->h;
+	uint64_t const budget = options->rhs_budget * 1024;
 
-	uint64_t stat_iteration = 0;
-	uint64_t term_iteration = options->term_iteration;
+	arguments->rhs_mode   = RHS_NONE;
+	arguments->rhs_sin    = sin(M_PI * h);
+	arguments->rhs_cos    = 2 * cos(M_PI * h);
+	arguments->rhs_row    = NULL;
+	arguments->rhs_col    = NULL;
+	arguments->rhs_plane  = NULL;
+	arguments->rhs_buffer = allocateMemory(options->number * (N + 1) * sizeof(double));
 
-	/* initialize m1 and m2 depending on algorithm */
-	if (options->method == METH_JACOBI)
+	/* f(x,y) = 0 leaves the buffers at 0 */
+	memset(arguments->rhs_buffer, 0, options->number * (N + 1) * sizeof(double));
+
+	if (options->inf_func != FUNC_FPISIN)
 	{
-		m1 = 0;
-		m2 = 1;
+		return;
+	}
+
+	if ((N + 1) * (N + 1) * sizeof(double) <= budget)
+	{
+		arguments->rhs_mode = RHS_PLANE;
+	}
+	else if (2 * (N + 1) * sizeof(double) <= budget)
+	{
+		arguments->rhs_mode = RHS_VECTORS;
 	}
 	else
 	{
-		m1 = 0;
-		m2 = 0;
+		arguments->rhs_mode = RHS_RECURRENCE;
+		return;
 	}
 
-	int count = (N - 1) / options->number;
-	int remainder = (N - 1) % options->number;
-	int lower = 1 + thread_num * count;
-	int upper = lower + count;
+	arguments->rhs_row = allocateMemory((N + 1) * sizeof(double));
+	arguments->rhs_col = allocateMemory((N + 1) * sizeof(double));
 
-	lower += thread_num < remainder ? thread_num : remainder;
-	upper += thread_num < remainder ? thread_num + 1 : remainder;
+	for (i = 0; i <= N; i++)
+	{
+		arguments->rhs_row[i] = ((2 * M_PI * M_PI) * h * h * sin(M_PI * h * (double)i)) / 4;
+		arguments->rhs_col[i] = sin(M_PI * h * (double)i);
+	}
 
-	while (term_iteration > 0)
+	if (arguments->rhs_mode == RHS_PLANE)
 	{
-		maxresiduum = 0.0;
+		arguments->rhs_plane = allocateMemory((N + 1) * (N + 1) * sizeof(double));
 
-		/* over all rows */
-		for (i = lower; i < upper; i++)
+		for (i = 0; i <= N; i++)
 		{
-			double fpisin_i = 0.0;
-
-			if (options->inf_func == FUNC_FPISIN)
+			for (j = 0; j <= N; j++)
 			{
-				fpisin_i = fpisin * sin(pih * (double)i);
+				arguments->rhs_plane[i * (N + 1) + j] = arguments->rhs_row[i] * arguments->rhs_col[j];
 			}
+		}
+	}
+}
 
-			/* over all columns */
-			for (j = 1; j < N; j++)
-			{
-				star = 0.25 * (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
-
-				if (options->inf_func == FUNC_FPISIN)
-				{
-					star += fpisin_i * sin(pih * (double)j);
-				}
+/* ************************************************************************ */
+/* rhsLine: returns row i of the interference function, scaled by h^2 / 4   */
+/*          like the stencil; buffer holds N + 1 values if it is generated  */
+/* ************************************************************************ */
+static inline double const*
+rhsLine(struct calculation_arguments const* arguments, int i, double* buffer)
+{
+	int    j;  /* local variable for loop */
+	double fi; /* row factor */
 
-				if (options->termination == TERM_PREC || term_iteration == 1)
-				{
-					residuum = Matrix[m2][i][j] - star;
-					residuum = fabs(residuum);
-					maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
-				}
+	int const N = arguments->N;
 
-				Matrix[m1][i][j] = star;
-			}
-		}
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		return arguments->rhs_plane + i * (N + 1);
+	}
+	else if (arguments->rhs_mode == RHS_VECTORS)
+	{
+		fi = arguments->rhs_row[i];
 
-		if (options->termination == TERM_PREC || term_iteration == 1)
-			shared_maxresiduum[thread_num] = maxresiduum;
-		pthread_barrier_wait(inner_barrier);
-		if (options->termination == TERM_PREC || term_iteration == 1)
+		for (j = 0; j <= N; j++)
 		{
-			for (uint64_t k = 0; k < options->number; ++k)
-			{
-				maxresiduum = (shared_maxresiduum[k] < maxresiduum) ? maxresiduum : shared_maxresiduum[k];
-			}
+			buffer[j] = fi * arguments->rhs_col[j];
 		}
+	}
+	else if (arguments->rhs_mode == RHS_RECURRENCE)
+	{
+		fi = ((2 * M_PI * M_PI) * arguments->h * arguments->h * sin(M_PI * arguments->h * (double)i)) / 4;
 
-		/* exchange m1 and m2 */
-		i = m1;
-		m1 = m2;
-		m2 = i;
-		stat_iteration++;
-		/* check for stopping calculation depending on termination method */
-		if (options->termination == TERM_PREC)
-		{
-			pthread_barrier_wait(inner_barrier);
-			if (maxresiduum < options->term_precision)
-			{
-				term_iteration = 0;
-			}
-		}
-		else if (options->termination == TERM_ITER)
+		buffer[0] = 0.0;
+		buffer[1] = fi * arguments->rhs_sin;
+
+		for (j = 1; j < N; j++)
 		{
-			term_iteration--;
+			buffer[j + 1] = arguments->rhs_cos * buffer[j] - buffer[j - 1];
 		}
 	}
-	if (thread_num == 0)
+
+	return buffer;
+}
+
+/* ************************************************************************ */
+/* rhsTile: like rhsLine, but only the columns first .. last - 1 have to be */
+/*          valid, so a tile does not generate the whole row                */
+/* ************************************************************************ */
+static inline double const*
+rhsTile(struct calculation_arguments const* arguments, int i, int first, int last, double* buffer)
+{
+	int    j;  /* local variable for loop */
+	double fi; /* row factor */
+
+	if (arguments->rhs_mode != RHS_VECTORS)
 	{
-		results->m = m2;
-		results->stat_iteration = stat_iteration;
-		results->stat_precision = maxresiduum;
+		return rhsLine(arguments, i, buffer);
 	}
-	return NULL;
+
+	fi = arguments->rhs_row[i];
+
+	for (j = first; j < last; j++)
+	{
+		buffer[j] = fi * arguments->rhs_col[j];
+	}
+
+	return buffer;
 }
 
 /* ************************************************************************ */
-/* calculate: solves the equation                                           */
+/* tileWidth: returns the number of columns per tile                        */
+/*                                                                          */
+/* Every thread runs over its rows in tiles of full height. Jacobi and the  */
+/* half sweeps of red-black can update their points in any order, so the    */
+/* results do not change. TILE_ROWS rows of a tile, counting matrix and     */
+/* right-hand side, have to stay in the L2 cache between two rows.          */
 /* ************************************************************************ */
-static void
-calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+static int
+tileWidth(struct calculation_arguments const* arguments, struct options const* options)
 {
-	int const    N = arguments->N;
-	double const h = arguments->h;
+	long cache = TILE_CACHE; /* size of the L2 cache in bytes */
+	int  width;              /* columns per tile */
+	int  tiles;              /* number of tiles */
 
-	double pih    = 0.0;
-	double fpisin = 0.0;
+	int const N = arguments->N;
 
-	if (options->inf_func == FUNC_FPISIN)
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	if (sysconf(_SC_LEVEL2_CACHE_SIZE) > 0)
 	{
-		pih    = M_PI * h;
-		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+		cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
 	}
+#endif
 
-	struct shared_args args[options->number];
-	double shared_maxresiduum[options->number];
+	width = options->tile_width;
 
-	pthread_t threads[options->number];
-	pthread_barrier_t inner_barrier;
-	pthread_barrier_init(&inner_barrier, NULL, options->number);
-	for (uint64_t t = 0; t < options->number; ++t)
+	if (width == 0)
 	{
-		args[t].options = options;
-		args[t].N = N;
-		args[t].pih = pih;
-		args[t].fpisin = fpisin;
-		args[t].Matrix = arguments->M;
-		args[t].results = results;
-		args[t].thread_num = t;
-		args[t].inner_barrier = &inner_barrier;
-		args[t].shared_maxresiduum = (double *)&shared_maxresiduum;
-		
-		pthread_create(&threads[t], NULL, calculate_t, (void *)&args[t]);
+		/* whole cache lines of doubles */
+		width = (cache / 2 / (TILE_ROWS * sizeof(double))) & ~7;
 	}
 
-	for (uint64_t t = 0; t < options->number; ++t)
+	/* the recurrence, the kernels of -D INTERLINES and in place only know whole rows */
+	if (width <= 0 || width >= N - 1 || arguments->rhs_mode == RHS_RECURRENCE || !KERNEL_TILES || options->inplace)
 	{
-		pthread_join(threads[t], NULL);
+		return N - 1;
+	}
+
+	if (options->tile_width == 0)
+	{
+		/* same number of tiles, but all of about the same width */
+		tiles = (N - 1 + width - 1) / width;
+		width = ((N - 1 + tiles - 1) / tiles + 7) & ~7;
 	}
+
+	return width;
 }
 
 /* ************************************************************************ */
-/*  displayStatistics: displays some statistics about the calculation       */
+/* initCheck: prepares the convergence checks for a method whose residuum   */
+/*            contracts by about rho per iteration, the first check comes   */
+/*            after the first iteration                                     */
 /* ************************************************************************ */
 static void
-displayStatistics(struct calculation_arguments const* arguments, struct calculation_results const* results, struct options const* options)
+initCheck(struct convergence_check* check, struct options const* options, double rho)
 {
-	int    N    = arguments->N;
-	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
+	check->adaptive = options->check == CHECK_ADAPTIVE;
+	check->rho      = rho;
+	check->residuum = 0.0;
+	check->distance = 1;
+	check->checks   = 0;
+	check->best     = 0.0;
+	check->stalled  = 0;
+}
 
-	printf("Berechnungszeit:    %f s\n", time);
-	printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) * arguments->num_matrices / 1024.0 / 1024.0);
-	printf("Berechnungsmethode: ");
+/* ************************************************************************ */
+/* nextCheck: records the residuum of a check and returns the number of     */
+/*            iterations until the next one                                 */
+/*                                                                          */
+/* The contraction rate is measured between the last two checks and capped  */
+/* by rho, because it only slows down towards the spectral radius. The next */
+/* check comes after CHECK_SAFETY times the iterations the residuum still   */
+/* needs at that rate, so it rarely stops later than checking every time.   */
+/* ************************************************************************ */
+static uint64_t
+nextCheck(struct convergence_check* check, double maxresiduum, double term_precision)
+{
+	double rate = check->rho; /* residuum contraction per iteration */
+	double remaining;         /* iterations until the precision is reached */
 
-	if (options->method == METH_GAUSS_SEIDEL)
-	{
-		printf("Gauß-Seidel");
-	}
-	else if (options->method == METH_JACOBI)
+	if (check->residuum > 0.0 && maxresiduum < check->residuum)
 	{
-		printf("Jacobi");
-	}
+		double measured = pow(maxresiduum / check->residuum, 1.0 / check->distance);
 
-	printf("\n");
-	printf("Interlines:         %" PRIu64 "\n", options->interlines);
-	printf("Stoerfunktion:      ");
+		rate = (measured < rate) ? measured : rate;
+	}
 
-	if (options->inf_func == FUNC_F0)
+	if (check->checks == 0 || maxresiduum < check->best)
 	{
-		printf("f(x,y) = 0");
+		check->best    = maxresiduum;
+		check->stalled = 0;
 	}
-	else if (options->inf_func == FUNC_FPISIN)
+	else
 	{
-		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+		check->stalled += check->distance;
 	}
 
-	printf("\n");
-	printf("Terminierung:       ");
+	check->residuum = maxresiduum;
+	check->checks++;
+	check->distance = 1;
 
-	if (options->termination == TERM_PREC)
-	{
-		printf("Hinreichende Genaugkeit");
-	}
-	else if (options->termination == TERM_ITER)
+	if (check->adaptive && rate > 0.0 && rate < 1.0 && maxresiduum > term_precision)
 	{
-		printf("Anzahl der Iterationen");
+		remaining = CHECK_SAFETY * log(term_precision / maxresiduum) / log(rate);
+
+		if (remaining >= CHECK_MAX_DISTANCE)
+		{
+			check->distance = CHECK_MAX_DISTANCE;
+		}
+		else if (remaining >= 1.0)
+		{
+			check->distance = remaining;
+		}
+	}
+
+	return check->distance;
+}
+
+/* ************************************************************************ */
+/* stagnated: returns whether the residuum has not reached a new minimum    */
+/*            for a long time, i.e. it hit the rounding level of the        */
+/*            method above the requested precision                          */
+/*                                                                          */
+/* Chebyshev keeps changing the last bits of the solution, so its residuum  */
+/* does not reach every precision down to MIN_PRECISION. The window grows   */
+/* with N because the residuum of over-relaxed methods can grow for about   */
+/* N iterations before it decreases.                                        */
+/* ************************************************************************ */
+static int
+stagnated(struct convergence_check const* check, uint64_t N)
+{
+	uint64_t const window = (4 * N > STALL_ITERATIONS) ? 4 * N : STALL_ITERATIONS;
+
+	return check->stalled >= window;
+}
+
+/* ************************************************************************ */
+/* writeFully: writes size bytes, returns 0 on success                      */
+/* ************************************************************************ */
+static int
+writeFully(int fd, void const* data, size_t size)
+{
+	char const* from = data;
+	ssize_t     ret;
+
+	while (size > 0 && (ret = write(fd, from, size)) > 0)
+	{
+		from += ret;
+		size -= ret;
+	}
+
+	return (size == 0) ? 0 : -1;
+}
+
+/* ************************************************************************ */
+/* checkpointWriter: writes the snapshot to a temporary file in the         */
+/*                   background and renames it over the last checkpoint     */
+/*                                                                          */
+/* The file is synced before the rename, so a crash never leaves a half     */
+/* written checkpoint, and then dropped from the page cache again, so it    */
+/* does not evict the matrix.                                               */
+/* ************************************************************************ */
+static void*
+checkpointWriter(void* data)
+{
+	struct checkpoint* cp = data;
+
+	int fd  = open(cp->temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	int ret = (fd >= 0) ? 0 : -1;
+
+	ret = (ret == 0) ? writeFully(fd, &cp->header, sizeof(cp->header)) : ret;
+	ret = (ret == 0) ? writeFully(fd, cp->buffer, cp->size) : ret;
+	ret = (ret == 0) ? fdatasync(fd) : ret;
+
+	if (fd >= 0)
+	{
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+
+	if (ret != 0 || rename(cp->temp, cp->path) != 0)
+	{
+		printf("Checkpoint konnte nicht geschrieben werden (%s)\n", cp->path);
+	}
+
+	__atomic_store_n(&cp->done, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/* ************************************************************************ */
+/* checkpointDue: returns whether the interval since the last checkpoint    */
+/*                has passed                                                */
+/*                                                                          */
+/* While the writer is still busy with the last checkpoint, the next one is */
+/* postponed instead of waiting for it.                                     */
+/* ************************************************************************ */
+static int
+checkpointDue(void)
+{
+	struct checkpoint* cp = &checkpoint;
+	struct timeval     now;
+
+	if (cp->interval == 0)
+	{
+		return 0;
+	}
+
+	gettimeofday(&now, NULL);
+
+	if (cp->last.tv_sec == 0 && cp->last.tv_usec == 0)
+	{
+		cp->last = now;
+	}
+
+	return (uint64_t)(now.tv_sec - cp->last.tv_sec) >= cp->interval && !(cp->running && !__atomic_load_n(&cp->done, __ATOMIC_ACQUIRE));
+}
+
+/* ************************************************************************ */
+/* saveCheckpoint: starts writing matrix m and the state of the iteration   */
+/*                                                                          */
+/* The calculation only pays for copying the matrix into the snapshot, the  */
+/* file is written by a background thread.                                  */
+/* ************************************************************************ */
+static void
+saveCheckpoint(struct calculation_arguments const* arguments, int m, uint64_t stat_iteration, double stat_precision, uint64_t left, struct convergence_check const* check)
+{
+	struct checkpoint* cp = &checkpoint;
+	uint64_t           i;
+
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+
+	if (cp->running)
+	{
+		pthread_join(cp->thread, NULL);
+	}
+
+	if (cp->buffer == NULL)
+	{
+		cp->size   = (N + 1) * (N + 1) * sizeof(real);
+		cp->buffer = allocateMemory(cp->size);
+	}
+
+	/* rows without their padding */
+	for (i = 0; i <= N; i++)
+	{
+		memcpy(cp->buffer + i * (N + 1), arguments->M + (m * (N + 1) + i) * ld, (N + 1) * sizeof(real));
+	}
+
+	cp->header.stat_iteration = stat_iteration;
+	cp->header.stat_precision = stat_precision;
+	cp->header.m              = m;
+	cp->header.left           = left;
+	cp->header.check          = *check;
+
+	gettimeofday(&cp->last, NULL);
+
+	cp->done    = 0;
+	cp->running = 1;
+
+	if (pthread_create(&cp->thread, NULL, checkpointWriter, cp) != 0)
+	{
+		cp->running = 0;
+		printf("Checkpoint konnte nicht geschrieben werden (%s)\n", cp->path);
+	}
+}
+
+/* ************************************************************************ */
+/* finishCheckpoint: waits for the last checkpoint to be written            */
+/* ************************************************************************ */
+static void
+finishCheckpoint(void)
+{
+	if (checkpoint.running)
+	{
+		pthread_join(checkpoint.thread, NULL);
+		checkpoint.running = 0;
+	}
+}
+
+/* ************************************************************************ */
+/* initCheckpoint: prepares the checkpoints and with --restart loads the    */
+/*                 last one into the matrix and the results                 */
+/* ************************************************************************ */
+static void
+initCheckpoint(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
+{
+	struct checkpoint*       cp = &checkpoint;
+	struct checkpoint_header header;
+	FILE*                    file;
+	uint64_t                 i;
+
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+
+	char const* path = getenv("PARTDIFF_CHECKPOINT_FILE");
+
+	cp->interval = options->checkpoint;
+	cp->path     = (path != NULL) ? path : CHECKPOINT_FILE;
+	cp->temp     = allocateMemory(strlen(cp->path) + 5);
+	cp->buffer   = NULL;
+	cp->running  = 0;
+
+	sprintf(cp->temp, "%s.tmp", cp->path);
+
+	memset(&cp->header, 0, sizeof(cp->header));
+	memcpy(cp->header.magic, CHECKPOINT_MAGIC, sizeof(cp->header.magic));
+	cp->header.real_size   = sizeof(real);
+	cp->header.method      = options->method;
+	cp->header.interlines  = options->interlines;
+	cp->header.inf_func    = options->inf_func;
+	cp->header.termination = options->termination;
+
+	if (!options->restart)
+	{
+		return;
+	}
+
+	if ((file = fopen(cp->path, "rb")) == NULL || fread(&header, sizeof(header), 1, file) != 1)
+	{
+		printf("Checkpoint kann nicht gelesen werden (%s)\n", cp->path);
+		cleanup();
+		exit(1);
+	}
+
+	if (memcmp(header.magic, cp->header.magic, sizeof(header.magic)) != 0 || header.real_size != cp->header.real_size || header.method != cp->header.method || header.interlines != cp->header.interlines || header.inf_func != cp->header.inf_func || header.termination != cp->header.termination)
+	{
+		printf("Checkpoint passt nicht zu den Parametern (%s)\n", cp->path);
+		cleanup();
+		exit(1);
+	}
+
+	/* Jacobi in place has only one matrix, it does not matter which one holds the values */
+	header.m %= arguments->num_matrices;
+
+	for (i = 0; i <= N; i++)
+	{
+		if (fread(arguments->M + (header.m * (N + 1) + i) * ld, sizeof(real), N + 1, file) != N + 1)
+		{
+			printf("Checkpoint ist unvollständig (%s)\n", cp->path);
+			cleanup();
+			exit(1);
+		}
+	}
+
+	posix_fadvise(fileno(file), 0, 0, POSIX_FADV_DONTNEED);
+	fclose(file);
+
+	cp->header    = header;
+	cp->restarted = header.stat_iteration;
+
+	results->m              = header.m;
+	results->stat_iteration = header.stat_iteration;
+	results->stat_precision = header.stat_precision;
+}
+
+/* ************************************************************************ */
+/* chebyshevWeight: returns the weight of iteration k of Jacobi with        */
+/*                  Chebyshev acceleration, omega is the one of k - 1       */
+/*                                                                          */
+/* u(k) = u(k - 2) + omega(k) (J u(k - 1) - u(k - 2)) with a Jacobi sweep J */
+/* and omega(1) = 1, omega(2) = 1 / (1 - rho^2 / 2), omega(k) = 1 / (1 -    */
+/* rho^2 omega(k - 1) / 4). The eigenvalues of J on the 5-point stencil lie */
+/* in [-rho, rho] with rho = cos(pi / N), so no estimate is needed.         */
+/* u(k - 2) is the old content of the matrix that u(k) is written to, and   */
+/* the weights only depend on k, so every thread computes them itself.      */
+/* ************************************************************************ */
+static double
+chebyshevWeight(uint64_t k, double omega, double rho)
+{
+	if (k <= 1)
+	{
+		return 1.0;
+	}
+	else if (k == 2)
+	{
+		return 1.0 / (1.0 - rho * rho / 2);
+	}
+
+	return 1.0 / (1.0 - rho * rho * omega / 4);
+}
+
+/* ************************************************************************ */
+/* ROW_KERNEL: instantiates a kernel that updates every step-th column of   */
+/*             a row, starting at column first and ending before last       */
+/*                                                                          */
+/* Method and termination only decide which kernel is used, so the loop     */
+/* over the columns has no branches left. The interference function is     */
+/* already folded into f by rhsLine and the precision is fixed by real.     */
+/* Gauß-Seidel passes the same row as row and out, Jacobi two different.    */
+/* With chebyshev the sweep is weighted by omega against the old content   */
+/* of out, see chebyshevWeight, the other kernels ignore omega.             */
+/* ************************************************************************ */
+#define ROW_KERNEL(name, step, residual, chebyshev) \
+	static double \
+	name(real const* above, real const* row, real const* below, real* out, double const* f, double omega, int first, int last) \
+	{ \
+		int    j;                 /* local variable for loop */ \
+		double star;              /* four times center value minus 4 neigh.b values */ \
+		double residuum;          /* residuum of current row */ \
+		double maxresiduum = 0.0; /* maximum residuum value of current row */ \
+\
+		(void)last;  /* unused with -D INTERLINES */ \
+		(void)omega; /* unused without chebyshev */ \
+\
+		for (j = first; j < KERNEL_N(last); j += step) \
+		{ \
+			star = 0.25 * ((double)above[j] + row[j - 1] + row[j + 1] + below[j]); \
+\
+			star += f[j]; \
+\
+			if (residual) \
+			{ \
+				residuum = row[j] - star; \
+				residuum = fabs(residuum); \
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum; \
+			} \
+\
+			if (chebyshev) \
+			{ \
+				star = out[j] + omega * (star - out[j]); \
+			} \
+\
+			out[j] = star; \
+		} \
+\
+		return maxresiduum; \
+	}
+
+ROW_KERNEL(row_sweep, 1, 0, 0)
+ROW_KERNEL(row_sweep_residual, 1, 1, 0)
+ROW_KERNEL(row_colour, 2, 0, 0)
+ROW_KERNEL(row_colour_residual, 2, 1, 0)
+ROW_KERNEL(row_chebyshev, 1, 0, 1)
+ROW_KERNEL(row_chebyshev_residual, 1, 1, 1)
+
+/* ************************************************************************ */
+/* selectRowKernel: returns the kernel for the method, residual selects the */
+/*                  variant that computes the residuum                      */
+/* ************************************************************************ */
+static row_kernel
+selectRowKernel(struct options const* options, int residual)
+{
+	if (options->method == METH_RED_BLACK)
+	{
+		return residual ? row_colour_residual : row_colour;
+	}
+
+	if (options->method == METH_JACOBI && options->chebyshev)
+	{
+		return residual ? row_chebyshev_residual : row_chebyshev;
+	}
+
+	return residual ? row_sweep_residual : row_sweep;
+}
+
+/* ************************************************************************ */
+/* calculate_t: gets run by each thread to solve the equation               */
+/*                                                                          */
+/* Every thread keeps its own copy of the convergence checks. They all see  */
+/* the same residua, so they all agree on when to check next.               */
+/*                                                                          */
+/* Jacobi in place overwrites row i as soon as it is done and keeps the old */
+/* rows i - 1 and i in saved for row i + 1. The first row of a thread needs */
+/* the old last row of the thread above and the last row the old first row  */
+/* of the thread below, so both are saved before a barrier at the start of  */
+/* every iteration. The kernels see the same values as with two matrices.   */
+/* ************************************************************************ */
+static void *
+calculate_t(void *data)
+{
+	struct shared_args *args = (struct shared_args *)data;
+	struct options const *options = args->options;
+	int const N = args->N;
+	int const ld = args->ld;
+	struct calculation_arguments const *arguments = args->arguments;
+	typedef real(*matrix)[N + 1][ld];
+	matrix Matrix = (matrix)args->Matrix;
+	struct calculation_results *results = args->results;
+	int thread_num = args->thread_num;
+	pthread_barrier_t *inner_barrier = args->inner_barrier;
+	double *shared_maxresiduum = args->shared_maxresiduum;
+
+	int i;				      /* local variable for loop */
+	int m1, m2;			      /* used as indices for old and new matrices */
+	int colour;			      /* red-black: 0 for red, 1 for black points */
+	int first, last;	      /* columns of the current tile */
+	int start;			      /* red-black: first column of the current colour */
+	double residuum;	      /* residuum of current row */
+	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+	int residual;		      /* whether the current iteration computes the residuum */
+	row_kernel kernel;	      /* kernel of the current iteration */
+	double omega = 0.0;	      /* weight of the current iteration (Chebyshev) */
+	uint64_t sweeps = 0;      /* iterations since the start, a restart starts anew */
+	double const rho = cos(M_PI / N); /* spectral radius of Jacobi */
+
+	uint64_t stat_iteration = 0;
+	uint64_t term_iteration = options->term_iteration;
+
+	uint64_t left = 1;              /* iterations until the next convergence check */
+	struct convergence_check check; /* state of the convergence checks */
+
+	/* initialize m1 and m2 depending on algorithm */
+	if (options->method == METH_JACOBI)
+	{
+		m1 = 0;
+		m2 = options->inplace ? 0 : 1;
+
+		/* Chebyshev approaches the contraction of SOR with the optimal factor */
+		initCheck(&check, options, options->chebyshev ? (1 - sqrt(1 - rho * rho)) / (1 + sqrt(1 - rho * rho)) : rho);
+	}
+	else
+	{
+		m1 = 0;
+		m2 = 0;
+
+		initCheck(&check, options, rho * rho);
+	}
+
+	int count = (N - 1) / options->number;
+	int remainder = (N - 1) % options->number;
+	int lower = 1 + thread_num * count;
+	int upper = lower + count;
+
+	lower += thread_num < remainder ? thread_num : remainder;
+	upper += thread_num < remainder ? thread_num + 1 : remainder;
+
+	/* in place: the old first row of the thread below, the last thread reads the border */
+	real const* edge = ((uint64_t)thread_num + 1 < options->number) ? args->edges + (thread_num + 1) * ld : NULL;
+
+	/* continue with the state of the checkpoint */
+	if (options->restart)
+	{
+		m2 = results->m;
+		m1 = (options->method == METH_JACOBI && !options->inplace) ? 1 - m2 : m2;
+		stat_iteration = results->stat_iteration;
+		left = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+		check = checkpoint.header.check;
+
+		if (options->termination == TERM_ITER)
+		{
+			term_iteration = (stat_iteration < term_iteration) ? term_iteration - stat_iteration : 0;
+		}
+	}
+
+	while (term_iteration > 0)
+	{
+		residual = (options->termination == TERM_PREC && left == 1) || term_iteration == 1;
+		kernel = args->kernel[residual];
+		maxresiduum = 0.0;
+
+		if (options->method == METH_JACOBI && options->chebyshev)
+			omega = chebyshevWeight(++sweeps, omega, rho);
+
+		/* the barrier after the sweep publishes it, the slot is only reused two iterations later */
+		if (thread_num == 0)
+			args->due[(stat_iteration + 1) % 2] = checkpointDue();
+
+		if (options->method == METH_JACOBI && options->inplace)
+		{
+			memcpy(args->saved + ((lower - 1) % 2) * ld, Matrix[0][lower - 1], (N + 1) * sizeof(real));
+			memcpy(args->edges + thread_num * ld, Matrix[0][lower], (N + 1) * sizeof(real));
+			pthread_barrier_wait(inner_barrier);
+
+			/* over all rows */
+			for (i = lower; i < upper; i++)
+			{
+				double const* f = rhsLine(arguments, i, args->rhs_buffer);
+				real const* above = args->saved + ((i - 1) % 2) * ld;
+				real* old = args->saved + (i % 2) * ld;
+
+				memcpy(old, Matrix[0][i], (N + 1) * sizeof(real));
+
+				/* over all columns */
+				residuum = kernel(above, old, (i + 1 == upper && edge != NULL) ? edge : Matrix[0][i + 1], Matrix[0][i], f, 1.0, 1, N);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+			}
+		}
+		else if (options->method == METH_RED_BLACK)
+		{
+			/* points of one colour only depend on the other colour, so a barrier between both half sweeps suffices */
+			for (colour = 0; colour < 2; colour++)
+			{
+				if (colour == 1)
+					pthread_barrier_wait(inner_barrier);
+
+				/* over all tiles */
+				for (first = 1; first < N; first += args->width)
+				{
+					last = (first + args->width < N) ? first + args->width : N;
+
+					/* over all rows */
+					for (i = lower; i < upper; i++)
+					{
+						double const* f = rhsTile(arguments, i, first, last, args->rhs_buffer);
+
+						/* over all columns of the current colour, of the same parity as 1 + (i + colour + 1) % 2 */
+						start = first + (first + i + colour) % 2;
+						residuum = kernel(Matrix[0][i - 1], Matrix[0][i], Matrix[0][i + 1], Matrix[0][i], f, 1.0, start, last);
+						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+					}
+				}
+			}
+		}
+		else
+		{
+			/* over all tiles */
+			for (first = 1; first < N; first += args->width)
+			{
+				last = (first + args->width < N) ? first + args->width : N;
+
+				/* over all rows */
+				for (i = lower; i < upper; i++)
+				{
+					double const* f = rhsTile(arguments, i, first, last, args->rhs_buffer);
+
+					/* over all columns of the tile */
+					residuum = kernel(Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], Matrix[m1][i], f, omega, first, last);
+					maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+				}
+			}
+		}
+
+		if (residual)
+			shared_maxresiduum[thread_num] = maxresiduum;
+		pthread_barrier_wait(inner_barrier);
+		if (residual)
+		{
+			for (uint64_t k = 0; k < options->number; ++k)
+			{
+				maxresiduum = (shared_maxresiduum[k] < maxresiduum) ? maxresiduum : shared_maxresiduum[k];
+			}
+		}
+
+		/* exchange m1 and m2 */
+		i = m1;
+		m1 = m2;
+		m2 = i;
+		stat_iteration++;
+		/* check for stopping calculation depending on termination method */
+		if (options->termination == TERM_PREC && --left == 0)
+		{
+			/* nobody may overwrite shared_maxresiduum before all have read it */
+			pthread_barrier_wait(inner_barrier);
+			left = nextCheck(&check, maxresiduum, options->term_precision);
+			if (maxresiduum < options->term_precision || stagnated(&check, N))
+			{
+				term_iteration = 0;
+			}
+		}
+		else if (options->termination == TERM_ITER)
+		{
+			term_iteration--;
+		}
+
+		/* all threads agree on both, so either all or none wait here */
+		if (args->due[stat_iteration % 2] && term_iteration > 0)
+		{
+			if (thread_num == 0)
+				saveCheckpoint(arguments, m2, stat_iteration, maxresiduum, left, &check);
+
+			/* nobody may change the matrix before it is copied */
+			pthread_barrier_wait(inner_barrier);
+		}
+	}
+	if (thread_num == 0)
+	{
+		results->m = m2;
+		results->stat_iteration = stat_iteration;
+		results->stat_precision = maxresiduum;
+		results->stat_checks = check.checks;
+		results->stat_stalled = stagnated(&check, N) ? check.stalled : 0;
+	}
+	return NULL;
+}
+
+/* ************************************************************************ */
+/* calculate_row_t: updates row i of matrix m2 into matrix m1               */
+/* ************************************************************************ */
+static inline double
+calculate_row_t(struct shared_args const* args, int m1, int m2, int i, int residual)
+{
+	int const N = args->N;
+	int const ld = args->ld;
+	typedef real(*matrix)[N + 1][ld];
+	matrix Matrix = (matrix)args->Matrix;
+
+	double const* f = rhsLine(args->arguments, i, args->rhs_buffer);
+
+	return args->kernel[residual](Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], Matrix[m1][i], f, 1.0, 1, N);
+}
+
+/* ************************************************************************ */
+/* calculate_wavefront_t: gets run by each thread to solve the equation     */
+/*                        with tile_depth sweeps per pass                   */
+/*                                                                          */
+/* Every pass is split into two phases. First each thread runs a skewed     */
+/* wavefront over its own rows, where sweep t leaves out t rows at every    */
+/* border shared with another thread. After a barrier the thread owning the */
+/* rows above a border fills in the missing diamond around it, sweep by     */
+/* sweep. This needs two barriers per pass instead of one per sweep and     */
+/* keeps the results bit-identical to calculate_t.                          */
+/* ************************************************************************ */
+static void *
+calculate_wavefront_t(void *data)
+{
+	struct shared_args *args = (struct shared_args *)data;
+	struct options const *options = args->options;
+	int const N = args->N;
+	struct calculation_results *results = args->results;
+	int thread_num = args->thread_num;
+	pthread_barrier_t *inner_barrier = args->inner_barrier;
+	double *shared_maxresiduum = args->shared_maxresiduum;
+
+	int i, s, t;		      /* local variables for loops */
+	int m1, m2;			      /* used as indices for old and new matrices */
+	int depth;			      /* number of sweeps in the current pass */
+	int residual;		      /* whether the last sweep has to compute the residuum */
+	double residuum;	      /* residuum of current row */
+	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+
+	uint64_t stat_iteration = 0;
+	uint64_t stat_checks = 0;
+	uint64_t term_iteration = options->term_iteration;
+	uint64_t passes = 0; /* passes so far, selects the checkpoint slot */
+
+	struct convergence_check check; /* fresh checks for a restart without tiles */
+
+	initCheck(&check, options, cos(M_PI / N));
+
+	m1 = 0;
+	m2 = 1;
+
+	int count = (N - 1) / options->number;
+	int remainder = (N - 1) % options->number;
+	int lower = 1 + thread_num * count;
+	int upper = lower + count;
+
+	lower += thread_num < remainder ? thread_num : remainder;
+	upper += thread_num < remainder ? thread_num + 1 : remainder;
+
+	/* rows shared with a neighbour thread shrink the trapezoid, matrix borders do not */
+	int shrink_lower = thread_num != 0;
+	int shrink_upper = (uint64_t)thread_num != options->number - 1;
+
+	/* continue with the state of the checkpoint */
+	if (options->restart)
+	{
+		m2 = results->m;
+		m1 = 1 - m2;
+		stat_iteration = results->stat_iteration;
+
+		if (options->termination == TERM_ITER)
+		{
+			term_iteration = (stat_iteration < term_iteration) ? term_iteration - stat_iteration : 0;
+		}
+	}
+
+	while (term_iteration > 0)
+	{
+		depth = options->tile_depth;
+
+		/* the barrier after the pass publishes it, the slot is only reused two passes later */
+		if (thread_num == 0)
+			args->due[(passes + 1) % 2] = checkpointDue();
+
+		if (options->termination == TERM_ITER && (uint64_t)depth > term_iteration)
+		{
+			depth = term_iteration;
+		}
+
+		residual = options->termination == TERM_PREC || term_iteration == (uint64_t)depth;
+		maxresiduum = 0.0;
+
+		/* phase 1: shrinking trapezoid over own rows */
+		for (s = lower; s < upper + depth - 1; s++)
+		{
+			for (t = 0; t < depth; t++)
+			{
+				i = s - t;
+
+				if (i < lower + t * shrink_lower || i >= upper - t * shrink_upper)
+				{
+					continue;
+				}
+
+				residuum = (t % 2 == 0) ? calculate_row_t(args, m1, m2, i, residual && t == depth - 1)
+				                        : calculate_row_t(args, m2, m1, i, residual && t == depth - 1);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+			}
+		}
+
+		pthread_barrier_wait(inner_barrier);
+
+		/* phase 2: diamond around the border to the next thread */
+		if (shrink_upper)
+		{
+			for (t = 1; t < depth; t++)
+			{
+				for (i = upper - t; i < upper + t; i++)
+				{
+					residuum = (t % 2 == 0) ? calculate_row_t(args, m1, m2, i, residual && t == depth - 1)
+					                        : calculate_row_t(args, m2, m1, i, residual && t == depth - 1);
+					maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+				}
+			}
+		}
+
+		if (residual)
+			shared_maxresiduum[thread_num] = maxresiduum;
+		pthread_barrier_wait(inner_barrier);
+		if (residual)
+		{
+			for (uint64_t k = 0; k < options->number; ++k)
+			{
+				maxresiduum = (shared_maxresiduum[k] < maxresiduum) ? maxresiduum : shared_maxresiduum[k];
+			}
+		}
+
+		/* exchange m1 and m2 once per sweep */
+		if (depth % 2 == 1)
+		{
+			i = m1;
+			m1 = m2;
+			m2 = i;
+		}
+		stat_iteration += depth;
+		passes++;
+		/* check for stopping calculation depending on termination method */
+		if (options->termination == TERM_PREC)
+		{
+			pthread_barrier_wait(inner_barrier);
+			stat_checks++;
+			if (maxresiduum < options->term_precision)
+			{
+				term_iteration = 0;
+			}
+		}
+		else if (options->termination == TERM_ITER)
+		{
+			term_iteration -= depth;
+		}
+
+		/* all threads agree on both, so either all or none wait here */
+		if (args->due[passes % 2] && term_iteration > 0)
+		{
+			if (thread_num == 0)
+				saveCheckpoint(args->arguments, m2, stat_iteration, maxresiduum, 1, &check);
+
+			/* nobody may change the matrix before it is copied */
+			pthread_barrier_wait(inner_barrier);
+		}
+	}
+	if (thread_num == 0)
+	{
+		results->m = m2;
+		results->stat_iteration = stat_iteration;
+		results->stat_precision = maxresiduum;
+		results->stat_checks = stat_checks;
+	}
+	return NULL;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation                                           */
+/* ************************************************************************ */
+static void
+calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int const N  = arguments->N;
+	int const ld = arguments->ld;
+
+	int const width = tileWidth(arguments, options);
+
+	struct shared_args args[options->number];
+	double shared_maxresiduum[options->number];
+
+	/* in place: two saved rows per thread and one edge row per thread */
+	real* rows = options->inplace ? allocateMemory(3 * options->number * ld * sizeof(real)) : NULL;
+
+	int due[2] = { 0, 0 };
+
+	pthread_t threads[options->number];
+	pthread_barrier_t inner_barrier;
+	pthread_barrier_init(&inner_barrier, NULL, options->number);
+
+	/* the convergence checks continue from the checkpoint, but as configured now */
+	checkpoint.header.check.adaptive = options->check == CHECK_ADAPTIVE;
+	for (uint64_t t = 0; t < options->number; ++t)
+	{
+		args[t].options = options;
+		args[t].ld = arguments->ld;
+		args[t].N = N;
+		args[t].arguments = arguments;
+		args[t].width = width;
+		args[t].saved = options->inplace ? rows + 2 * t * ld : NULL;
+		args[t].edges = options->inplace ? rows + 2 * options->number * ld : NULL;
+		args[t].kernel[0] = selectRowKernel(options, 0);
+		args[t].kernel[1] = selectRowKernel(options, 1);
+		args[t].rhs_buffer = arguments->rhs_buffer + t * (N + 1);
+		args[t].Matrix = arguments->M;
+		args[t].results = results;
+		args[t].thread_num = t;
+		args[t].inner_barrier = &inner_barrier;
+		args[t].due = due;
+		args[t].shared_maxresiduum = (double *)&shared_maxresiduum;
+		
+		pthread_create(&threads[t], NULL, options->tile_depth > 1 && options->method == METH_JACOBI && !options->inplace ? calculate_wavefront_t : calculate_t, (void *)&args[t]);
+	}
+
+	for (uint64_t t = 0; t < options->number; ++t)
+	{
+		pthread_join(threads[t], NULL);
+	}
+}
+
+/* ************************************************************************ */
+/*  displayStatistics: displays some statistics about the calculation       */
+/* ************************************************************************ */
+static void
+displayStatistics(struct calculation_arguments const* arguments, struct calculation_results const* results, struct options const* options)
+{
+	int    N    = arguments->N;
+	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
+
+	printf("Berechnungszeit:    %f s\n", time);
+	printf("Speicherbedarf:     %f MiB", (N + 1) * (N + 1) * sizeof(real) * arguments->num_matrices / 1024.0 / 1024.0);
+#ifdef FLOAT
+	printf(" (float)");
+#endif
+	printf("\n");
+	printf("Berechnungsmethode: ");
+
+	if (options->method == METH_GAUSS_SEIDEL)
+	{
+		printf("Gauß-Seidel");
+	}
+	else if (options->method == METH_JACOBI)
+	{
+		printf("Jacobi");
+
+		if (options->inplace)
+		{
+			printf(" (in place)");
+		}
+		else if (options->chebyshev)
+		{
+			printf(" (Chebyshev)");
+		}
+	}
+	else if (options->method == METH_RED_BLACK)
+	{
+		printf("Red-Black Gauß-Seidel");
+	}
+
+	printf("\n");
+	printf("Interlines:         %" PRIu64 "\n", options->interlines);
+	printf("Stoerfunktion:      ");
+
+	if (options->inf_func == FUNC_F0)
+	{
+		printf("f(x,y) = 0");
+	}
+	else if (options->inf_func == FUNC_FPISIN)
+	{
+		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+
+		/* only on request, the default output matches the reference */
+		if (getenv("PARTDIFF_RHS_BUDGET") != NULL)
+		{
+			if (arguments->rhs_mode == RHS_PLANE)
+			{
+				printf(" (Ebene)");
+			}
+			else if (arguments->rhs_mode == RHS_VECTORS)
+			{
+				printf(" (Vektoren)");
+			}
+			else
+			{
+				printf(" (Rekurrenz)");
+			}
+		}
+	}
+
+	printf("\n");
+	printf("Terminierung:       ");
+
+	if (options->termination == TERM_PREC && options->check == CHECK_ADAPTIVE)
+	{
+		printf("Hinreichende Genaugkeit (%" PRIu64 " Prüfungen)", results->stat_checks);
+	}
+	else if (options->termination == TERM_PREC)
+	{
+		printf("Hinreichende Genaugkeit");
+	}
+	else if (options->termination == TERM_ITER)
+	{
+		printf("Anzahl der Iterationen");
+	}
+
+	if (results->stat_stalled > 0)
+	{
+		printf(", abgebrochen: Residuum stagniert seit %" PRIu64 " Iterationen", results->stat_stalled);
+	}
+
+	printf("\n");
+	printf("Anzahl Iterationen: %" PRIu64 "\n", results->stat_iteration);
+
+	if (options->restart)
+	{
+		printf("Checkpoint:         fortgesetzt nach %" PRIu64 " Iterationen\n", checkpoint.restarted);
 	}
 
-	printf("\n");
-	printf("Anzahl Iterationen: %" PRIu64 "\n", results->stat_iteration);
 	printf("Norm des Fehlers:   %e\n", results->stat_precision);
 	printf("\n");
 }
@@ -645,8 +1913,9 @@ displayMatrix(struct calculation_arguments* arguments, struct calculation_result
 
 	int const interlines = options->interlines;
 	int const N          = arguments->N;
+	int const ld         = arguments->ld;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
@@ -679,7 +1948,7 @@ main(int argc, char** argv)
 
 	if (options.method == METH_GAUSS_SEIDEL)
 	{
-		printf("This version only works with Jacobi\n");
+		printf("This version only works with Jacobi and Red-Black Gauß-Seidel\n");
 		return 1;
 	}
 
@@ -688,13 +1957,26 @@ main(int argc, char** argv)
 	if (options.number > arguments.N)
 		options.number = 1;
 
-	allocateMatrices(&arguments);
+	/* the diamonds of neighbouring borders must not overlap */
+	if (options.tile_depth > (arguments.N - 1) / options.number / 2)
+	{
+		uint64_t const depth = ((arguments.N - 1) / options.number / 2 > 0) ? (arguments.N - 1) / options.number / 2 : 1;
+
+		printf("PARTDIFF_TILE_DEPTH %" PRIu64 " ist zu groß für %" PRIu64 " Threads, verwende %" PRIu64 "\n", options.tile_depth, options.number, depth);
+		options.tile_depth = depth;
+	}
+
+	allocateMatrices(&arguments, &options);
 	initMatrices(&arguments, &options);
+	initRhs(&arguments, &options);
+	initCheckpoint(&arguments, &results, &options);
 
 	gettimeofday(&start_time, NULL);
 	calculate(&arguments, &results, &options);
 	gettimeofday(&comp_time, NULL);
 
+	finishCheckpoint();
+
 	displayStatistics(&arguments, &results, &options);
 	displayMatrix(&arguments, &results, &options);
 
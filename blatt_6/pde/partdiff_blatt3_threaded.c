@@ -26,6 +26,7 @@
 /* Include standard header file.                                            */
 /* ************************************************************************ */
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,7 +35,9 @@
 #include <math.h>
 #include <malloc.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/time.h>
+#include <unistd.h>
 #include <pthread.h>
 
 /* ************* */
@@ -48,19 +51,54 @@
 #define MAX_INTERLINES    10240
 #define MAX_ITERATION     200000
 #define MAX_THREADS       1024
+#define MAX_TILE_WIDTH    (MAX_INTERLINES * 8 + 8)
+#define TILE_ROWS         8
+#define TILE_CACHE        (1 << 20)
+#define CACHE_LINE        64
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI       2
 #define FUNC_F0           1
 #define FUNC_FPISIN       2
 #define TERM_PREC         1
 #define TERM_ITER         2
+#define RHS_NONE          0
+#define RHS_RECURRENCE    1
+#define RHS_VECTORS       2
+#define RHS_PLANE         3
+#define RHS_BUDGET        2048 /* KiB, holds the vectors up to MAX_INTERLINES */
+#define MAX_RHS_BUDGET    (UINT64_C(1) << 30)
+#define CHECK_EVERY       0
+#define CHECK_ADAPTIVE    1
+#define CHECK_MAX_DISTANCE 64
+#define CHECK_SAFETY      0.5
+#define HUGEPAGES_OFF     0
+#define HUGEPAGES_TRANSPARENT 1
+#define HUGEPAGES_EXPLICIT 2
+#define HUGEPAGE_SIZE     (UINT64_C(2) << 20)
+
+/* matrix entries, -D FLOAT halves the memory traffic; sums stay double */
+#ifdef FLOAT
+typedef float real;
+#define MIN_PRECISION     1e-6
+#else
+typedef double real;
+#define MIN_PRECISION     1e-20
+#endif
 
 struct calculation_arguments
 {
 	uint64_t N;            /* number of spaces between lines (lines=N+1) */
+	uint64_t ld;           /* leading dimension, reals per padded matrix row */
 	uint64_t num_matrices; /* number of matrices */
 	double   h;            /* length of a space between two lines */
-	double*  M;            /* two matrices with real values */
+	real*    M;            /* two matrices with real values */
+	uint64_t rhs_mode;     /* how the right-hand side is provided */
+	double   rhs_sin;      /* sin(pi * h), start of the recurrence */
+	double   rhs_cos;      /* 2 * cos(pi * h), factor of the recurrence */
+	double*  rhs_row;      /* row factors 2 * pi^2 * h^2 * sin(pi * h * i) / 4 */
+	double*  rhs_col;      /* column factors sin(pi * h * j) */
+	double*  rhs_plane;    /* complete right-hand side */
+	double*  rhs_buffer;   /* one row of the right-hand side per thread */
 };
 
 struct calculation_results
@@ -68,6 +106,7 @@ struct calculation_results
 	uint64_t m;
 	uint64_t stat_iteration; /* number of current iteration */
 	double   stat_precision; /* actual precision of all slaves in iteration */
+	uint64_t stat_checks;    /* number of convergence checks */
 };
 
 struct options
@@ -79,28 +118,52 @@ struct options
 	uint64_t termination;    /* termination condition */
 	uint64_t term_iteration; /* terminate if iteration number reached */
 	double   term_precision; /* terminate if precision reached */
+	uint64_t tile_width;     /* columns per tile of a sweep, 0: from the cache */
+	uint64_t rhs_budget;     /* memory for the right-hand side in KiB */
+	uint64_t check;          /* when the convergence is checked */
+	uint64_t hugepages;      /* page size of the matrices */
 };
 
 struct init_args
 {
-	double* Matrix;
+	real* Matrix;
 	uint64_t thread_num;
 	struct options const* options;
+	uint64_t num_matrices;
+	int ld;
 	int N;
 };
 
 struct shared_args
 {
-	double* Matrix;
+	real* Matrix;
 	double* shared_maxresiduum;
 	uint64_t thread_num;
 	struct options const* options;
 	struct calculation_arguments const* arguments;
+	double* rhs_buffer;
 	struct calculation_results* results;
 	pthread_barrier_t* inner_barrier;
+	int width; /* columns per tile */
+	int ld; /* leading dimension of the matrices */
 	int N;
 };
 
+struct convergence_check
+{
+	uint64_t adaptive; /* check only as often as the contraction requires */
+	double   rho;      /* spectral radius estimate of the method */
+	double   residuum; /* maximum residuum at the last check, 0 before */
+	uint64_t distance; /* iterations between the last and the next check */
+	uint64_t checks;   /* number of checks so far */
+};
+
+struct mapping
+{
+	void*  addr; /* start of the mapped memory, NULL if there is none */
+	size_t size; /* length of the mapping in bytes */
+};
+
 struct vector
 {
 	size_t** buf;
@@ -119,6 +182,7 @@ static void* pop();
 struct timeval start_time; /* time when program started */
 struct timeval comp_time;  /* time when calculation completed */
 struct vector allocated_memory;
+struct mapping matrix_memory;
 
 static void
 usage(char* name)
@@ -138,12 +202,52 @@ usage(char* name)
 	printf("                 %1d: sufficient precision\n", TERM_PREC);
 	printf("                 %1d: number of iterations\n", TERM_ITER);
 	printf("  - prec/iter: depending on term:\n");
-	printf("                 precision:  1e-4 .. 1e-20\n");
+	printf("                 precision:  1e-4 .. %g\n", MIN_PRECISION);
 	printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
 	printf("\n");
+	printf("Environment:\n");
+	printf("  - PARTDIFF_TILE_WIDTH: columns per tile of a sweep (0 .. %d, default 0)\n", MAX_TILE_WIDTH);
+	printf("                 0: %d rows of a tile fill half of the L2 cache\n", TILE_ROWS);
+	printf("                 whole rows if the right-hand side is a recurrence\n");
+	printf("  - PARTDIFF_RHS_BUDGET: memory for the right-hand side in KiB (default %d)\n", RHS_BUDGET);
+	printf("                 the whole plane if it fits, otherwise row and column vectors,\n");
+	printf("                 the default always holds them, a smaller budget generates\n");
+	printf("                 every row by a less exact recurrence\n");
+	printf("  - PARTDIFF_CHECK: convergence checks with precision termination (default %d)\n", CHECK_EVERY);
+	printf("                 %1d: every iteration\n", CHECK_EVERY);
+	printf("                 %1d: adaptive, estimated from the residuum contraction,\n", CHECK_ADAPTIVE);
+	printf("                    at most %d iterations apart\n", CHECK_MAX_DISTANCE);
+	printf("  - PARTDIFF_HUGEPAGES: page size of the matrices (default %d)\n", HUGEPAGES_OFF);
+	printf("                 %1d: normal pages\n", HUGEPAGES_OFF);
+	printf("                 %1d: transparent huge pages\n", HUGEPAGES_TRANSPARENT);
+	printf("                 %1d: explicit huge pages, transparent ones if none are reserved\n", HUGEPAGES_EXPLICIT);
+	printf("\n");
 	printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
 
+/* ************************************************************************ */
+/* askEnvParam: reads an optional tuning parameter from the environment     */
+/* ************************************************************************ */
+static uint64_t
+askEnvParam(char* name, char const* variable, uint64_t min, uint64_t max, uint64_t fallback)
+{
+	char const* value = getenv(variable);
+	uint64_t    param;
+
+	if (value == NULL)
+	{
+		return fallback;
+	}
+
+	if (sscanf(value, "%" SCNu64, &param) != 1 || !(param >= min && param <= max))
+	{
+		usage(name);
+		exit(1);
+	}
+
+	return param;
+}
+
 static void
 askParams(struct options* options, int argc, char** argv)
 {
@@ -201,7 +305,7 @@ askParams(struct options* options, int argc, char** argv)
 
 		options->term_iteration = MAX_ITERATION;
 
-		if (ret != 1 || !(options->term_precision >= 1e-20 && options->term_precision <= 1e-4))
+		if (ret != 1 || !(options->term_precision >= MIN_PRECISION && options->term_precision <= 1e-4))
 		{
 			usage(argv[0]);
 			exit(1);
@@ -219,6 +323,30 @@ askParams(struct options* options, int argc, char** argv)
 			exit(1);
 		}
 	}
+
+	options->tile_width = askEnvParam(argv[0], "PARTDIFF_TILE_WIDTH", 0, MAX_TILE_WIDTH, 0);
+	options->rhs_budget = askEnvParam(argv[0], "PARTDIFF_RHS_BUDGET", 0, MAX_RHS_BUDGET, RHS_BUDGET);
+	options->check      = askEnvParam(argv[0], "PARTDIFF_CHECK", CHECK_EVERY, CHECK_ADAPTIVE, CHECK_EVERY);
+	options->hugepages  = askEnvParam(argv[0], "PARTDIFF_HUGEPAGES", HUGEPAGES_OFF, HUGEPAGES_EXPLICIT, HUGEPAGES_OFF);
+}
+
+/* ************************************************************************ */
+/* rowLength: returns the leading dimension of a matrix with N + 1 columns  */
+/*            of size bytes each                                            */
+/*                                                                          */
+/* Rows are padded to an odd number of cache lines. Every row then starts   */
+/* at a cache line, so no stencil load is split, and consecutive rows walk  */
+/* through all cache sets instead of aliasing at power-of-two strides.      */
+/* ************************************************************************ */
+static uint64_t
+rowLength(uint64_t N, size_t size)
+{
+	uint64_t const line  = CACHE_LINE / size;
+	uint64_t       lines = (N + line) / line;
+
+	lines += (lines % 2 == 0) ? 1 : 0;
+
+	return lines * line;
 }
 
 /* ************************************************************************ */
@@ -228,12 +356,14 @@ static void
 initVariables(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
 {
 	arguments->N            = (options->interlines * 8) + 9 - 1;
+	arguments->ld           = rowLength(arguments->N, sizeof(real));
 	arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
 	arguments->h            = 1.0 / arguments->N;
 
 	results->m              = 0;
 	results->stat_iteration = 0;
 	results->stat_precision = 0;
+	results->stat_checks    = 0;
 }
 
 /* ************************************************************************ */
@@ -244,6 +374,11 @@ cleanup() {
 	for (void* p = pop(); p != NULL; p = pop())
 		free(p);
 	free(allocated_memory.buf);
+
+	if (matrix_memory.addr != NULL)
+	{
+		munmap(matrix_memory.addr, matrix_memory.size);
+	}
 }
 
 /* ************************************************************************ */
@@ -316,19 +451,89 @@ pop()
 	return p;
 }
 
+/* ************************************************************************ */
+/* allocateMatrixMemory: maps zeroed memory for the matrices                */
+/*                                                                          */
+/* Anonymous mappings start out on the shared zero page, so the matrices    */
+/* need no zero pass and every page is placed on the NUMA node of the       */
+/* thread that writes it first. With huge pages the mapping is aligned to   */
+/* HUGEPAGE_SIZE, so the kernel can back all of it with them.               */
+/* ************************************************************************ */
+static void*
+allocateMatrixMemory(size_t size, uint64_t hugepages)
+{
+	size_t const align  = (hugepages == HUGEPAGES_OFF) ? (size_t)sysconf(_SC_PAGESIZE) : HUGEPAGE_SIZE;
+	size_t const length = (size + align - 1) & ~(align - 1);
+	size_t const extra  = (hugepages == HUGEPAGES_OFF) ? 0 : align;
+	char*        p      = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (hugepages == HUGEPAGES_EXPLICIT)
+	{
+		p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+		if (p == MAP_FAILED)
+		{
+			printf("Keine Huge Pages reserviert, verwende transparente Huge Pages\n");
+		}
+	}
+#endif
+
+	if (p == MAP_FAILED)
+	{
+		/* map one alignment more and give back the unaligned ends */
+		char* q = mmap(NULL, length + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (q == MAP_FAILED)
+		{
+			printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", length + extra);
+			cleanup();
+			exit(1);
+		}
+
+		p = (char*)(((uintptr_t)q + align - 1) & ~(uintptr_t)(align - 1));
+
+		if (p > q)
+		{
+			munmap(q, p - q);
+		}
+
+		if (q + extra > p)
+		{
+			munmap(p + length, q + extra - p);
+		}
+
+#ifdef MADV_HUGEPAGE
+		if (hugepages != HUGEPAGES_OFF)
+		{
+			madvise(p, length, MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	matrix_memory.addr = p;
+	matrix_memory.size = length;
+
+	return p;
+}
+
 /* ************************************************************************ */
 /* allocateMatrices: allocates memory for matrices                          */
 /* ************************************************************************ */
 static void
-allocateMatrices(struct calculation_arguments* arguments)
+allocateMatrices(struct calculation_arguments* arguments, struct options const* options)
 {
 	uint64_t const N = arguments->N;
 
-	arguments->M = allocateMemory(arguments->num_matrices * (N + 1) * (N + 1) * sizeof(double));
+	arguments->M = allocateMatrixMemory(arguments->num_matrices * (N + 1) * arguments->ld * sizeof(real), options->hugepages);
 }
 
 /* ************************************************************************ */
-/* initMatrices_t: per-thread function to zero out the matrix               */
+/* initMatrices_t: per-thread function to place the matrix rows             */
+/*                                                                          */
+/* The mapped memory is already zero. Every thread writes one zero into     */
+/* each page of the rows it computes in calculate_t, so the first touch     */
+/* puts them on its NUMA node. The border rows go to the outer threads.     */
 /* ************************************************************************ */
 static void *
 initMatrices_t(void *data)
@@ -336,22 +541,35 @@ initMatrices_t(void *data)
 	struct init_args *args = (struct init_args *)data;
 	uint64_t num_threads = args->options->number;
 	uint64_t thread_num = args->thread_num;
-	uint64_t method = args->options->method;
-	size_t N = (size_t)args->N + 1;
-	N *= N;
-	N <<= method == METH_JACOBI ? 1 : 0;
-	double* Matrix = args->Matrix;
-
-	size_t count = N / num_threads;
-	size_t remainder = N % num_threads;
-	size_t lower = thread_num * count;
+	size_t N = args->N;
+	size_t ld = args->ld;
+	size_t step = sysconf(_SC_PAGESIZE) / sizeof(real);
+	real* Matrix = args->Matrix;
+
+	size_t count = (N - 1) / num_threads;
+	size_t remainder = (N - 1) % num_threads;
+	size_t lower = 1 + thread_num * count;
 	size_t upper = lower + count;
 
 	lower += thread_num < remainder ? thread_num : remainder;
 	upper += thread_num < remainder ? thread_num + 1 : remainder;
 
-	for (size_t i = lower; i < upper; ++i)
-		Matrix[i] = 0;
+	lower -= thread_num == 0 ? 1 : 0;
+	upper += thread_num + 1 == num_threads ? 1 : 0;
+
+	if (lower == upper)
+		return NULL;
+
+	for (size_t g = 0; g < args->num_matrices; ++g)
+	{
+		real* first = Matrix + (g * (N + 1) + lower) * ld;
+		real* last = Matrix + (g * (N + 1) + upper) * ld - 1;
+
+		for (real* p = first; p < last; p += step)
+			*p = 0;
+
+		*last = 0;
+	}
 
 	return NULL;
 }
@@ -364,22 +582,25 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 {
 	uint64_t g, i; /* local variables for loops */
 
-	uint64_t const N = arguments->N;
-	double const   h = arguments->h;
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+	double const   h  = arguments->h;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
 	struct init_args t_args[options->number];
 	pthread_t threads[options->number];
 
-	/* initialize matrix/matrices with zeros */
+	/* place the rows of every thread on its NUMA node */
 	for (uint64_t t = 0; t < options->number; ++t)
 	{
 		t_args[t].Matrix = arguments->M;
+		t_args[t].ld = ld;
 		t_args[t].N = N;
 		t_args[t].options = options;
+		t_args[t].num_matrices = arguments->num_matrices;
 		t_args[t].thread_num = t;	
 		pthread_create(&threads[t], NULL, initMatrices_t, (void *)&t_args[t]);
 	}
@@ -409,25 +630,253 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 }
 
 /* ************************************************************************ */
-/* calculate_func: calculates the interference function                     */
+/* initRhs: prepares the right-hand side within the memory budget           */
+/*                                                                          */
+/* The interference function is the product of a row and a column factor.   */
+/* If the whole plane fits into the budget it is precomputed, otherwise     */
+/* both factor vectors are kept and multiplied for every row. Without even  */
+/* those, every row is generated by sin((j + 1) x) = 2 cos(x) sin(j x) -    */
+/* sin((j - 1) x), which only costs one sin() per row.                      */
 /* ************************************************************************ */
-static inline double
-calculate_func(struct calculation_arguments const* arguments, struct options const* options, int i, int j)
+static void
+initRhs(struct calculation_arguments* arguments, struct options const* options)
 {
-	double const h = arguments->h;
+	uint64_t i, j; /* local variables for loops */
+
+	uint64_t const N      = arguments->N;
+	double const   h      = arguments->h;
+	uint64_t const budget = options->rhs_budget * 1024;
+
+	arguments->rhs_mode   = RHS_NONE;
+	arguments->rhs_sin    = sin(M_PI * h);
+	arguments->rhs_cos    = 2 * cos(M_PI * h);
+	arguments->rhs_row    = NULL;
+	arguments->rhs_col    = NULL;
+	arguments->rhs_plane  = NULL;
+	arguments->rhs_buffer = allocateMemory(options->number * (N + 1) * sizeof(double));
+
+	/* f(x,y) = 0 leaves the buffers at 0 */
+	memset(arguments->rhs_buffer, 0, options->number * (N + 1) * sizeof(double));
+
+	if (options->inf_func != FUNC_FPISIN)
+	{
+		return;
+	}
 
-	if (options->inf_func == FUNC_FPISIN)
+	if ((N + 1) * (N + 1) * sizeof(double) <= budget)
+	{
+		arguments->rhs_mode = RHS_PLANE;
+	}
+	else if (2 * (N + 1) * sizeof(double) <= budget)
 	{
-		return ((2 * M_PI * M_PI) * h * h * sin(M_PI * h * (double)i) * sin(M_PI * h * (double)j)) / 4;
+		arguments->rhs_mode = RHS_VECTORS;
 	}
 	else
 	{
-		return 0.0;
+		arguments->rhs_mode = RHS_RECURRENCE;
+		return;
+	}
+
+	arguments->rhs_row = allocateMemory((N + 1) * sizeof(double));
+	arguments->rhs_col = allocateMemory((N + 1) * sizeof(double));
+
+	for (i = 0; i <= N; i++)
+	{
+		arguments->rhs_row[i] = ((2 * M_PI * M_PI) * h * h * sin(M_PI * h * (double)i)) / 4;
+		arguments->rhs_col[i] = sin(M_PI * h * (double)i);
+	}
+
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		arguments->rhs_plane = allocateMemory((N + 1) * (N + 1) * sizeof(double));
+
+		for (i = 0; i <= N; i++)
+		{
+			for (j = 0; j <= N; j++)
+			{
+				arguments->rhs_plane[i * (N + 1) + j] = arguments->rhs_row[i] * arguments->rhs_col[j];
+			}
+		}
 	}
 }
 
+/* ************************************************************************ */
+/* rhsLine: returns row i of the interference function, scaled by h^2 / 4   */
+/*          like the stencil; buffer holds N + 1 values if it is generated  */
+/* ************************************************************************ */
+static inline double const*
+rhsLine(struct calculation_arguments const* arguments, int i, double* buffer)
+{
+	int    j;  /* local variable for loop */
+	double fi; /* row factor */
+
+	int const N = arguments->N;
+
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		return arguments->rhs_plane + i * (N + 1);
+	}
+	else if (arguments->rhs_mode == RHS_VECTORS)
+	{
+		fi = arguments->rhs_row[i];
+
+		for (j = 0; j <= N; j++)
+		{
+			buffer[j] = fi * arguments->rhs_col[j];
+		}
+	}
+	else if (arguments->rhs_mode == RHS_RECURRENCE)
+	{
+		fi = ((2 * M_PI * M_PI) * arguments->h * arguments->h * sin(M_PI * arguments->h * (double)i)) / 4;
+
+		buffer[0] = 0.0;
+		buffer[1] = fi * arguments->rhs_sin;
+
+		for (j = 1; j < N; j++)
+		{
+			buffer[j + 1] = arguments->rhs_cos * buffer[j] - buffer[j - 1];
+		}
+	}
+
+	return buffer;
+}
+
+/* ************************************************************************ */
+/* rhsTile: like rhsLine, but only the columns first .. last - 1 have to be */
+/*          valid, so a tile does not generate the whole row                */
+/* ************************************************************************ */
+static inline double const*
+rhsTile(struct calculation_arguments const* arguments, int i, int first, int last, double* buffer)
+{
+	int    j;  /* local variable for loop */
+	double fi; /* row factor */
+
+	if (arguments->rhs_mode != RHS_VECTORS)
+	{
+		return rhsLine(arguments, i, buffer);
+	}
+
+	fi = arguments->rhs_row[i];
+
+	for (j = first; j < last; j++)
+	{
+		buffer[j] = fi * arguments->rhs_col[j];
+	}
+
+	return buffer;
+}
+
+/* ************************************************************************ */
+/* tileWidth: returns the number of columns per tile                        */
+/*                                                                          */
+/* Every thread runs over its rows in tiles of full height. Jacobi updates  */
+/* its points in any order, so the results do not change. TILE_ROWS rows of */
+/* a tile, counting matrix and right-hand side, have to stay in the L2      */
+/* cache between two rows.                                                  */
+/* ************************************************************************ */
+static int
+tileWidth(struct calculation_arguments const* arguments, struct options const* options)
+{
+	long cache = TILE_CACHE; /* size of the L2 cache in bytes */
+	int  width;              /* columns per tile */
+	int  tiles;              /* number of tiles */
+
+	int const N = arguments->N;
+
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	if (sysconf(_SC_LEVEL2_CACHE_SIZE) > 0)
+	{
+		cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	}
+#endif
+
+	width = options->tile_width;
+
+	if (width == 0)
+	{
+		/* whole cache lines of doubles */
+		width = (cache / 2 / (TILE_ROWS * sizeof(double))) & ~7;
+	}
+
+	/* the recurrence can only generate whole rows */
+	if (width <= 0 || width >= N - 1 || arguments->rhs_mode == RHS_RECURRENCE)
+	{
+		return N - 1;
+	}
+
+	if (options->tile_width == 0)
+	{
+		/* same number of tiles, but all of about the same width */
+		tiles = (N - 1 + width - 1) / width;
+		width = ((N - 1 + tiles - 1) / tiles + 7) & ~7;
+	}
+
+	return width;
+}
+
+/* ************************************************************************ */
+/* initCheck: prepares the convergence checks for a method whose residuum   */
+/*            contracts by about rho per iteration, the first check comes   */
+/*            after the first iteration                                     */
+/* ************************************************************************ */
+static void
+initCheck(struct convergence_check* check, struct options const* options, double rho)
+{
+	check->adaptive = options->check == CHECK_ADAPTIVE;
+	check->rho      = rho;
+	check->residuum = 0.0;
+	check->distance = 1;
+	check->checks   = 0;
+}
+
+/* ************************************************************************ */
+/* nextCheck: records the residuum of a check and returns the number of     */
+/*            iterations until the next one                                 */
+/*                                                                          */
+/* The contraction rate is measured between the last two checks and capped  */
+/* by rho, because it only slows down towards the spectral radius. The next */
+/* check comes after CHECK_SAFETY times the iterations the residuum still   */
+/* needs at that rate, so it rarely stops later than checking every time.   */
+/* ************************************************************************ */
+static uint64_t
+nextCheck(struct convergence_check* check, double maxresiduum, double term_precision)
+{
+	double rate = check->rho; /* residuum contraction per iteration */
+	double remaining;         /* iterations until the precision is reached */
+
+	if (check->residuum > 0.0 && maxresiduum < check->residuum)
+	{
+		double measured = pow(maxresiduum / check->residuum, 1.0 / check->distance);
+
+		rate = (measured < rate) ? measured : rate;
+	}
+
+	check->residuum = maxresiduum;
+	check->checks++;
+	check->distance = 1;
+
+	if (check->adaptive && rate > 0.0 && rate < 1.0 && maxresiduum > term_precision)
+	{
+		remaining = CHECK_SAFETY * log(term_precision / maxresiduum) / log(rate);
+
+		if (remaining >= CHECK_MAX_DISTANCE)
+		{
+			check->distance = CHECK_MAX_DISTANCE;
+		}
+		else if (remaining >= 1.0)
+		{
+			check->distance = remaining;
+		}
+	}
+
+	return check->distance;
+}
+
 /* ************************************************************************ */
 /* calculate_t: gets run by each thread to solve the equation               */
+/*                                                                          */
+/* Every thread keeps its own copy of the convergence checks. They all see  */
+/* the same residua, so they all agree on when to check next.               */
 /* ************************************************************************ */
 static void *
 calculate_t(void *data)
@@ -435,7 +884,8 @@ calculate_t(void *data)
 	struct shared_args *args = (struct shared_args *)data;
 	struct options const *options = args->options;
 	int const N = args->N;
-	typedef double(*matrix)[N + 1][N + 1];
+	int const ld = args->ld;
+	typedef real(*matrix)[N + 1][ld];
 	matrix Matrix = (matrix)args->Matrix;
 	struct calculation_results *results = args->results;
 	int thread_num = args->thread_num;
@@ -445,23 +895,32 @@ calculate_t(void *data)
 
 	int i, j;			      /* local variables for loops */
 	int m1, m2;			      /* used as indices for old and new matrices */
+	int first, last;	      /* columns of the current tile */
 	double star;		      /* four times center value minus 4 neigh.b values */
 	double residuum;	      /* residuum of current iteration */
 	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+	int residual;		      /* whether the current iteration computes the residuum */
 
 	uint64_t stat_iteration = 0;
 	uint64_t term_iteration = options->term_iteration;
 
+	uint64_t left = 1;              /* iterations until the next convergence check */
+	struct convergence_check check; /* state of the convergence checks */
+
 	/* initialize m1 and m2 depending on algorithm */
 	if (options->method == METH_JACOBI)
 	{
 		m1 = 0;
 		m2 = 1;
+
+		initCheck(&check, options, cos(M_PI / N));
 	}
 	else
 	{
 		m1 = 0;
 		m2 = 0;
+
+		initCheck(&check, options, cos(M_PI / N) * cos(M_PI / N));
 	}
 
 	int count = (N - 1) / options->number;
@@ -474,30 +933,42 @@ calculate_t(void *data)
 
 	while (term_iteration > 0)
 	{
+		residual = (options->termination == TERM_PREC && left == 1) || term_iteration == 1;
 		maxresiduum = 0.0;
 
-		/* over all rows */
-		for (i = lower; i < upper; i++)
+		/* over all tiles */
+		for (first = 1; first < N; first += args->width)
 		{
-			/* over all columns */
-			for (j = 1; j < N; j++)
+			last = (first + args->width < N) ? first + args->width : N;
+
+			/* over all rows */
+			for (i = lower; i < upper; i++)
 			{
-				star = (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
+				double const* f = rhsTile(arguments, i, first, last, args->rhs_buffer);
 
-				star += calculate_func(arguments, options, i, j);
+				/* over all columns of the tile */
+				for (j = first; j < last; j++)
+				{
+					star = ((double)Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
 
-				residuum = Matrix[m2][i][j] - star;
-				residuum = fabs(residuum);
-				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+					star += f[j];
 
-				Matrix[m1][i][j] = star;
+					if (residual)
+					{
+						residuum = Matrix[m2][i][j] - star;
+						residuum = fabs(residuum);
+						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+					}
+
+					Matrix[m1][i][j] = star;
+				}
 			}
 		}
 
-		if (options->termination == TERM_PREC || term_iteration == 1)
+		if (residual)
 			shared_maxresiduum[thread_num] = maxresiduum;
 		pthread_barrier_wait(inner_barrier);
-		if (options->termination == TERM_PREC || term_iteration == 1)
+		if (residual)
 		{
 			for (uint64_t k = 0; k < options->number; ++k)
 			{
@@ -511,9 +982,11 @@ calculate_t(void *data)
 		m2 = i;
 		stat_iteration++;
 		/* check for stopping calculation depending on termination method */
-		if (options->termination == TERM_PREC)
+		if (options->termination == TERM_PREC && --left == 0)
 		{
+			/* nobody may overwrite shared_maxresiduum before all have read it */
 			pthread_barrier_wait(inner_barrier);
+			left = nextCheck(&check, maxresiduum, options->term_precision);
 			if (maxresiduum < options->term_precision)
 			{
 				term_iteration = 0;
@@ -529,6 +1002,7 @@ calculate_t(void *data)
 		results->m = m2;
 		results->stat_iteration = stat_iteration;
 		results->stat_precision = maxresiduum;
+		results->stat_checks = check.checks;
 	}
 	return NULL;
 }
@@ -540,6 +1014,7 @@ static void
 calculate(struct calculation_arguments const *arguments, struct calculation_results *results, struct options const *options)
 {
 	int const N = arguments->N;
+	int const width = tileWidth(arguments, options);
 
 	struct shared_args args[options->number];
 	double shared_maxresiduum[options->number];
@@ -550,13 +1025,16 @@ calculate(struct calculation_arguments const *arguments, struct calculation_resu
 	for (uint64_t t = 0; t < options->number; ++t)
 	{
 		args[t].options = options;
+		args[t].ld = arguments->ld;
 		args[t].N = N;
 		args[t].Matrix = arguments->M;
 		args[t].results = results;
 		args[t].thread_num = t;
 		args[t].inner_barrier = &inner_barrier;
+		args[t].width = width;
 		args[t].shared_maxresiduum = (double *)&shared_maxresiduum;
 		args[t].arguments = arguments;
+		args[t].rhs_buffer = arguments->rhs_buffer + t * (N + 1);
 
 		pthread_create(&threads[t], NULL, calculate_t, (void *)&args[t]);
 	}
@@ -577,7 +1055,11 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
 
 	printf("Berechnungszeit:    %f s\n", time);
-	printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) * arguments->num_matrices / 1024.0 / 1024.0);
+	printf("Speicherbedarf:     %f MiB", (N + 1) * (N + 1) * sizeof(real) * arguments->num_matrices / 1024.0 / 1024.0);
+#ifdef FLOAT
+	printf(" (float)");
+#endif
+	printf("\n");
 	printf("Berechnungsmethode: ");
 
 	if (options->method == METH_GAUSS_SEIDEL)
@@ -600,12 +1082,33 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	else if (options->inf_func == FUNC_FPISIN)
 	{
 		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+
+		/* only on request, the default output matches the reference */
+		if (getenv("PARTDIFF_RHS_BUDGET") != NULL)
+		{
+			if (arguments->rhs_mode == RHS_PLANE)
+			{
+				printf(" (Ebene)");
+			}
+			else if (arguments->rhs_mode == RHS_VECTORS)
+			{
+				printf(" (Vektoren)");
+			}
+			else
+			{
+				printf(" (Rekurrenz)");
+			}
+		}
 	}
 
 	printf("\n");
 	printf("Terminierung:       ");
 
-	if (options->termination == TERM_PREC)
+	if (options->termination == TERM_PREC && options->check == CHECK_ADAPTIVE)
+	{
+		printf("Hinreichende Genaugkeit (%" PRIu64 " Prüfungen)", results->stat_checks);
+	}
+	else if (options->termination == TERM_PREC)
 	{
 		printf("Hinreichende Genaugkeit");
 	}
@@ -637,8 +1140,9 @@ displayMatrix(struct calculation_arguments* arguments, struct calculation_result
 
 	int const interlines = options->interlines;
 	int const N          = arguments->N;
+	int const ld         = arguments->ld;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[N + 1][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
@@ -680,8 +1184,9 @@ main(int argc, char** argv)
 	if (options.number > arguments.N)
 		options.number = 1;
 
-	allocateMatrices(&arguments);
+	allocateMatrices(&arguments, &options);
 	initMatrices(&arguments, &options);
+	initRhs(&arguments, &options);
 
 	gettimeofday(&start_time, NULL);
 	calculate(&arguments, &results, &options);
@@ -82,6 +82,8 @@ struct options
 	double   term_precision; /* terminate if precision reached */
 	int      rank;
 	int      size;
+	uint64_t overlap;        /* Jacobi exchanges the halo lines during the sweep */
+	uint64_t lagged;         /* the residuum is reduced during the next sweep */
 };
 
 /* ************************************************************************ */
@@ -113,6 +115,13 @@ usage(char* name)
 	printf("                 precision:  1e-4 .. 1e-20\n");
 	printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
 	printf("\n");
+	printf("Environment:\n");
+	printf("  - PARTDIFF_OVERLAP: Jacobi sends its first and last line before the other\n");
+	printf("                 lines and receives the halo lines meanwhile (0 .. 1, default 0)\n");
+	printf("  - PARTDIFF_LAGGED: lagged residuum reduction (0 .. 1, default 0)\n");
+	printf("                 with precision termination the residuum is reduced during the\n");
+	printf("                 next iteration, which stops one iteration later\n");
+	printf("\n");
 	printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
 
@@ -130,6 +139,29 @@ exit_failure()
 	exit(EXIT_FAILURE);
 }
 
+/* ************************************************************************ */
+/* askEnvParam: reads an optional tuning parameter from the environment     */
+/* ************************************************************************ */
+static uint64_t
+askEnvParam(char* name, char const* variable, uint64_t min, uint64_t max, uint64_t fallback)
+{
+	char const* value = getenv(variable);
+	uint64_t    param;
+
+	if (value == NULL)
+	{
+		return fallback;
+	}
+
+	if (sscanf(value, "%" SCNu64, &param) != 1 || !(param >= min && param <= max))
+	{
+		usage(name);
+		exit_failure();
+	}
+
+	return param;
+}
+
 static void
 askParams(struct options* options, int argc, char** argv)
 {
@@ -205,6 +237,9 @@ askParams(struct options* options, int argc, char** argv)
 			exit_failure();
 		}
 	}
+
+	options->overlap = askEnvParam(argv[0], "PARTDIFF_OVERLAP", 0, 1, 0);
+	options->lagged  = askEnvParam(argv[0], "PARTDIFF_LAGGED", 0, 1, 0);
 }
 
 /* ************************************************************************ */
@@ -375,26 +410,82 @@ calculate_func(struct calculation_arguments const* arguments, struct options con
 	}
 }
 
+/* ************************************************************************ */
+/* calculateLines: updates the local lines first .. last - 1 of matrix m2   */
+/*                 into matrix m1 and returns their maximum residuum,       */
+/*                 every matrix has local_to + 1 lines                      */
+/* ************************************************************************ */
+static double
+calculateLines(struct calculation_arguments const* arguments, struct options const* options, uint64_t local_to, int m1, int m2, uint64_t first, uint64_t last)
+{
+	uint64_t i, j;			      /* local variables for loops */
+	double star;		      /* four times center value minus 4 neigh.b values */
+	double residuum;	      /* residuum of current line */
+	double maxresiduum = 0.0; /* maximum residuum value of the lines */
+
+	uint64_t N        = arguments->N;
+	uint64_t global_i = arguments->from + first - 1;
+
+	typedef double(*matrix)[local_to + 1][N + 1];
+	matrix Matrix = (matrix)arguments->M;
+
+	/* over all rows */
+	for (i = first; i < last; i++, global_i++)
+	{
+		/* over all columns */
+		for (j = 1; j < N; j++)
+		{
+			star = (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
+
+			star += calculate_func(arguments, options, global_i, j);
+
+			residuum = Matrix[m2][i][j] - star;
+			residuum = fabs(residuum);
+			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+
+			Matrix[m1][i][j] = star;
+		}
+	}
+
+	return maxresiduum;
+}
+
 /* ************************************************************************ */
 /* calculate: solves the equation                                           */
+/*                                                                          */
+/* With overlap Jacobi updates the first and last line first and sends      */
+/* them to the neighbours with non-blocking calls. The other lines only     */
+/* read matrix m2, so they are updated while the halo lines of m1 are       */
+/* still in flight. Gauß-Seidel always exchanges after the whole sweep.     */
+/*                                                                          */
+/* Lagged, the residuum of an iteration is reduced with MPI_Iallreduce      */
+/* during the next one and only checked at its end. All processes wait for  */
+/* it after the same iteration, so they agree on when to stop. The matrix   */
+/* is then one iteration ahead, so its own residuum is reduced once more    */
+/* with a blocking call to keep the statistics consistent with it.          */
 /* ************************************************************************ */
 static void
 calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
 {
-	uint64_t i, j;			      /* local variables for loops */
+	uint64_t i;			      /* local variable for loops */
 	int m1, m2;			      /* used as indices for old and new matrices */
-	double star;		      /* four times center value minus 4 neigh.b values */
-	double residuum;	      /* residuum of current iteration */
+	double residuum;	      /* residuum of some lines of the current iteration */
 	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+	MPI_Request request[4];	  /* overlap: halo lines in flight */
+	int requests;		      /* overlap: number of requests in flight */
+	MPI_Request reduction;	  /* lagged: reduction of the last residuum */
+	double contribution;	  /* lagged: local residuum of the reduction */
+	double reduced;		      /* lagged: global residuum of the reduction */
+	int pending = 0;	      /* lagged: whether a reduction is in flight */
 
 	uint64_t stat_iteration = 0;
 	uint64_t term_iteration = options->term_iteration;
 	uint64_t N              = arguments->N;
 	uint64_t local_to       = arguments->local_to;
-	uint64_t from           = arguments->from;
-	uint64_t global_i       = from;
 	const int rank          = options->rank;
 	const int size          = options->size;
+	const int overlap       = options->overlap && options->method == METH_JACOBI && size != 1;
+	const int lagged        = options->lagged && options->termination == TERM_PREC;
 
 	/* initialize m1 and m2 depending on algorithm */
 	if (options->method == METH_JACOBI)
@@ -418,38 +509,58 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 
 	while (term_iteration > 0)
 	{
-		maxresiduum = 0.0;
-
-		/* over all rows */
-		for (i = 1, global_i = from; i < local_to; i++, global_i++)
+		if (overlap)
 		{
-			/* over all columns */
-			for (j = 1; j < N; j++)
-			{
-				star = (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
+			/* the lines the neighbours need first, then the rest while they travel */
+			maxresiduum = calculateLines(arguments, options, local_to, m1, m2, 1, (local_to < 2) ? local_to : 2);
 
-				star += calculate_func(arguments, options, global_i, j);
-
-				residuum = Matrix[m2][i][j] - star;
-				residuum = fabs(residuum);
+			if (local_to > 2)
+			{
+				residuum = calculateLines(arguments, options, local_to, m1, m2, local_to - 1, local_to);
 				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
-
-				Matrix[m1][i][j] = star;
 			}
-		}
 
-		if (options->termination == TERM_PREC || term_iteration == 1)
-			MPI_Allreduce(&maxresiduum, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+			requests = 0;
 
-		if (size != 1)
-		{
 			if (rank != 0)
 			{
-				MPI_Sendrecv(&Matrix[m1][1][1], N - 1, MPI_DOUBLE, rank - 1, 0, &Matrix[m1][0][1], N - 1, MPI_DOUBLE, rank - 1, 255, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				MPI_Irecv(&Matrix[m1][0][1], N - 1, MPI_DOUBLE, rank - 1, 255, MPI_COMM_WORLD, &request[requests++]);
+				MPI_Isend(&Matrix[m1][1][1], N - 1, MPI_DOUBLE, rank - 1, 0, MPI_COMM_WORLD, &request[requests++]);
 			}
 			if (size - rank != 1)
 			{
-				MPI_Sendrecv(&Matrix[m1][local_to - 1][1], N - 1, MPI_DOUBLE, rank + 1, 255, &Matrix[m1][local_to][1], N - 1, MPI_DOUBLE, rank + 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				MPI_Irecv(&Matrix[m1][local_to][1], N - 1, MPI_DOUBLE, rank + 1, 0, MPI_COMM_WORLD, &request[requests++]);
+				MPI_Isend(&Matrix[m1][local_to - 1][1], N - 1, MPI_DOUBLE, rank + 1, 255, MPI_COMM_WORLD, &request[requests++]);
+			}
+
+			if (local_to > 2)
+			{
+				residuum = calculateLines(arguments, options, local_to, m1, m2, 2, local_to - 1);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+			}
+
+			MPI_Waitall(requests, request, MPI_STATUSES_IGNORE);
+
+			if ((options->termination == TERM_PREC && !lagged) || term_iteration == 1)
+				MPI_Allreduce(MPI_IN_PLACE, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+		}
+		else
+		{
+			maxresiduum = calculateLines(arguments, options, local_to, m1, m2, 1, local_to);
+
+			if ((options->termination == TERM_PREC && !lagged) || term_iteration == 1)
+				MPI_Allreduce(&maxresiduum, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+			if (size != 1)
+			{
+				if (rank != 0)
+				{
+					MPI_Sendrecv(&Matrix[m1][1][1], N - 1, MPI_DOUBLE, rank - 1, 0, &Matrix[m1][0][1], N - 1, MPI_DOUBLE, rank - 1, 255, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				}
+				if (size - rank != 1)
+				{
+					MPI_Sendrecv(&Matrix[m1][local_to - 1][1], N - 1, MPI_DOUBLE, rank + 1, 255, &Matrix[m1][local_to][1], N - 1, MPI_DOUBLE, rank + 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				}
 			}
 		}
 
@@ -459,7 +570,33 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 		m2 = i;
 		stat_iteration++;
 		/* check for stopping calculation depending on termination method */
-		if (options->termination == TERM_PREC)
+		if (lagged)
+		{
+			/* contribution stays the send buffer until the pending reduction is done */
+			residuum = maxresiduum;
+
+			/* the reduction of the last residuum ran during this iteration */
+			if (pending)
+			{
+				MPI_Wait(&reduction, MPI_STATUS_IGNORE);
+				pending = 0;
+				maxresiduum = reduced;
+
+				if (maxresiduum < options->term_precision)
+				{
+					term_iteration = 0;
+					MPI_Allreduce(&residuum, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+				}
+			}
+
+			if (term_iteration > 0)
+			{
+				contribution = residuum;
+				MPI_Iallreduce(&contribution, &reduced, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD, &reduction);
+				pending = 1;
+			}
+		}
+		else if (options->termination == TERM_PREC)
 		{
 			if (maxresiduum < options->term_precision)
 				term_iteration = 0;
@@ -48,20 +48,62 @@
 #define MAX_THREADS       1024
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI       2
+#define METH_RED_BLACK    3
 #define FUNC_F0           1
 #define FUNC_FPISIN       2
 #define TERM_PREC         1
 #define TERM_ITER         2
+#define RHS_NONE          0
+#define RHS_RECURRENCE    1
+#define RHS_VECTORS       2
+#define RHS_PLANE         3
+#define RHS_BUDGET        2048 /* KiB, holds the vectors up to MAX_INTERLINES */
+#define MAX_RHS_BUDGET    (UINT64_C(1) << 30)
+#define CACHE_LINE        64
+#define CHECK_EVERY       0
+#define CHECK_ADAPTIVE    1
+#define CHECK_MAX_DISTANCE 64
+#define CHECK_SAFETY      0.5
+#define STALL_ITERATIONS  1000
+#define MAX_CHECKPOINT    86400
+#define CHECKPOINT_FILE   "partdiff.checkpoint"
+#define CHECKPOINT_MAGIC  "partdiff"
+#define CHUNK_COLUMNS     256
+#define MAX_CHUNK_COLUMNS (MAX_INTERLINES * 8 + 8)
+#define PIPELINE_LAG      2
+#define MAX_GRID_COLUMNS  (MAX_INTERLINES * 8 + 8)
+
+/* matrix entries, -D FLOAT halves the memory and message traffic; sums stay double */
+#ifdef FLOAT
+typedef float real;
+#define MPI_MATRIX_TYPE   MPI_FLOAT
+#define MIN_PRECISION     1e-6
+#else
+typedef double real;
+#define MPI_MATRIX_TYPE   MPI_DOUBLE
+#define MIN_PRECISION     1e-20
+#endif
 
 struct calculation_arguments
 {
 	uint64_t N;            /* number of spaces between lines (lines=N+1) */
+	uint64_t ld;           /* leading dimension, reals per padded matrix row */
 	uint64_t num_matrices; /* number of matrices */
 	uint64_t local_to;     /* local ending line of this process */
+	uint64_t local_cols;   /* local ending column of this process */
+	uint64_t width;        /* entries of a local line, including border and halo columns */
 	double   h;            /* length of a space between two lines */
-	double*  M;            /* two matrices with real values */
+	real*    M;            /* two matrices with real values */
 	int      from;         /* global starting line of this process */
 	int      to;           /* global ending line of this process */
+	int      col_from;     /* global starting column of this process */
+	uint64_t rhs_mode;     /* how the right-hand side is provided */
+	double   rhs_sin[2];   /* sin(pi * h * j) of local columns 0 and 1, start of the recurrence */
+	double   rhs_cos;      /* 2 * cos(pi * h), factor of the recurrence */
+	double*  rhs_row;      /* row factors 2 * pi^2 * h^2 * sin(pi * h * i) / 4 of the local lines */
+	double*  rhs_col;      /* column factors sin(pi * h * j) */
+	double*  rhs_plane;    /* right-hand side of the local lines */
+	double*  rhs_buffer;   /* one row of the right-hand side */
 };
 
 struct calculation_results
@@ -69,6 +111,8 @@ struct calculation_results
 	uint64_t m;
 	uint64_t stat_iteration; /* number of current iteration */
 	double   stat_precision; /* actual precision of all slaves in iteration */
+	uint64_t stat_checks;    /* number of convergence checks */
+	uint64_t stat_stalled;   /* iterations without a smaller residuum, if that stopped the run */
 };
 
 struct options
@@ -82,6 +126,57 @@ struct options
 	double   term_precision; /* terminate if precision reached */
 	int      rank;           /* mpi rank */
 	int      size;           /* mpi size */
+	uint64_t rhs_budget;     /* memory for the right-hand side in KiB */
+	uint64_t check;          /* when the convergence is checked */
+	uint64_t checkpoint;     /* seconds between checkpoints, 0: off */
+	uint64_t restart;        /* continue from the last checkpoint */
+	uint64_t chebyshev;      /* Jacobi with Chebyshev acceleration */
+	uint64_t overlap;        /* Jacobi exchanges the halo lines during the sweep */
+	uint64_t lagged;         /* the residuum is reduced while the sweeps go on */
+	uint64_t chunk;          /* columns per halo message of Gauß-Seidel */
+	uint64_t grid;           /* process columns of Jacobi, 0: automatic */
+	int      dims[2];        /* processes per line and per column of the grid */
+	int      coords[2];      /* position of this process in the grid */
+	int      neighbours[2][2]; /* previous and next process per dimension, MPI_PROC_NULL at the border */
+};
+
+struct convergence_check
+{
+	uint64_t adaptive; /* check only as often as the contraction requires */
+	double   rho;      /* spectral radius estimate of the method */
+	double   residuum; /* maximum residuum at the last check, 0 before */
+	uint64_t distance; /* iterations between the last and the next check */
+	uint64_t checks;   /* number of checks so far */
+	double   best;     /* smallest residuum of all checks */
+	uint64_t stalled;  /* iterations since the residuum last reached a new minimum */
+};
+
+struct checkpoint_header
+{
+	char     magic[8];       /* CHECKPOINT_MAGIC */
+	uint64_t real_size;      /* bytes per matrix entry */
+	uint64_t method;         /* parameters a restart has to match */
+	uint64_t interlines;
+	uint64_t inf_func;
+	uint64_t termination;
+	uint64_t stat_iteration; /* iterations done so far */
+	double   stat_precision; /* precision of the last checked iteration */
+	double   stat_omega;     /* relaxation factor (SOR), unused here */
+	uint64_t m;              /* matrix with the newest values */
+	uint64_t left;           /* iterations until the next convergence check */
+	struct convergence_check check; /* state of the convergence checks */
+};
+
+struct checkpoint
+{
+	uint64_t       interval;  /* seconds between checkpoints, 0: off */
+	char const*    path;      /* checkpoint file */
+	char*          temp;      /* file a checkpoint is written to first */
+	struct timeval last;      /* time of the last checkpoint (rank 0) */
+	uint64_t       restarted; /* iterations done before a restart */
+	int            due;       /* rank 0 found a checkpoint due */
+	MPI_Request    request;   /* broadcast of due */
+	struct checkpoint_header header; /* state written with the rows */
 };
 
 /* ************************************************************************ */
@@ -92,15 +187,25 @@ struct options
 struct timeval start_time; /* time when program started */
 struct timeval comp_time;  /* time when calculation completed */
 
+/* periodic checkpoints of the calculation */
+struct checkpoint checkpoint;
+
+/* all processes, arranged in a grid of blocks of lines and columns */
+MPI_Comm cart;
+
 static void
 usage(char* name)
 {
-	printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter]\n", name);
+	printf("Usage: %s [--restart] [num] [method] [lines] [func] [term] [prec/iter]\n", name);
 	printf("\n");
+	printf("  - --restart: continue from the last checkpoint, which has to be written\n");
+	printf("               with the same method, lines, func and term, but possibly\n");
+	printf("               by a different number of processes\n");
 	printf("  - num:       number of threads (1 .. %d)\n", MAX_THREADS);
-	printf("  - method:    calculation method (1 .. 2)\n");
+	printf("  - method:    calculation method (1 .. 3)\n");
 	printf("                 %1d: Gauß-Seidel\n", METH_GAUSS_SEIDEL);
 	printf("                 %1d: Jacobi\n", METH_JACOBI);
+	printf("                 %1d: Red-Black Gauß-Seidel\n", METH_RED_BLACK);
 	printf("  - lines:     number of interlines (0 .. %d)\n", MAX_INTERLINES);
 	printf("                 matrixsize = (interlines * 8) + 9\n");
 	printf("  - func:      interference function (1 .. 2)\n");
@@ -110,9 +215,34 @@ usage(char* name)
 	printf("                 %1d: sufficient precision\n", TERM_PREC);
 	printf("                 %1d: number of iterations\n", TERM_ITER);
 	printf("  - prec/iter: depending on term:\n");
-	printf("                 precision:  1e-4 .. 1e-20\n");
+	printf("                 precision:  1e-4 .. %g\n", MIN_PRECISION);
 	printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
 	printf("\n");
+	printf("Environment:\n");
+	printf("  - PARTDIFF_RHS_BUDGET: memory for the right-hand side per process in KiB (default %d)\n", RHS_BUDGET);
+	printf("                 the local plane if it fits, otherwise row and column vectors,\n");
+	printf("                 the default always holds them, a smaller budget generates\n");
+	printf("                 every row by a less exact recurrence (not Gauß-Seidel)\n");
+	printf("  - PARTDIFF_CHECK: convergence checks with precision termination (default %d)\n", CHECK_EVERY);
+	printf("                 %1d: every iteration\n", CHECK_EVERY);
+	printf("                 %1d: adaptive, estimated from the residuum contraction,\n", CHECK_ADAPTIVE);
+	printf("                    at most %d iterations apart\n", CHECK_MAX_DISTANCE);
+	printf("  - PARTDIFF_CHECKPOINT: seconds between checkpoints (0 .. %d, default 0: off)\n", MAX_CHECKPOINT);
+	printf("                 all processes write their lines to $PARTDIFF_CHECKPOINT_FILE\n");
+	printf("                 (default %s)\n", CHECKPOINT_FILE);
+	printf("  - PARTDIFF_CHEBYSHEV: Chebyshev acceleration of Jacobi (0 .. 1, default 0)\n");
+	printf("  - PARTDIFF_OVERLAP: Jacobi sends its first and last line before the other\n");
+	printf("                 lines and receives the halo lines meanwhile (0 .. 1, default 0)\n");
+	printf("  - PARTDIFF_LAGGED: lagged residuum reduction (0 .. 1, default 0)\n");
+	printf("                 with precision termination Jacobi reduces the residuum during\n");
+	printf("                 the next iteration, which stops one iteration later, Gauß-Seidel\n");
+	printf("                 passes it along the pipeline and stops %d iterations later\n", PIPELINE_LAG);
+	printf("  - PARTDIFF_CHUNK: columns per halo message of Gauß-Seidel (1 .. %d, default %d)\n", MAX_CHUNK_COLUMNS, CHUNK_COLUMNS);
+	printf("                 smaller chunks start the next process earlier\n");
+	printf("  - PARTDIFF_GRID: process columns of Jacobi (0 .. %d, default 0: automatic)\n", MAX_GRID_COLUMNS);
+	printf("                 the processes own blocks of lines and columns, 1 keeps whole\n");
+	printf("                 lines as Gauß-Seidel and Red-Black always do\n");
+	printf("\n");
 	printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
 
@@ -130,11 +260,44 @@ exit_failure()
 	exit(EXIT_FAILURE);
 }
 
+/* ************************************************************************ */
+/* askEnvParam: reads an optional tuning parameter from the environment     */
+/* ************************************************************************ */
+static uint64_t
+askEnvParam(char* name, char const* variable, uint64_t min, uint64_t max, uint64_t fallback)
+{
+	char const* value = getenv(variable);
+	uint64_t    param;
+
+	if (value == NULL)
+	{
+		return fallback;
+	}
+
+	if (sscanf(value, "%" SCNu64, &param) != 1 || !(param >= min && param <= max))
+	{
+		usage(name);
+		exit_failure();
+	}
+
+	return param;
+}
+
 static void
 askParams(struct options* options, int argc, char** argv)
 {
 	int ret;
 
+	options->restart = argc > 1 && strcmp(argv[1], "--restart") == 0;
+
+	/* the remaining parameters are the usual ones */
+	if (options->restart)
+	{
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+
 	if (argc < 7 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "-?") == 0)
 	{
 		usage(argv[0]);
@@ -151,7 +314,7 @@ askParams(struct options* options, int argc, char** argv)
 
 	ret = sscanf(argv[2], "%" SCNu64, &(options->method));
 
-	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI))
+	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI || options->method == METH_RED_BLACK))
 	{
 		usage(argv[0]);
 		exit_failure();
@@ -187,7 +350,7 @@ askParams(struct options* options, int argc, char** argv)
 
 		options->term_iteration = MAX_ITERATION;
 
-		if (ret != 1 || !(options->term_precision >= 1e-20 && options->term_precision <= 1e-4))
+		if (ret != 1 || !(options->term_precision >= MIN_PRECISION && options->term_precision <= 1e-4))
 		{
 			usage(argv[0]);
 			exit_failure();
@@ -205,6 +368,83 @@ askParams(struct options* options, int argc, char** argv)
 			exit_failure();
 		}
 	}
+
+	options->rhs_budget = askEnvParam(argv[0], "PARTDIFF_RHS_BUDGET", 0, MAX_RHS_BUDGET, RHS_BUDGET);
+	options->check      = askEnvParam(argv[0], "PARTDIFF_CHECK", CHECK_EVERY, CHECK_ADAPTIVE, CHECK_EVERY);
+	options->checkpoint = askEnvParam(argv[0], "PARTDIFF_CHECKPOINT", 0, MAX_CHECKPOINT, 0);
+	options->chebyshev  = askEnvParam(argv[0], "PARTDIFF_CHEBYSHEV", 0, 1, 0);
+	options->overlap    = askEnvParam(argv[0], "PARTDIFF_OVERLAP", 0, 1, 0);
+	options->lagged     = askEnvParam(argv[0], "PARTDIFF_LAGGED", 0, 1, 0);
+	options->chunk      = askEnvParam(argv[0], "PARTDIFF_CHUNK", 1, MAX_CHUNK_COLUMNS, CHUNK_COLUMNS);
+	options->grid       = askEnvParam(argv[0], "PARTDIFF_GRID", 0, MAX_GRID_COLUMNS, 0);
+}
+
+/* ************************************************************************ */
+/* initGrid: arranges the processes in a Cartesian grid                     */
+/*                                                                          */
+/* Jacobi splits the matrix into blocks of lines and columns, whose halo    */
+/* grows with the perimeter of a block instead of the whole line length.    */
+/* MPI_Dims_create picks the most square grid unless the number of process  */
+/* columns is given. Gauß-Seidel and Red-Black keep whole lines, their      */
+/* order of updates runs along the lines. MPI may reorder the ranks to fit  */
+/* the grid onto the machine, so all communication uses cart from now on.   */
+/* ************************************************************************ */
+static void
+initGrid(struct options* options)
+{
+	int       periods[2] = { 0, 0 };
+	int const N          = options->interlines * 8 + 8;
+
+	options->dims[0] = 0;
+	options->dims[1] = (options->method == METH_JACOBI) ? options->grid : 1;
+
+	if (options->dims[1] != 0 && options->size % options->dims[1] != 0)
+	{
+		if (options->rank == 0)
+		{
+			printf("%d Prozesse lassen sich nicht auf %d Spalten verteilen\n", options->size, options->dims[1]);
+		}
+
+		exit_failure();
+	}
+
+	MPI_Dims_create(options->size, 2, options->dims);
+
+	/* every process needs at least one line and one column */
+	if (options->dims[0] > N || options->dims[1] > N)
+	{
+		if (options->rank == 0)
+		{
+			printf("Zu viele Prozesse für die Matrixgröße (Prozessgitter %d x %d)\n", options->dims[0], options->dims[1]);
+		}
+
+		exit_failure();
+	}
+
+	MPI_Cart_create(MPI_COMM_WORLD, 2, options->dims, periods, 1, &cart);
+	MPI_Comm_rank(cart, &options->rank);
+	MPI_Cart_coords(cart, options->rank, 2, options->coords);
+	MPI_Cart_shift(cart, 0, 1, &options->neighbours[0][0], &options->neighbours[0][1]);
+	MPI_Cart_shift(cart, 1, 1, &options->neighbours[1][0], &options->neighbours[1][1]);
+}
+
+/* ************************************************************************ */
+/* rowLength: returns the leading dimension of a matrix with N + 1 columns  */
+/*            of size bytes each                                            */
+/*                                                                          */
+/* Rows are padded to an odd number of cache lines. Every row then starts   */
+/* at a cache line, so no stencil load is split, and consecutive rows walk  */
+/* through all cache sets instead of aliasing at power-of-two strides.      */
+/* ************************************************************************ */
+static uint64_t
+rowLength(uint64_t N, size_t size)
+{
+	uint64_t const line  = CACHE_LINE / size;
+	uint64_t       lines = (N + line) / line;
+
+	lines += (lines % 2 == 0) ? 1 : 0;
+
+	return lines * line;
 }
 
 /* ************************************************************************ */
@@ -217,8 +457,9 @@ initVariables(struct calculation_arguments* arguments, struct calculation_result
 	arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
 	arguments->h            = 1.0 / arguments->N;
 
-	uint64_t rank           = options->rank;
-	uint64_t size           = options->size;
+	/* the lines are split among the rows of the grid */
+	uint64_t rank           = options->coords[0];
+	uint64_t size           = options->dims[0];
 	uint64_t local_to       = arguments->N / size;
 	uint64_t remainder      = arguments->N % size;
 	uint64_t from           = rank * local_to + 1;
@@ -233,9 +474,24 @@ initVariables(struct calculation_arguments* arguments, struct calculation_result
 	arguments->from         = rank < remainder ? from + rank : from + remainder;
 	arguments->to           = rank < remainder ? to + rank + 1 : to + remainder;
 
+	/* and the columns the same way among the columns of the grid */
+	uint64_t column         = options->coords[1];
+	uint64_t columns        = options->dims[1];
+	uint64_t local_cols     = arguments->N / columns;
+	uint64_t rest           = arguments->N % columns;
+
+	arguments->local_cols   = column < rest ? local_cols + 1 : local_cols;
+	arguments->col_from     = column * local_cols + 1 + (column < rest ? column : rest);
+
+	/* the last column of the grid holds the right border instead of a halo column */
+	arguments->width        = (columns - column == 1) ? arguments->local_cols + 1 : arguments->local_cols + 2;
+	arguments->ld           = rowLength(arguments->width - 1, sizeof(real));
+
 	results->m              = 0;
 	results->stat_iteration = 0;
 	results->stat_precision = 0;
+	results->stat_checks    = 0;
+	results->stat_stalled   = 0;
 }
 
 /* ************************************************************************ */
@@ -245,18 +501,23 @@ static void
 freeMatrices(struct calculation_arguments* arguments)
 {
 	free(arguments->M);
+	free(arguments->rhs_row);
+	free(arguments->rhs_col);
+	free(arguments->rhs_plane);
+	free(arguments->rhs_buffer);
 }
 
 /* ************************************************************************ */
 /* allocateMemory ()                                                        */
-/* allocates memory and quits if there was a memory allocation problem      */
+/* allocates memory aligned to a cache line and quits if there was a memory */
+/* allocation problem                                                       */
 /* ************************************************************************ */
 static void*
 allocateMemory(size_t size)
 {
 	void* p;
 
-	if ((p = malloc(size)) == NULL)
+	if (posix_memalign(&p, CACHE_LINE, size) != 0)
 	{
 		printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", size);
 		exit_failure();
@@ -271,10 +532,9 @@ allocateMemory(size_t size)
 static void
 allocateMatrices(struct calculation_arguments* arguments)
 {
-	uint64_t const N = arguments->N;
 	uint64_t const local_to = arguments->local_to;
 
-	arguments->M = allocateMemory(arguments->num_matrices * (local_to + 2) * (N + 1) * sizeof(double));
+	arguments->M = allocateMemory(arguments->num_matrices * (local_to + 2) * arguments->ld * sizeof(real));
 }
 
 /* ************************************************************************ */
@@ -285,12 +545,14 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 {
 	uint64_t g, i, j; /* local variables for loops */
 
-	uint64_t const  N = arguments->N;
-	double const    h = arguments->h;
-	uint64_t local_to = arguments->local_to;
-	uint64_t from     = arguments->from;
+	uint64_t const  N     = arguments->N;
+	uint64_t const  ld    = arguments->ld;
+	uint64_t const  width = arguments->width;
+	double const    h     = arguments->h;
+	uint64_t local_to     = arguments->local_to;
+	uint64_t from         = arguments->from;
 
-	typedef double(*matrix)[local_to + 2][N + 1];
+	typedef real(*matrix)[local_to + 2][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
@@ -299,220 +561,1159 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 	{
 		for (i = 0; i <= local_to + 1; i++)
 		{
-			for (j = 0; j <= N; j++)
+			for (j = 0; j < width; j++)
 			{
 				Matrix[g][i][j] = 0.0;
 			}
 		}
 	}
 
-	uint64_t global_i = from;
+	uint64_t global_i, global_j;
+
+	/* the last row of the grid has no halo line below its last line */
+	uint64_t last = (options->dims[0] - options->coords[0] == 1) ? local_to : local_to + 1;
 
 	/* initialize borders, depending on function (function 2: nothing to do) */
 	if (options->inf_func == FUNC_F0)
 	{
+		for (g = 0; g < arguments->num_matrices; g++)
+		{
+			for (i = 0, global_i = from - 1; i <= last; i++, global_i++)
+			{
+				/* the first and last global line and column may also be halos */
+				for (j = 0, global_j = arguments->col_from - 1; j < width; j++, global_j++)
+				{
+					if (global_i == 0)
+					{
+						Matrix[g][i][j] = (global_j == N) ? 0.0 : 1.0 - (h * global_j);
+					}
+					else if (global_i == N)
+					{
+						Matrix[g][i][j] = (global_j == 0) ? 0.0 : h * global_j;
+					}
+					else if (global_j == 0)
+					{
+						Matrix[g][i][j] = 1.0 - (h * global_i);
+					}
+					else if (global_j == N)
+					{
+						Matrix[g][i][j] = h * global_i;
+					}
+				}
+			}
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* initRhs: prepares the right-hand side within the memory budget           */
+/*                                                                          */
+/* The interference function is the product of a row and a column factor.   */
+/* If the local lines of the whole plane fit into the budget they are       */
+/* precomputed, otherwise both factor vectors are kept and multiplied for   */
+/* every row. Without even those, every row is generated by                 */
+/* sin((j + 1) x) = 2 cos(x) sin(j x) - sin((j - 1) x), which only costs    */
+/* one sin() per row. Local line l is global line from - 1 + l and local    */
+/* column c global column col_from - 1 + c, just as in the matrix.          */
+/* Gauß-Seidel visits single points, so it keeps the vectors.               */
+/* ************************************************************************ */
+static void
+initRhs(struct calculation_arguments* arguments, struct options const* options)
+{
+	uint64_t i, j; /* local variables for loops */
+
+	uint64_t const width  = arguments->width;
+	uint64_t const lines  = arguments->local_to + 2;
+	double const   h      = arguments->h;
+	uint64_t const budget = options->rhs_budget * 1024;
+
+	arguments->rhs_mode   = RHS_NONE;
+	arguments->rhs_sin[0] = sin(M_PI * h * (double)(arguments->col_from - 1));
+	arguments->rhs_sin[1] = sin(M_PI * h * (double)arguments->col_from);
+	arguments->rhs_cos    = 2 * cos(M_PI * h);
+	arguments->rhs_row    = NULL;
+	arguments->rhs_col    = NULL;
+	arguments->rhs_plane  = NULL;
+	arguments->rhs_buffer = allocateMemory(width * sizeof(double));
+
+	/* f(x,y) = 0 leaves the buffer at 0 */
+	memset(arguments->rhs_buffer, 0, width * sizeof(double));
+
+	if (options->inf_func != FUNC_FPISIN)
+	{
+		return;
+	}
+
+	if (lines * width * sizeof(double) <= budget)
+	{
+		arguments->rhs_mode = RHS_PLANE;
+	}
+	else if ((lines + width) * sizeof(double) <= budget || options->method == METH_GAUSS_SEIDEL)
+	{
+		arguments->rhs_mode = RHS_VECTORS;
+	}
+	else
+	{
+		arguments->rhs_mode = RHS_RECURRENCE;
+		return;
+	}
+
+	arguments->rhs_row = allocateMemory(lines * sizeof(double));
+	arguments->rhs_col = allocateMemory(width * sizeof(double));
+
+	for (i = 0; i < lines; i++)
+	{
+		arguments->rhs_row[i] = ((2 * M_PI * M_PI) * h * h * sin(M_PI * h * (double)(arguments->from - 1 + i))) / 4;
+	}
+
+	for (j = 0; j < width; j++)
+	{
+		arguments->rhs_col[j] = sin(M_PI * h * (double)(arguments->col_from - 1 + j));
+	}
+
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		arguments->rhs_plane = allocateMemory(lines * width * sizeof(double));
+
+		for (i = 0; i < lines; i++)
+		{
+			for (j = 0; j < width; j++)
+			{
+				arguments->rhs_plane[i * width + j] = arguments->rhs_row[i] * arguments->rhs_col[j];
+			}
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* rhsLine: returns the local columns of global row i of the interference   */
+/*          function, scaled by h^2 / 4 like the stencil; i has to be a     */
+/*          line of this process                                            */
+/* ************************************************************************ */
+static inline double const*
+rhsLine(struct calculation_arguments const* arguments, int i)
+{
+	int    j;  /* local variable for loop */
+	double fi; /* row factor */
+
+	int const width = arguments->width;
+	int const local = i - arguments->from + 1;
+
+	double* buffer = arguments->rhs_buffer;
+
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		return arguments->rhs_plane + local * width;
+	}
+	else if (arguments->rhs_mode == RHS_VECTORS)
+	{
+		fi = arguments->rhs_row[local];
+
+		for (j = 0; j < width; j++)
+		{
+			buffer[j] = fi * arguments->rhs_col[j];
+		}
+	}
+	else if (arguments->rhs_mode == RHS_RECURRENCE)
+	{
+		fi = ((2 * M_PI * M_PI) * arguments->h * arguments->h * sin(M_PI * arguments->h * (double)i)) / 4;
+
+		buffer[0] = fi * arguments->rhs_sin[0];
+		buffer[1] = fi * arguments->rhs_sin[1];
+
+		for (j = 1; j < width - 1; j++)
+		{
+			buffer[j + 1] = arguments->rhs_cos * buffer[j] - buffer[j - 1];
+		}
+	}
+
+	return buffer;
+}
+
+/* ************************************************************************ */
+/* rhsPoint: returns the interference function at global line i and local   */
+/*           column j, which is the global one with whole lines             */
+/* ************************************************************************ */
+static inline double
+rhsPoint(struct calculation_arguments const* arguments, int i, int j)
+{
+	int const local = i - arguments->from + 1;
+
+	if (arguments->rhs_mode == RHS_PLANE)
+	{
+		return arguments->rhs_plane[local * arguments->width + j];
+	}
+	else if (arguments->rhs_mode == RHS_VECTORS)
+	{
+		return arguments->rhs_row[local] * arguments->rhs_col[j];
+	}
+
+	return 0.0;
+}
+
+/* ************************************************************************ */
+/* initCheck: prepares the convergence checks for a method whose residuum   */
+/*            contracts by about rho per iteration, the first check comes   */
+/*            after the first iteration                                     */
+/* ************************************************************************ */
+static void
+initCheck(struct convergence_check* check, struct options const* options, double rho)
+{
+	check->adaptive = options->check == CHECK_ADAPTIVE;
+	check->rho      = rho;
+	check->residuum = 0.0;
+	check->distance = 1;
+	check->checks   = 0;
+	check->best     = 0.0;
+	check->stalled  = 0;
+}
+
+/* ************************************************************************ */
+/* chebyshevWeight: returns the weight of iteration k of Jacobi with        */
+/*                  Chebyshev acceleration, omega is the one of k - 1       */
+/*                                                                          */
+/* u(k) = u(k - 2) + omega(k) (J u(k - 1) - u(k - 2)) with a Jacobi sweep J */
+/* and omega(1) = 1, omega(2) = 1 / (1 - rho^2 / 2), omega(k) = 1 / (1 -    */
+/* rho^2 omega(k - 1) / 4). The eigenvalues of J on the 5-point stencil lie */
+/* in [-rho, rho] with rho = cos(pi / N), so no estimate is needed.         */
+/* u(k - 2) is the old content of the matrix that u(k) is written to, and   */
+/* the weights only depend on k, so every process computes them itself.     */
+/* ************************************************************************ */
+static double
+chebyshevWeight(uint64_t k, double omega, double rho)
+{
+	if (k <= 1)
+	{
+		return 1.0;
+	}
+	else if (k == 2)
+	{
+		return 1.0 / (1.0 - rho * rho / 2);
+	}
+
+	return 1.0 / (1.0 - rho * rho * omega / 4);
+}
+
+/* ************************************************************************ */
+/* nextCheck: records the residuum of a check and returns the number of     */
+/*            iterations until the next one                                 */
+/*                                                                          */
+/* The contraction rate is measured between the last two checks and capped  */
+/* by rho, because it only slows down towards the spectral radius. The next */
+/* check comes after CHECK_SAFETY times the iterations the residuum still   */
+/* needs at that rate, so it rarely stops later than checking every time.   */
+/* ************************************************************************ */
+static uint64_t
+nextCheck(struct convergence_check* check, double maxresiduum, double term_precision)
+{
+	double rate = check->rho; /* residuum contraction per iteration */
+	double remaining;         /* iterations until the precision is reached */
+
+	if (check->residuum > 0.0 && maxresiduum < check->residuum)
+	{
+		double measured = pow(maxresiduum / check->residuum, 1.0 / check->distance);
+
+		rate = (measured < rate) ? measured : rate;
+	}
+
+	if (check->checks == 0 || maxresiduum < check->best)
+	{
+		check->best    = maxresiduum;
+		check->stalled = 0;
+	}
+	else
+	{
+		check->stalled += check->distance;
+	}
+
+	check->residuum = maxresiduum;
+	check->checks++;
+	check->distance = 1;
+
+	if (check->adaptive && rate > 0.0 && rate < 1.0 && maxresiduum > term_precision)
+	{
+		remaining = CHECK_SAFETY * log(term_precision / maxresiduum) / log(rate);
+
+		if (remaining >= CHECK_MAX_DISTANCE)
+		{
+			check->distance = CHECK_MAX_DISTANCE;
+		}
+		else if (remaining >= 1.0)
+		{
+			check->distance = remaining;
+		}
+	}
+
+	return check->distance;
+}
+
+/* ************************************************************************ */
+/* stagnated: returns whether the residuum has not reached a new minimum    */
+/*            for a long time, i.e. it hit the rounding level of the        */
+/*            method above the requested precision                          */
+/*                                                                          */
+/* Chebyshev keeps changing the last bits of the solution, so its residuum  */
+/* does not reach every precision down to MIN_PRECISION. The window grows   */
+/* with N because the residuum of over-relaxed methods can grow for about   */
+/* N iterations before it decreases.                                        */
+/* ************************************************************************ */
+static int
+stagnated(struct convergence_check const* check, uint64_t N)
+{
+	uint64_t const window = (4 * N > STALL_ITERATIONS) ? 4 * N : STALL_ITERATIONS;
+
+	return check->stalled >= window;
+}
+
+/* ************************************************************************ */
+/* announceCheckpoint: rank 0 decides whether the interval since the last   */
+/*                     checkpoint has passed and broadcasts it              */
+/*                                                                          */
+/* The clocks of the processes differ, so only rank 0 looks at its clock.   */
+/* The broadcast is non-blocking and completes during the sweep, so all     */
+/* processes agree on the decision without waiting for it.                  */
+/* ************************************************************************ */
+static void
+announceCheckpoint(int rank)
+{
+	struct checkpoint* cp = &checkpoint;
+	struct timeval     now;
+
+	if (cp->interval == 0)
+	{
+		return;
+	}
+
+	cp->due = 0;
+
+	if (rank == 0)
+	{
+		gettimeofday(&now, NULL);
+
+		if (cp->last.tv_sec == 0 && cp->last.tv_usec == 0)
+		{
+			cp->last = now;
+		}
+
+		cp->due = (uint64_t)(now.tv_sec - cp->last.tv_sec) >= cp->interval;
+	}
+
+	MPI_Ibcast(&cp->due, 1, MPI_INT, 0, cart, &cp->request);
+}
+
+/* ************************************************************************ */
+/* checkpointDue: waits for the decision of announceCheckpoint              */
+/* ************************************************************************ */
+static int
+checkpointDue(void)
+{
+	if (checkpoint.interval == 0)
+	{
+		return 0;
+	}
+
+	MPI_Wait(&checkpoint.request, MPI_STATUS_IGNORE);
+
+	return checkpoint.due;
+}
+
+/* ************************************************************************ */
+/* checkpointBlock: describes count local lines of a matrix, starting at    */
+/*                  local line first, and of them cols columns, starting at */
+/*                  local column west, in memory and in the file            */
+/*                                                                          */
+/* The file holds the whole matrix without padding, global point (i, j) at  */
+/* sizeof(header) + i * (N + 1) + j entries, so it does not depend on the   */
+/* number of processes or the grid. Local line l is global line             */
+/* from - 1 + l and local column c global column col_from - 1 + c.          */
+/* ************************************************************************ */
+static void
+checkpointBlock(struct calculation_arguments const* arguments, uint64_t first, uint64_t count, uint64_t west, uint64_t cols, MPI_Datatype* block, MPI_Datatype* view)
+{
+	int const sizes[2]    = { arguments->N + 1, arguments->N + 1 };
+	int const subsizes[2] = { count, cols };
+	int const starts[2]   = { arguments->from - 1 + first, arguments->col_from - 1 + west };
+
+	MPI_Type_vector(count, cols, arguments->ld, MPI_MATRIX_TYPE, block);
+	MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_MATRIX_TYPE, view);
+	MPI_Type_commit(block);
+	MPI_Type_commit(view);
+}
+
+/* ************************************************************************ */
+/* saveCheckpoint: writes matrix m and the state of the iteration           */
+/*                                                                          */
+/* Every process writes the block it owns with one collective call, the     */
+/* processes at the edges of the grid also the borders. The file is synced  */
+/* and closed before rank 0 renames it over the last checkpoint, so a crash */
+/* never leaves a half written one.                                         */
+/* ************************************************************************ */
+static void
+saveCheckpoint(struct calculation_arguments const* arguments, struct options const* options, int m, uint64_t stat_iteration, double stat_precision, uint64_t left, struct convergence_check const* check)
+{
+	struct checkpoint* cp = &checkpoint;
+	MPI_File           file;
+	MPI_Datatype       block;
+	MPI_Datatype       view;
+	int                failed = 0;
+
+	uint64_t const N     = arguments->N;
+	uint64_t const ld    = arguments->ld;
+	uint64_t const first = (options->coords[0] == 0) ? 0 : 1;
+	uint64_t const count = arguments->local_to + 1 - first;
+	uint64_t const west  = (options->coords[1] == 0) ? 0 : 1;
+	uint64_t const cols  = arguments->local_cols + 1 - west;
+
+	cp->header.stat_iteration = stat_iteration;
+	cp->header.stat_precision = stat_precision;
+	cp->header.m              = m;
+	cp->header.left           = left;
+	cp->header.check          = *check;
+
+	checkpointBlock(arguments, first, count, west, cols, &block, &view);
+
+	if (MPI_File_open(cart, cp->temp, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) == MPI_SUCCESS)
+	{
+		failed |= MPI_File_set_size(file, sizeof(cp->header) + (N + 1) * (N + 1) * sizeof(real)) != MPI_SUCCESS;
+
 		if (options->rank == 0)
 		{
-			for (g = 0; g < arguments->num_matrices; g++)
+			failed |= MPI_File_write_at(file, 0, &cp->header, sizeof(cp->header), MPI_BYTE, MPI_STATUS_IGNORE) != MPI_SUCCESS;
+		}
+
+		failed |= MPI_File_set_view(file, sizeof(cp->header), MPI_MATRIX_TYPE, view, "native", MPI_INFO_NULL) != MPI_SUCCESS;
+		failed |= MPI_File_write_all(file, arguments->M + (m * (arguments->local_to + 2) + first) * ld + west, 1, block, MPI_STATUS_IGNORE) != MPI_SUCCESS;
+		failed |= MPI_File_sync(file) != MPI_SUCCESS;
+		failed |= MPI_File_close(&file) != MPI_SUCCESS;
+	}
+	else
+	{
+		failed = 1;
+	}
+
+	MPI_Type_free(&block);
+	MPI_Type_free(&view);
+	MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, cart);
+
+	if (options->rank == 0 && (failed || rename(cp->temp, cp->path) != 0))
+	{
+		printf("Checkpoint konnte nicht geschrieben werden (%s)\n", cp->path);
+	}
+
+	gettimeofday(&cp->last, NULL);
+}
+
+/* ************************************************************************ */
+/* initCheckpoint: prepares the checkpoints and with --restart loads the    */
+/*                 last one into the matrix and the results                 */
+/*                                                                          */
+/* Every process reads its block of the current grid together with its      */
+/* halos, so the checkpoint may come from any number of processes.          */
+/* ************************************************************************ */
+static void
+initCheckpoint(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
+{
+	struct checkpoint*       cp = &checkpoint;
+	struct checkpoint_header header;
+	MPI_File                 file;
+	MPI_Datatype             block;
+	MPI_Datatype             view;
+	MPI_Offset               size;
+	MPI_Status               status;
+	int                      count;
+	int                      failed = 0;
+
+	uint64_t const N  = arguments->N;
+	uint64_t const ld = arguments->ld;
+
+	/* the last row of the grid has no halo line below its last line */
+	uint64_t const last = (options->dims[0] - options->coords[0] == 1) ? arguments->local_to : arguments->local_to + 1;
+
+	char const* path = getenv("PARTDIFF_CHECKPOINT_FILE");
+
+	cp->interval = options->checkpoint;
+	cp->path     = (path != NULL) ? path : CHECKPOINT_FILE;
+	cp->temp     = allocateMemory(strlen(cp->path) + 5);
+
+	sprintf(cp->temp, "%s.tmp", cp->path);
+
+	memset(&cp->header, 0, sizeof(cp->header));
+	memcpy(cp->header.magic, CHECKPOINT_MAGIC, sizeof(cp->header.magic));
+	cp->header.real_size   = sizeof(real);
+	cp->header.method      = options->method;
+	cp->header.interlines  = options->interlines;
+	cp->header.inf_func    = options->inf_func;
+	cp->header.termination = options->termination;
+
+	if (!options->restart)
+	{
+		return;
+	}
+
+	if (MPI_File_open(cart, cp->path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+	{
+		if (options->rank == 0)
+		{
+			printf("Checkpoint kann nicht gelesen werden (%s)\n", cp->path);
+		}
+
+		exit_failure();
+	}
+
+	/* all processes read the same header, so they all take the same decisions */
+	failed |= MPI_File_read_at_all(file, 0, &header, sizeof(header), MPI_BYTE, &status) != MPI_SUCCESS;
+	failed |= MPI_Get_count(&status, MPI_BYTE, &count) != MPI_SUCCESS || count != sizeof(header);
+	failed |= MPI_File_get_size(file, &size) != MPI_SUCCESS;
+
+	MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, cart);
+
+	if (failed)
+	{
+		if (options->rank == 0)
+		{
+			printf("Checkpoint kann nicht gelesen werden (%s)\n", cp->path);
+		}
+
+		MPI_File_close(&file);
+		exit_failure();
+	}
+
+	if (memcmp(header.magic, cp->header.magic, sizeof(header.magic)) != 0 || header.real_size != cp->header.real_size || header.method != cp->header.method || header.interlines != cp->header.interlines || header.inf_func != cp->header.inf_func || header.termination != cp->header.termination || header.m >= arguments->num_matrices)
+	{
+		if (options->rank == 0)
+		{
+			printf("Checkpoint passt nicht zu den Parametern (%s)\n", cp->path);
+		}
+
+		MPI_File_close(&file);
+		exit_failure();
+	}
+
+	if ((uint64_t)size < sizeof(header) + (N + 1) * (N + 1) * sizeof(real))
+	{
+		if (options->rank == 0)
+		{
+			printf("Checkpoint ist unvollständig (%s)\n", cp->path);
+		}
+
+		MPI_File_close(&file);
+		exit_failure();
+	}
+
+	checkpointBlock(arguments, 0, last + 1, 0, arguments->width, &block, &view);
+
+	failed |= MPI_File_set_view(file, sizeof(header), MPI_MATRIX_TYPE, view, "native", MPI_INFO_NULL) != MPI_SUCCESS;
+	failed |= MPI_File_read_all(file, arguments->M + header.m * (arguments->local_to + 2) * ld, 1, block, MPI_STATUS_IGNORE) != MPI_SUCCESS;
+
+	MPI_Type_free(&block);
+	MPI_Type_free(&view);
+	MPI_File_close(&file);
+	MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, cart);
+
+	if (failed)
+	{
+		if (options->rank == 0)
+		{
+			printf("Checkpoint kann nicht gelesen werden (%s)\n", cp->path);
+		}
+
+		exit_failure();
+	}
+
+	cp->header    = header;
+	cp->restarted = header.stat_iteration;
+
+	results->m              = header.m;
+	results->stat_iteration = header.stat_iteration;
+	results->stat_precision = header.stat_precision;
+}
+
+/* ************************************************************************ */
+/* sendChunk: sends count entries of a line from a buffer of the request    */
+/*            pool, after the send that used the buffer before is done      */
+/* ************************************************************************ */
+static void
+sendChunk(real const* line, real* buffer, int count, int dest, int tag, MPI_Request* request)
+{
+	MPI_Wait(request, MPI_STATUS_IGNORE);
+	memcpy(buffer, line, count * sizeof(real));
+	MPI_Isend(buffer, count, MPI_MATRIX_TYPE, dest, tag, cart, request);
+}
+
+/* ************************************************************************ */
+/* calculate_gauss_seidel: solves the equation with Gauss Seidel            */
+/*                                                                          */
+/* The columns are split into chunks of options->chunk columns, and every   */
+/* process sweeps its lines chunk by chunk, row by row inside a chunk. This */
+/* is the same order of updates as a sweep over whole rows. A process needs */
+/* the new last line of the process above and the old first line of the     */
+/* process below, so it receives both per chunk before it starts one and    */
+/* sends its own first and last line per chunk when it is done. The process */
+/* below then starts while this one works on the next chunk.                */
+/*                                                                          */
+/* The sends go out of copies, two iterations of them in a pool, so a line  */
+/* can be updated again before the neighbour received its old values.       */
+/*                                                                          */
+/* Lagged, no collective stops the pipeline. Every process adds its maximum */
+/* residuum to the one of the processes above and sends it on with its last */
+/* chunk, so the last process ends up with the global one. It broadcasts it */
+/* with MPI_Ibcast, and every process waits for it only PIPELINE_LAG        */
+/* iterations later. All of them then stop after the same iteration, with a */
+/* matrix that is PIPELINE_LAG iterations ahead of the decisive residuum.   */
+/* Its own residuum is broadcast as well and reported once all arrived.     */
+/* The adaptive checks do not apply, every iteration is checked.            */
+/* ************************************************************************ */
+static void
+calculate_gauss_seidel(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	uint64_t 	i, j;        /* local variables for loops */
+	uint64_t 	c;           /* index of the current chunk */
+	uint64_t 	first, last; /* columns of the current chunk */
+	double 		star;        /* four times center value minus 4 neigh.b values */
+	double 		residuum;    /* residuum of current iteration */
+	double 		maxresiduum; /* maximum residuum value of a slave in iteration */
+	int 		residual;    /* whether the current iteration computes the residuum */
+	int 		parity;      /* half of the request pool of the current iteration */
+	int 		below = 0;   /* whether the process below sent its first line */
+	double 		partial;     /* lagged: maximum residuum of the processes above */
+	uint64_t 	issued = 0;  /* lagged: iterations whose residuum is broadcast */
+	uint64_t 	slot;        /* lagged: broadcast of the current iteration */
+
+	double      forwarded[2];               /* lagged: maxima sent to the process below, by parity */
+	MPI_Request forward[2];                 /* lagged: sends of forwarded */
+	double      decided[PIPELINE_LAG + 1];  /* lagged: global residua of the last iterations */
+	MPI_Request decision[PIPELINE_LAG + 1]; /* lagged: broadcasts of decided */
+
+	uint64_t stat_iteration = 0;
+	uint64_t term_iteration = options->term_iteration;
+	uint64_t N              = arguments->N;
+	uint64_t local_to       = arguments->local_to;
+	uint64_t from           = arguments->from - 1;
+	const int rank          = options->rank;
+	const int size          = options->size;
+	const int lagged        = options->lagged && options->termination == TERM_PREC;
+
+	uint64_t const chunk  = options->chunk;
+	uint64_t const chunks = (N - 1 + chunk - 1) / chunk;
+
+	/* per iteration parity the lines sent upwards and downwards */
+	real*        outgoing = allocateMemory(4 * (N + 1) * sizeof(real));
+	MPI_Request* sent     = allocateMemory(4 * chunks * sizeof(MPI_Request));
+
+	for (c = 0; c < 4 * chunks; ++c)
+	{
+		sent[c] = MPI_REQUEST_NULL;
+	}
+
+	forward[0] = forward[1] = MPI_REQUEST_NULL;
+
+	for (slot = 0; slot <= PIPELINE_LAG; ++slot)
+	{
+		decision[slot] = MPI_REQUEST_NULL;
+	}
+
+	if (size - rank != 1)
+	{
+		++local_to;
+	}
+
+	typedef real(*matrix)[local_to + 1][arguments->ld];
+	matrix Matrix = (matrix)arguments->M;
+
+	uint64_t left = 1;              /* iterations until the next convergence check */
+	struct convergence_check check; /* state of the convergence checks */
+
+	initCheck(&check, options, cos(M_PI / N) * cos(M_PI / N));
+
+	/* continue with the state of the checkpoint, which holds the lower halo line of the last iteration */
+	if (options->restart)
+	{
+		checkpoint.header.check.adaptive = check.adaptive;
+
+		check          = checkpoint.header.check;
+		stat_iteration = results->stat_iteration;
+		left           = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+
+		if (options->termination == TERM_ITER)
+		{
+			term_iteration = (stat_iteration < term_iteration) ? term_iteration - stat_iteration : 0;
+		}
+	}
+
+	while (term_iteration > 0)
+	{
+		residual    = lagged || (options->termination == TERM_PREC && left == 1) || term_iteration == 1;
+		maxresiduum = 0.0;
+		parity      = stat_iteration % 2;
+
+		announceCheckpoint(rank);
+
+		/* over all chunks */
+		for (c = 0, first = 1; first < N; ++c, first = last)
+		{
+			last = (first + chunk < N) ? first + chunk : N;
+
+			if (rank != 0)
 			{
-				for (i = 0, global_i = from; i <= local_to; i++, global_i++)
+				MPI_Recv(&Matrix[0][0][first], last - first, MPI_MATRIX_TYPE, rank - 1, 255, cart, MPI_STATUS_IGNORE);
+			}
+
+			if (size - rank != 1 && below)
+			{
+				MPI_Recv(&Matrix[0][local_to][first], last - first, MPI_MATRIX_TYPE, rank + 1, 0, cart, MPI_STATUS_IGNORE);
+			}
+
+			/* over all rows */
+			for (i = 1; i < local_to; ++i)
+			{
+				/* over all columns of the chunk */
+				for (j = first; j < last; ++j)
 				{
-					for (j = 0; j <= N; j++)
+					star = ((double)Matrix[0][i - 1][j] + Matrix[0][i][j - 1] + Matrix[0][i][j + 1] + Matrix[0][i + 1][j]) / 4;
+
+					star += rhsPoint(arguments, i + from, j);
+
+					if (residual)
 					{
-						Matrix[g][0][j] = 1.0 - (h * global_i);
+						residuum    = Matrix[0][i][j] - star;
+						residuum    = fabs(residuum);
+						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
 					}
+
+					Matrix[0][i][j] = star;
 				}
 			}
+
+			if (rank != 0)
+			{
+				sendChunk(&Matrix[0][1][first], outgoing + (2 * parity) * (N + 1) + first, last - first, rank - 1, 0, &sent[(2 * parity) * chunks + c]);
+			}
+
+			if (size - rank != 1)
+			{
+				sendChunk(&Matrix[0][local_to - 1][first], outgoing + (2 * parity + 1) * (N + 1) + first, last - first, rank + 1, 255, &sent[(2 * parity + 1) * chunks + c]);
+			}
 		}
 
-		if (options->size - options->rank == 1)
+		below = 1;
+
+		if (lagged)
+		{
+			/* the maximum of the processes above follows their last chunk */
+			if (rank != 0)
+			{
+				MPI_Recv(&partial, 1, MPI_DOUBLE, rank - 1, 1, cart, MPI_STATUS_IGNORE);
+				maxresiduum = (partial < maxresiduum) ? maxresiduum : partial;
+			}
+
+			if (size - rank != 1)
+			{
+				MPI_Wait(&forward[parity], MPI_STATUS_IGNORE);
+				forwarded[parity] = maxresiduum;
+				MPI_Isend(&forwarded[parity], 1, MPI_DOUBLE, rank + 1, 1, cart, &forward[parity]);
+			}
+
+			/* only the last process has the global maximum, the others receive it into the slot */
+			slot          = issued++ % (PIPELINE_LAG + 1);
+			decided[slot] = maxresiduum;
+			MPI_Ibcast(&decided[slot], 1, MPI_DOUBLE, size - 1, cart, &decision[slot]);
+		}
+		else if (residual)
+		{
+			MPI_Allreduce(MPI_IN_PLACE, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, cart);
+		}
+
+		stat_iteration++;
+		/* check for stopping calculation depending on termination method */
+		if (lagged)
+		{
+			/* the residuum of PIPELINE_LAG iterations ago, in the slot the next one reuses */
+			if (issued > PIPELINE_LAG)
+			{
+				slot = issued % (PIPELINE_LAG + 1);
+
+				MPI_Wait(&decision[slot], MPI_STATUS_IGNORE);
+				maxresiduum = decided[slot];
+				nextCheck(&check, maxresiduum, options->term_precision);
+
+				if (maxresiduum < options->term_precision || stagnated(&check, N))
+				{
+					term_iteration = 0;
+				}
+			}
+		}
+		else if (options->termination == TERM_PREC && --left == 0)
+		{
+			left = nextCheck(&check, maxresiduum, options->term_precision);
+
+			if (maxresiduum < options->term_precision || stagnated(&check, N))
+			{
+				term_iteration = 0;
+			}
+		}
+		else if (options->termination == TERM_ITER)
+		{
+			term_iteration--;
+		}
+
+		/* all processes received the same decision */
+		if (checkpointDue() && term_iteration > 0)
+		{
+			saveCheckpoint(arguments, options, 0, stat_iteration, check.residuum, left, &check);
+		}
+	}
+
+	/* the first line the process below sent in the last iteration */
+	for (c = 0, first = 1; size - rank != 1 && below && first < N; ++c, first = last)
+	{
+		last = (first + chunk < N) ? first + chunk : N;
+
+		MPI_Recv(&Matrix[0][local_to][first], last - first, MPI_MATRIX_TYPE, rank + 1, 0, cart, MPI_STATUS_IGNORE);
+	}
+
+	MPI_Waitall(4 * chunks, sent, MPI_STATUSES_IGNORE);
+	MPI_Waitall(2, forward, MPI_STATUSES_IGNORE);
+	MPI_Waitall(PIPELINE_LAG + 1, decision, MPI_STATUSES_IGNORE);
+
+	/* the residuum of the last iteration, which the matrix belongs to */
+	if (lagged && issued > 0)
+	{
+		maxresiduum = decided[(issued - 1) % (PIPELINE_LAG + 1)];
+	}
+
+	free(outgoing);
+	free(sent);
+
+	results->m = 0;
+	results->stat_iteration = stat_iteration;
+	results->stat_precision = maxresiduum;
+	results->stat_checks    = check.checks;
+	results->stat_stalled   = stagnated(&check, N) ? check.stalled : 0;
+}
+
+/* ************************************************************************ */
+/* jacobiBlock: updates the local lines first .. last - 1 in the local      */
+/*              columns west .. east - 1 of matrix m2 into matrix m1 and    */
+/*              returns their maximum residuum                              */
+/* ************************************************************************ */
+static double
+jacobiBlock(struct calculation_arguments const* arguments, struct options const* options, int m1, int m2, uint64_t first, uint64_t last, uint64_t west, uint64_t east, int residual, double omega)
+{
+	uint64_t i, j;			      /* local variables for loops */
+	double star;		      /* four times center value minus 4 neigh.b values */
+	double residuum;	      /* residuum of current line */
+	double maxresiduum = 0.0; /* maximum residuum value of the block */
+
+	/* every matrix has local_to + 2 lines, including the halo lines */
+	typedef real(*matrix)[arguments->local_to + 2][arguments->ld];
+	matrix Matrix = (matrix)arguments->M;
+
+	/* over all rows */
+	for (i = first; i < last; i++)
+	{
+		double const* f = rhsLine(arguments, arguments->from + i - 1);
+
+		/* over the columns of the block */
+		for (j = west; j < east; j++)
 		{
-			for (g = 0; g < arguments->num_matrices; g++)
+			star = ((double)Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
+
+			star += f[j];
+
+			if (residual)
 			{
-				for (i = 0, global_i = from; i <= local_to; i++, global_i++)
-				{
-					for (j = 0; j <= N; j++)
-					{
-						Matrix[g][local_to][j] = h * global_i;
-					}
-				}
+				residuum = Matrix[m2][i][j] - star;
+				residuum = fabs(residuum);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
 			}
-		}
 
-		for (g = 0; g < arguments->num_matrices; g++)
-		{
-			for (i = 0, global_i = from; i <= local_to; i++, global_i++)
+			if (options->chebyshev)
 			{
-				Matrix[g][i][0] = 1.0 - (h * global_i);
-				Matrix[g][i][N] = h * global_i;
+				star = Matrix[m1][i][j] + omega * (star - Matrix[m1][i][j]);
 			}
 
-			Matrix[g][local_to][0] = 0.0;
-			Matrix[g][0][N] = 0.0;
+			Matrix[m1][i][j] = star;
 		}
 	}
-}
-
-/* ************************************************************************ */
-/* calculate_func: calculates the interference function                     */
-/* ************************************************************************ */
-static inline double
-calculate_func(struct calculation_arguments const* arguments, struct options const* options, int i, int j)
-{
-	double const h = arguments->h;
 
-	if (options->inf_func == FUNC_FPISIN)
-	{
-		return ((2 * M_PI * M_PI) * h * h * sin(M_PI * h * (double)i) * sin(M_PI * h * (double)j)) / 4;
-	}
-	else
-	{
-		return 0.0;
-	}
+	return maxresiduum;
 }
 
 /* ************************************************************************ */
-/* calculate_gauss_seidel: solves the equation with Gauss Seidel            */
+/* calculate_jacobi: solves the equation with Jacobi                        */
+/*                                                                          */
+/* Every process updates a block of lines and columns of the grid and then  */
+/* exchanges its first and last line with the processes above and below     */
+/* and its first and last column, as an MPI_Type_vector with stride ld,     */
+/* with the processes to the left and right. The processes at the edges of  */
+/* the grid have MPI_PROC_NULL there, which turns those calls into no-ops.  */
+/*                                                                          */
+/* With overlap the first and last line and column are updated first and    */
+/* sent to the neighbours with non-blocking calls. The other points only    */
+/* read matrix m2, so they are updated while the halos of m1 are still in   */
+/* flight.                                                                  */
+/*                                                                          */
+/* Lagged, the residuum of an iteration is reduced with MPI_Iallreduce      */
+/* during the next one and only checked at its end. All processes wait for  */
+/* it after the same iteration, so they agree on when to stop. That         */
+/* iteration computes its own residuum as well, and when it stops, a last   */
+/* blocking reduction of it keeps the statistics consistent with the        */
+/* matrix.                                                                  */
 /* ************************************************************************ */
 static void
-calculate_gauss_seidel(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+calculate_jacobi(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
 {
-	uint64_t 	i, j;        /* local variables for loops */
-	int 		direction;   /* direction for diagonal traversal */
-	double 		star;        /* four times center value minus 4 neigh.b values */
-	double 		residuum;    /* residuum of current iteration */
-	double 		maxresiduum; /* maximum residuum value of a slave in iteration */
+	uint64_t i;			      /* local variable for loops */
+	int m1, m2;			      /* used as indices for old and new matrices */
+	double residuum;	      /* residuum of some lines of the current iteration */
+	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+	int residual;		      /* whether the current iteration computes the residuum */
+	MPI_Datatype column;	  /* the local lines of one column */
+	MPI_Request request[8];	  /* overlap: halos in flight */
+	int requests;		      /* overlap: number of requests in flight */
+	MPI_Request reduction;	  /* lagged: reduction of the last residuum */
+	double contribution;	  /* lagged: local residuum of the reduction */
+	double reduced;		      /* lagged: global residuum of the reduction */
+	int pending = 0;	      /* lagged: whether a reduction is in flight */
+	int reduce;		          /* lagged: whether the current iteration starts a reduction */
+	double omega = 0.0;	      /* weight of the current iteration (Chebyshev) */
+	uint64_t sweeps = 0;      /* iterations since the start, a restart starts anew */
 
 	uint64_t stat_iteration = 0;
 	uint64_t term_iteration = options->term_iteration;
 	uint64_t N              = arguments->N;
 	uint64_t local_to       = arguments->local_to;
-	uint64_t from           = arguments->from - 1;
+	uint64_t local_cols     = arguments->local_cols;
 	const int rank          = options->rank;
 	const int size          = options->size;
+	const int above         = options->neighbours[0][0];
+	const int below         = options->neighbours[0][1];
+	const int west          = options->neighbours[1][0];
+	const int east          = options->neighbours[1][1];
+	const int overlap       = options->overlap && size != 1;
+	const int lagged        = options->lagged && options->termination == TERM_PREC;
+	const double rho        = cos(M_PI / N); /* spectral radius of Jacobi */
 
-	MPI_Request req[N];
-
-	for (i = 0; i < N; ++i)
+	/* initialize m1 and m2 depending on algorithm */
+	if (options->method == METH_JACOBI)
+	{
+		m1 = 0;
+		m2 = 1;
+	}
+	else
 	{
-		req[i] = MPI_REQUEST_NULL;
+		m1 = 0;
+		m2 = 0;
 	}
 
-	if (size - rank != 1)
+	if (options->dims[0] - options->coords[0] != 1)
 	{
 		++local_to;
 	}
 
-	typedef double(*matrix)[local_to + 1][N + 1];
+	if (options->dims[1] - options->coords[1] != 1)
+	{
+		++local_cols;
+	}
+
+	/* the first and last columns the overlap updates before the others */
+	uint64_t const inner = (local_cols < 2) ? local_cols : 2;
+	uint64_t const outer = (local_cols < 3) ? inner : local_cols - 1;
+
+	/* every matrix has local_to + 2 lines, including the halo lines */
+	typedef real(*matrix)[arguments->local_to + 2][arguments->ld];
 	matrix Matrix = (matrix)arguments->M;
 
+	MPI_Type_vector(local_to - 1, 1, arguments->ld, MPI_MATRIX_TYPE, &column);
+	MPI_Type_commit(&column);
+
+	uint64_t left = 1;              /* iterations until the next convergence check */
+	struct convergence_check check; /* state of the convergence checks */
+
+	/* Chebyshev approaches the contraction of SOR with the optimal factor */
+	initCheck(&check, options, options->chebyshev ? (1 - sqrt(1 - rho * rho)) / (1 + sqrt(1 - rho * rho)) : rho);
+
+	/* continue with the state of the checkpoint */
+	if (options->restart)
+	{
+		checkpoint.header.check.adaptive = check.adaptive;
+
+		check          = checkpoint.header.check;
+		stat_iteration = results->stat_iteration;
+		left           = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+		m2             = results->m;
+		m1             = 1 - m2;
+
+		if (options->termination == TERM_ITER)
+		{
+			term_iteration = (stat_iteration < term_iteration) ? term_iteration - stat_iteration : 0;
+		}
+	}
+
 	while (term_iteration > 0)
 	{
-		maxresiduum = 0.0;
+		reduce   = options->termination == TERM_PREC && left == 1;
+		residual = reduce || term_iteration == 1 || pending;
 
-		MPI_Waitall(N, req, MPI_STATUSES_IGNORE);
+		if (options->chebyshev)
+			omega = chebyshevWeight(++sweeps, omega, rho);
 
-		for (i = 1, j = 1, direction = 0; i < local_to && j < N;)
+		announceCheckpoint(rank);
+
+		if (overlap)
 		{
-			if (rank != 0 && i == 1)
+			/* the lines and columns the neighbours need first, then the rest while they travel */
+			maxresiduum = jacobiBlock(arguments, options, m1, m2, 1, (local_to < 2) ? local_to : 2, 1, local_cols, residual, omega);
+
+			if (local_to > 2)
 			{
-				MPI_Recv(&Matrix[0][0][j], 1, MPI_DOUBLE, rank - 1, j, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				residuum = jacobiBlock(arguments, options, m1, m2, local_to - 1, local_to, 1, local_cols, residual, omega);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
 			}
 
-			star = (Matrix[0][i - 1][j] + Matrix[0][i][j - 1] + Matrix[0][i][j + 1] + Matrix[0][i + 1][j]) / 4;
+			/* the first and last column of the other lines, with whole lines they go along with the rest */
+			if (options->dims[1] != 1 && local_to > 3)
+			{
+				residuum = jacobiBlock(arguments, options, m1, m2, 2, local_to - 1, 1, inner, residual, omega);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+				residuum = jacobiBlock(arguments, options, m1, m2, 2, local_to - 1, outer, local_cols, residual, omega);
+				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+			}
 
-			star += calculate_func(arguments, options, i + from, j);
+			requests = 0;
 
-			residuum    = Matrix[0][i][j] - star;
-			residuum    = fabs(residuum);
-			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+			MPI_Irecv(&Matrix[m1][0][1], local_cols - 1, MPI_MATRIX_TYPE, above, 255, cart, &request[requests++]);
+			MPI_Isend(&Matrix[m1][1][1], local_cols - 1, MPI_MATRIX_TYPE, above, 0, cart, &request[requests++]);
+			MPI_Irecv(&Matrix[m1][local_to][1], local_cols - 1, MPI_MATRIX_TYPE, below, 0, cart, &request[requests++]);
+			MPI_Isend(&Matrix[m1][local_to - 1][1], local_cols - 1, MPI_MATRIX_TYPE, below, 255, cart, &request[requests++]);
 
-			Matrix[0][i][j] = star;
+			if (options->dims[1] != 1)
+			{
+				MPI_Irecv(&Matrix[m1][1][0], 1, column, west, 254, cart, &request[requests++]);
+				MPI_Isend(&Matrix[m1][1][1], 1, column, west, 1, cart, &request[requests++]);
+				MPI_Irecv(&Matrix[m1][1][local_cols], 1, column, east, 1, cart, &request[requests++]);
+				MPI_Isend(&Matrix[m1][1][local_cols - 1], 1, column, east, 254, cart, &request[requests++]);
 
-			if (size - rank != 1 && i == local_to - 1)
+				residuum = jacobiBlock(arguments, options, m1, m2, 2, local_to - 1, inner, outer, residual, omega);
+			}
+			else
 			{
-				MPI_Isend(&Matrix[0][local_to - 1][j], 1, MPI_DOUBLE, rank + 1, j, MPI_COMM_WORLD, &req[j - 1]);
+				residuum = jacobiBlock(arguments, options, m1, m2, 2, local_to - 1, 1, local_cols, residual, omega);
 			}
 
-			/* upward diagonal direction */
-			if (direction == 0)
+			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+
+			MPI_Waitall(requests, request, MPI_STATUSES_IGNORE);
+
+			if (residual && !lagged)
+				MPI_Allreduce(MPI_IN_PLACE, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, cart);
+		}
+		else
+		{
+			maxresiduum = jacobiBlock(arguments, options, m1, m2, 1, local_to, 1, local_cols, residual, omega);
+
+			if (residual && !lagged)
+				MPI_Allreduce(MPI_IN_PLACE, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, cart);
+
+			if (size != 1)
 			{
-				/* right limit hit, go down and change direction */
-				if (j == N - 1)
-				{
-					++i;
-					direction = 255;
-				}
-				/* upper limit hit, go right and change direction */
-				else if (i == 1)
-				{
-					++j;
-					direction = 255;
-				}
-				else
-				{
-					--i, ++j;
-				}
+				MPI_Sendrecv(&Matrix[m1][1][1], local_cols - 1, MPI_MATRIX_TYPE, above, 0, &Matrix[m1][0][1], local_cols - 1, MPI_MATRIX_TYPE, above, 255, cart, MPI_STATUS_IGNORE);
+				MPI_Sendrecv(&Matrix[m1][local_to - 1][1], local_cols - 1, MPI_MATRIX_TYPE, below, 255, &Matrix[m1][local_to][1], local_cols - 1, MPI_MATRIX_TYPE, below, 0, cart, MPI_STATUS_IGNORE);
+				MPI_Sendrecv(&Matrix[m1][1][1], 1, column, west, 1, &Matrix[m1][1][0], 1, column, west, 254, cart, MPI_STATUS_IGNORE);
+				MPI_Sendrecv(&Matrix[m1][1][local_cols - 1], 1, column, east, 254, &Matrix[m1][1][local_cols], 1, column, east, 1, cart, MPI_STATUS_IGNORE);
 			}
+		}
 
-			/* downward diagonal direction */
-			else
+		/* exchange m1 and m2 */
+		i = m1;
+		m1 = m2;
+		m2 = i;
+		stat_iteration++;
+		/* check for stopping calculation depending on termination method */
+		if (lagged)
+		{
+			--left;
+			/* contribution stays the send buffer until the pending reduction is done */
+			residuum = maxresiduum;
+
+			/* the reduction of the last residuum ran during this iteration */
+			if (pending)
 			{
-				/* lower limit hit, go right and change direction */
-				if (i == local_to - 1)
-				{
-					++j;
-					direction = 0;
-				}
-				/* left limit hit, go down and change direction */
-				else if (j == 1)
+				MPI_Wait(&reduction, MPI_STATUS_IGNORE);
+				pending = 0;
+				maxresiduum = reduced;
+
+				uint64_t distance = nextCheck(&check, maxresiduum, options->term_precision);
+
+				/* this iteration already ran without the residuum */
+				if (check.adaptive)
 				{
-					++i;
-					direction = 0;
+					left = (distance > 1) ? distance - 1 : 1;
+					check.distance = left + 1;
 				}
-				else
+
+				/* the matrix is one iteration ahead, report its own residuum */
+				if (maxresiduum < options->term_precision || stagnated(&check, N))
 				{
-					++i, --j;
+					term_iteration = 0;
+					MPI_Allreduce(&residuum, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, cart);
 				}
 			}
-		}
 
-		if (options->termination == TERM_PREC || term_iteration == 1)
-		{
-			MPI_Allreduce(&maxresiduum, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+			/* every process starts it after the same iteration */
+			if (reduce && term_iteration > 0)
+			{
+				contribution = residuum;
+				MPI_Iallreduce(&contribution, &reduced, 1, MPI_DOUBLE, MPI_MAX, cart, &reduction);
+				pending = 1;
+				left = check.adaptive ? 2 : 1;
+			}
 		}
-
-		stat_iteration++;
-		/* check for stopping calculation depending on termination method */
-		if (options->termination == TERM_PREC)
+		else if (options->termination == TERM_PREC && --left == 0)
 		{
-			if (maxresiduum < options->term_precision)
-			{
+			left = nextCheck(&check, maxresiduum, options->term_precision);
+			if (maxresiduum < options->term_precision || stagnated(&check, N))
 				term_iteration = 0;
-			}
 		}
 		else if (options->termination == TERM_ITER)
-		{
 			term_iteration--;
-		}
+
+		/* all processes received the same decision */
+		if (checkpointDue() && term_iteration > 0)
+			saveCheckpoint(arguments, options, m2, stat_iteration, check.residuum, left, &check);
 	}
 
-	results->m = 0;
+	/* a checkpoint or the end of the iterations may leave one in flight */
+	if (pending)
+		MPI_Wait(&reduction, MPI_STATUS_IGNORE);
+
+	MPI_Type_free(&column);
+
+	results->m = m2;
 	results->stat_iteration = stat_iteration;
 	results->stat_precision = maxresiduum;
+	results->stat_checks    = check.checks;
+	results->stat_stalled   = stagnated(&check, N) ? check.stalled : 0;
 }
 
 /* ************************************************************************ */
-/* calculate_jacobi: solves the equation with Jacobi                        */
+/* calculate_red_black: solves the equation with red-black Gauß-Seidel      */
+/*                                                                          */
+/* Both half sweeps only read points of the other colour, so every process  */
+/* updates its lines independently and afterwards only exchanges the points */
+/* of the current colour in its first and last line with its neighbours.    */
 /* ************************************************************************ */
 static void
-calculate_jacobi(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+calculate_red_black(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
 {
-	uint64_t i, j;			      /* local variables for loops */
-	int m1, m2;			      /* used as indices for old and new matrices */
-	double star;		      /* four times center value minus 4 neigh.b values */
-	double residuum;	      /* residuum of current iteration */
-	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+	uint64_t i, j;                /* local variables for loops */
+	uint64_t send, recv;          /* offsets of the current colour in the exchanged lines */
+	int      colour;              /* 0: red, 1: black */
+	double   star;                /* four times center value minus 4 neigh.b values */
+	double   residuum;            /* residuum of current iteration */
+	double   maxresiduum = 0.0;   /* maximum residuum value of a slave in iteration */
+	int      residual;            /* whether the current iteration computes the residuum */
+	MPI_Datatype colour_line[2];  /* points of one colour in a line starting at column 1 or 2 */
 
 	uint64_t stat_iteration = 0;
 	uint64_t term_iteration = options->term_iteration;
@@ -523,80 +1724,116 @@ calculate_jacobi(struct calculation_arguments const* arguments, struct calculati
 	const int rank          = options->rank;
 	const int size          = options->size;
 
-	/* initialize m1 and m2 depending on algorithm */
-	if (options->method == METH_JACOBI)
-	{
-		m1 = 0;
-		m2 = 1;
-	}
-	else
-	{
-		m1 = 0;
-		m2 = 0;
-	}
+	/* N is even, so columns 1 .. N - 1 hold N / 2 odd and N / 2 - 1 even columns */
+	MPI_Type_vector(N / 2, 1, 2, MPI_MATRIX_TYPE, &colour_line[0]);
+	MPI_Type_vector(N / 2 - 1, 1, 2, MPI_MATRIX_TYPE, &colour_line[1]);
+	MPI_Type_commit(&colour_line[0]);
+	MPI_Type_commit(&colour_line[1]);
 
 	if (size - rank != 1)
 	{
 		++local_to;
 	}
 
-	typedef double(*matrix)[local_to + 1][N + 1];
+	typedef real(*matrix)[arguments->ld];
 	matrix Matrix = (matrix)arguments->M;
 
+	uint64_t                 left = 1; /* iterations until the next convergence check */
+	struct convergence_check check;    /* state of the convergence checks */
+
+	initCheck(&check, options, cos(M_PI / N) * cos(M_PI / N));
+
+	/* continue with the state of the checkpoint */
+	if (options->restart)
+	{
+		checkpoint.header.check.adaptive = check.adaptive;
+
+		check          = checkpoint.header.check;
+		stat_iteration = results->stat_iteration;
+		left           = (checkpoint.header.left > 0) ? checkpoint.header.left : 1;
+
+		if (options->termination == TERM_ITER)
+		{
+			term_iteration = (stat_iteration < term_iteration) ? term_iteration - stat_iteration : 0;
+		}
+	}
+
 	while (term_iteration > 0)
 	{
+		residual    = (options->termination == TERM_PREC && left == 1) || term_iteration == 1;
 		maxresiduum = 0.0;
 
-		/* over all rows */
-		for (i = 1, global_i = from; i < local_to; i++, global_i++)
+		announceCheckpoint(rank);
+
+		for (colour = 0; colour < 2; colour++)
 		{
-			/* over all columns */
-			for (j = 1; j < N; j++)
+			/* over all rows */
+			for (i = 1, global_i = from; i < local_to; i++, global_i++)
 			{
-				star = (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]) / 4;
-
-				star += calculate_func(arguments, options, global_i, j);
+				double const* f = rhsLine(arguments, global_i);
 
-				residuum = Matrix[m2][i][j] - star;
-				residuum = fabs(residuum);
-				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+				/* over all columns of the current colour */
+				for (j = 1 + (global_i + colour + 1) % 2; j < N; j += 2)
+				{
+					star = ((double)Matrix[i - 1][j] + Matrix[i][j - 1] + Matrix[i][j + 1] + Matrix[i + 1][j]) / 4;
 
-				Matrix[m1][i][j] = star;
-			}
-		}
+					star += f[j];
 
-		if (options->termination == TERM_PREC || term_iteration == 1)
-			MPI_Allreduce(&maxresiduum, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+					if (residual)
+					{
+						residuum = Matrix[i][j] - star;
+						residuum = fabs(residuum);
+						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+					}
 
-		if (size != 1)
-		{
-			if (rank != 0)
-			{
-				MPI_Sendrecv(&Matrix[m1][1][1], N - 1, MPI_DOUBLE, rank - 1, 0, &Matrix[m1][0][1], N - 1, MPI_DOUBLE, rank - 1, 255, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+					Matrix[i][j] = star;
+				}
 			}
-			if (size - rank != 1)
+
+			if (size != 1)
 			{
-				MPI_Sendrecv(&Matrix[m1][local_to - 1][1], N - 1, MPI_DOUBLE, rank + 1, 255, &Matrix[m1][local_to][1], N - 1, MPI_DOUBLE, rank + 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				if (rank != 0)
+				{
+					send = (from + colour + 1) % 2;
+					recv = (from + colour) % 2;
+					MPI_Sendrecv(&Matrix[1][1 + send], 1, colour_line[send], rank - 1, 0, &Matrix[0][1 + recv], 1, colour_line[recv], rank - 1, 255, cart, MPI_STATUS_IGNORE);
+				}
+				if (size - rank != 1)
+				{
+					send = (from + local_to + colour + 1) % 2;
+					recv = (from + local_to + colour) % 2;
+					MPI_Sendrecv(&Matrix[local_to - 1][1 + send], 1, colour_line[send], rank + 1, 255, &Matrix[local_to][1 + recv], 1, colour_line[recv], rank + 1, 0, cart, MPI_STATUS_IGNORE);
+				}
 			}
 		}
 
-		/* exchange m1 and m2 */
-		i = m1;
-		m1 = m2;
-		m2 = i;
+		if (residual)
+			MPI_Allreduce(MPI_IN_PLACE, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, cart);
+
 		stat_iteration++;
 		/* check for stopping calculation depending on termination method */
-		if (options->termination == TERM_PREC)
+		if (options->termination == TERM_PREC && --left == 0)
 		{
-			if (maxresiduum < options->term_precision)
+			left = nextCheck(&check, maxresiduum, options->term_precision);
+			if (maxresiduum < options->term_precision || stagnated(&check, N))
 				term_iteration = 0;
 		}
 		else if (options->termination == TERM_ITER)
 			term_iteration--;
+
+		/* all processes received the same decision */
+		if (checkpointDue() && term_iteration > 0)
+			saveCheckpoint(arguments, options, 0, stat_iteration, check.residuum, left, &check);
 	}
-	results->m = m2;
+
+	MPI_Type_free(&colour_line[0]);
+	MPI_Type_free(&colour_line[1]);
+
+	results->m = 0;
 	results->stat_iteration = stat_iteration;
 	results->stat_precision = maxresiduum;
+	results->stat_checks    = check.checks;
+	results->stat_stalled   = stagnated(&check, N) ? check.stalled : 0;
 }
 
 /* ************************************************************************ */
@@ -609,7 +1846,11 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
 
 	printf("Berechnungszeit:    %f s\n", time);
-	printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) * arguments->num_matrices / 1024.0 / 1024.0);
+	printf("Speicherbedarf:     %f MiB", (N + 1) * (N + 1) * sizeof(real) * arguments->num_matrices / 1024.0 / 1024.0);
+#ifdef FLOAT
+	printf(" (float)");
+#endif
+	printf("\n");
 	printf("Berechnungsmethode: ");
 
 	if (options->method == METH_GAUSS_SEIDEL)
@@ -619,9 +1860,24 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	else if (options->method == METH_JACOBI)
 	{
 		printf("Jacobi");
+
+		if (options->chebyshev)
+		{
+			printf(" (Chebyshev)");
+		}
+	}
+	else if (options->method == METH_RED_BLACK)
+	{
+		printf("Red-Black Gauß-Seidel");
 	}
 
 	printf("\n");
+
+	if (options->dims[1] != 1)
+	{
+		printf("Prozessgitter:      %d x %d\n", options->dims[0], options->dims[1]);
+	}
+
 	printf("Interlines:         %" PRIu64 "\n", options->interlines);
 	printf("Stoerfunktion:      ");
 
@@ -632,12 +1888,33 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	else if (options->inf_func == FUNC_FPISIN)
 	{
 		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+
+		/* only on request, the default output matches the reference */
+		if (getenv("PARTDIFF_RHS_BUDGET") != NULL)
+		{
+			if (arguments->rhs_mode == RHS_PLANE)
+			{
+				printf(" (Ebene)");
+			}
+			else if (arguments->rhs_mode == RHS_VECTORS)
+			{
+				printf(" (Vektoren)");
+			}
+			else
+			{
+				printf(" (Rekurrenz)");
+			}
+		}
 	}
 
 	printf("\n");
 	printf("Terminierung:       ");
 
-	if (options->termination == TERM_PREC)
+	if (options->termination == TERM_PREC && options->check == CHECK_ADAPTIVE)
+	{
+		printf("Hinreichende Genaugkeit (%" PRIu64 " Prüfungen)", results->stat_checks);
+	}
+	else if (options->termination == TERM_PREC)
 	{
 		printf("Hinreichende Genaugkeit");
 	}
@@ -646,8 +1923,19 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 		printf("Anzahl der Iterationen");
 	}
 
+	if (results->stat_stalled > 0)
+	{
+		printf(", abgebrochen: Residuum stagniert seit %" PRIu64 " Iterationen", results->stat_stalled);
+	}
+
 	printf("\n");
 	printf("Anzahl Iterationen: %" PRIu64 "\n", results->stat_iteration);
+
+	if (options->restart)
+	{
+		printf("Checkpoint:         fortgesetzt nach %" PRIu64 " Iterationen\n", checkpoint.restarted);
+	}
+
 	printf("Norm des Fehlers:   %e\n", results->stat_precision);
 	printf("\n");
 }
@@ -668,9 +1956,9 @@ displayMatrix(struct calculation_arguments* arguments, struct calculation_result
 	int x, y;
 
 	int const interlines = options->interlines;
-	int const N          = arguments->N;
+	int const ld         = arguments->ld;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	typedef real(*matrix)[arguments->local_to + 2][ld];
 
 	matrix Matrix = (matrix)arguments->M;
 
@@ -696,7 +1984,7 @@ displayMatrixMpi(struct calculation_arguments* arguments, struct calculation_res
 
 	int x, y;
 
-	typedef double(*matrix)[to - from + 3][arguments->N + 1];
+	typedef real(*matrix)[arguments->local_to + 2][arguments->ld];
 	matrix Matrix = (matrix)arguments->M;
 	int m = results->m;
 
@@ -727,7 +2015,7 @@ displayMatrixMpi(struct calculation_arguments* arguments, struct calculation_res
 			{
 				// Der Tag wird genutzt, um Zeilen in der richtigen Reihenfolge zu empfangen
 				// Matrix[m][0] wird überschrieben, da die Werte nicht mehr benötigt werden
-				MPI_Recv(Matrix[m][0], elements, MPI_DOUBLE, MPI_ANY_SOURCE, 42 + y, MPI_COMM_WORLD, &status);
+				MPI_Recv(Matrix[m][0], elements, MPI_MATRIX_TYPE, MPI_ANY_SOURCE, 42 + y, cart, &status);
 			}
 		}
 		else
@@ -736,7 +2024,7 @@ displayMatrixMpi(struct calculation_arguments* arguments, struct calculation_res
 			{
 				// Zeile an Rang 0 senden, wenn sie dem aktuellen Prozess gehört
 				// (line - from + 1) wird genutzt, um die lokale Zeile zu berechnen
-				MPI_Send(Matrix[m][line - from + 1], elements, MPI_DOUBLE, 0, 42 + y, MPI_COMM_WORLD);
+				MPI_Send(Matrix[m][line - from + 1], elements, MPI_MATRIX_TYPE, 0, 42 + y, cart);
 			}
 		}
 
@@ -765,6 +2053,68 @@ displayMatrixMpi(struct calculation_arguments* arguments, struct calculation_res
 	fflush(stdout);
 }
 
+/* ************************************************************************ */
+/* displayMatrixGrid: displays the matrix like displayMatrix when the       */
+/*                    processes own blocks of lines and columns             */
+/*                                                                          */
+/* Every process fills in the displayed points it owns, the processes at    */
+/* the edges of the grid also the border points, and leaves the others at   */
+/* 0. Every point has exactly one owner, so summing up at rank 0 gathers    */
+/* the exact values.                                                        */
+/* ************************************************************************ */
+static void
+displayMatrixGrid(struct calculation_arguments* arguments, struct calculation_results* results, struct options* options)
+{
+	int x, y;
+
+	real points[9][9]; /* the displayed points */
+
+	typedef real(*matrix)[arguments->local_to + 2][arguments->ld];
+	matrix Matrix = (matrix)arguments->M;
+
+	/* global lines and columns of this process, counting the borders to the edges of the grid */
+	int const first = (options->coords[0] == 0) ? 0 : arguments->from;
+	int const last  = arguments->from - 1 + arguments->local_to;
+	int const west  = (options->coords[1] == 0) ? 0 : arguments->col_from;
+	int const east  = arguments->col_from - 1 + arguments->local_cols;
+
+	for (y = 0; y < 9; y++)
+	{
+		int line = y * (options->interlines + 1);
+
+		for (x = 0; x < 9; x++)
+		{
+			int col = x * (options->interlines + 1);
+
+			points[y][x] = 0.0;
+
+			if (line >= first && line <= last && col >= west && col <= east)
+			{
+				points[y][x] = Matrix[results->m][line - arguments->from + 1][col - arguments->col_from + 1];
+			}
+		}
+	}
+
+	MPI_Reduce((options->rank == 0) ? MPI_IN_PLACE : points, points, 9 * 9, MPI_MATRIX_TYPE, MPI_SUM, 0, cart);
+
+	if (options->rank == 0)
+	{
+		printf("Matrix:\n");
+
+		for (y = 0; y < 9; y++)
+		{
+			for (x = 0; x < 9; x++)
+			{
+				printf("%7.4f", points[y][x]);
+			}
+
+			printf("\n");
+		}
+	}
+
+	fflush(stdout);
+}
+
 /* ************************************************************************ */
 /*  main                                                                    */
 /* ************************************************************************ */
@@ -781,11 +2131,14 @@ main(int argc, char** argv)
 	MPI_Comm_size(MPI_COMM_WORLD, &options.size);
 
 	askParams(&options, argc, argv);
+	initGrid(&options);
 
 	initVariables(&arguments, &results, &options);
 
 	allocateMatrices(&arguments);
 	initMatrices(&arguments, &options);
+	initRhs(&arguments, &options);
+	initCheckpoint(&arguments, &results, &options);
 
 	if (options.rank == 0)
 	{
@@ -796,6 +2149,10 @@ main(int argc, char** argv)
 	{
 		calculate_gauss_seidel(&arguments, &results, &options);
 	}
+	else if (options.method == METH_RED_BLACK)
+	{
+		calculate_red_black(&arguments, &results, &options);
+	}
 	else
 	{
 		calculate_jacobi(&arguments, &results, &options);
@@ -815,12 +2172,18 @@ main(int argc, char** argv)
 	{
 		displayMatrix(&arguments, &results, &options);
 	}
-	else
+	else if (options.dims[1] == 1)
 	{
 		displayMatrixMpi(&arguments, &results, &options, options.rank, options.size, arguments.from, arguments.to);
 	}
+	else
+	{
+		displayMatrixGrid(&arguments, &results, &options);
+	}
 
 	freeMatrices(&arguments);
+	free(checkpoint.temp);
+	MPI_Comm_free(&cart);
 
 	exit_success();
 }